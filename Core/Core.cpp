@@ -8,6 +8,10 @@
 
 #if !_WIN32
 #include <time.h>					// for Linux version of GetTickCount()
+#include <sys/mman.h>				// for mmap()
+#include <fcntl.h>					// for open()
+#include <unistd.h>					// for close(), fork(), execv()
+#include <sys/wait.h>				// for waitpid()
 #endif
 
 #if VSTUDIO_INTEGRATION
@@ -693,6 +697,106 @@ unsigned appGetFileType(const char *filename)
 	return 0;						// just in case ... (may be, win32 have other file types?)
 }
 
+bool appGetFileSizeAndTime(const char *filename, int64& outSize, int64& outModTime)
+{
+	struct stat buf;
+	if (stat(filename, &buf) == -1 || !S_ISREG(buf.st_mode))
+		return false;
+	outSize = buf.st_size;
+	outModTime = buf.st_mtime;
+	return true;
+}
+
+#if !_WIN32
+
+// Win32 versions are in CoreWin32.cpp
+bool appLinkFile(const char *src, const char *dst)
+{
+	return link(src, dst) == 0;
+}
+
+const void* appMapFile(const char *filename, int64& outSize)
+{
+	outSize = 0;
+	if (sizeof(void*) < 8) return NULL;	// not enough address space for large files
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) return NULL;
+
+	struct stat buf;
+	void* data = NULL;
+	if (fstat(fd, &buf) == 0 && buf.st_size > 0)
+	{
+		data = mmap(NULL, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			data = NULL;
+		}
+		else
+		{
+			outSize = buf.st_size;
+		}
+	}
+	// File mapping remains valid after closing the file
+	close(fd);
+	return data;
+}
+
+void appUnmapFile(const void* data, int64 size)
+{
+	if (data) munmap(const_cast<void*>(data), size);
+}
+
+bool appReadFileAt(FILE* f, int64 pos, void* data, int size)
+{
+	int fd = fileno(f);
+	while (size > 0)
+	{
+		ssize_t bytesRead = pread(fd, data, size, pos);
+		if (bytesRead <= 0) return false;
+		data = OffsetPointer(data, bytesRead);
+		size -= bytesRead;
+		pos += bytesRead;
+	}
+	return true;
+}
+
+address_t appStartProcess(int argc, const char* const* argv)
+{
+	// Prepare NULL-terminated argument list before fork(), so child will only call exec
+	const char** args = (const char**)malloc((argc + 1) * sizeof(const char*));
+	memcpy(args, argv, argc * sizeof(const char*));
+	args[argc] = NULL;
+
+	// Flush stdio buffers, so child won't inherit unwritten data
+	fflush(NULL);
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		// Child process
+		execv("/proc/self/exe", (char* const*)args);
+		execvp(argv[0], (char* const*)args);
+		_exit(127);
+	}
+	free(args);
+	return pid > 0 ? pid : 0;
+}
+
+int appWaitProcess(address_t process)
+{
+	int status;
+	if (waitpid((pid_t)process, &status, 0) < 0)
+		return -1;
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int appGetProcessId()
+{
+	return (int)getpid();
+}
+
+#endif // !_WIN32
+
 #if !_WIN32
 
 // POSIX version of GetTickCount()
@@ -336,6 +336,31 @@ void appParseResponseFile(const char* filename, int& outArgc, const char**& outA
 // and FS_DIR if this is a directory
 unsigned appGetFileType(const char *filename);
 
+// Get file size and modification time (in seconds). Returns false if file doesn't exist.
+bool appGetFileSizeAndTime(const char *filename, int64& outSize, int64& outModTime);
+
+// Create a hard link 'dst' pointing to the file 'src'. Returns false when not possible, for
+// example when file system doesn't support hard links, or files are on different volumes.
+bool appLinkFile(const char *src, const char *dst);
+
+// Map whole file into memory for reading. Returns NULL if file can't be mapped, for example when
+// it is empty, or when running 32-bit process. No file handles are held while file is mapped.
+const void* appMapFile(const char *filename, int64& outSize);
+void appUnmapFile(const void* data, int64 size);
+
+// Read data from the file at specified position without using stdio position and buffer, so
+// it could be called for the same file from multiple threads. Returns false on read error.
+// Note: on Windows, OS file pointer is changed, so stream should be seeked before next fread().
+bool appReadFileAt(FILE* f, int64 pos, void* data, int size);
+
+// Start a new instance of the current executable with provided command line (argv[0] is not used).
+// Returns process handle, or 0 when process couldn't be started.
+address_t appStartProcess(int argc, const char* const* argv);
+// Wait for completion of the process started with appStartProcess(), returns its exit code.
+int appWaitProcess(address_t process);
+// Return identifier of the current process.
+int appGetProcessId();
+
 
 // Memory management
 
@@ -9,6 +9,8 @@
 #include <float.h>					// for _clearfp()
 #endif // WIN32_USE_SEH
 
+#include <io.h>						// for _get_osfhandle()
+
 
 // Debugging options
 //#define USE_DBGHELP				1
@@ -526,6 +528,139 @@ void appCopyTextToClipboard(const char* text)
 #endif // HAS_UI
 }
 
+bool appLinkFile(const char *src, const char *dst)
+{
+	return CreateHardLinkA(dst, src, NULL) != FALSE;
+}
+
+const void* appMapFile(const char *filename, int64& outSize)
+{
+	outSize = 0;
+#ifdef _WIN64
+	HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return NULL;
+
+	const void* data = NULL;
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+	{
+		HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping)
+		{
+			data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+			if (data) outSize = size.QuadPart;
+			// The view holds a reference to the mapping object, so handles could be closed
+			CloseHandle(hMapping);
+		}
+	}
+	CloseHandle(hFile);
+	return data;
+#else
+	// 32-bit process doesn't have enough address space for large files
+	return NULL;
+#endif // _WIN64
+}
+
+void appUnmapFile(const void* data, int64 size)
+{
+	if (data) UnmapViewOfFile(data);
+}
+
+bool appReadFileAt(FILE* f, int64 pos, void* data, int size)
+{
+	HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(f));
+	while (size > 0)
+	{
+		// ReadFile with OVERLAPPED structure reads from the specified offset
+		OVERLAPPED ov;
+		memset(&ov, 0, sizeof(ov));
+		ov.Offset = (DWORD)pos;
+		ov.OffsetHigh = (DWORD)(pos >> 32);
+		DWORD bytesRead = 0;
+		if (!ReadFile(hFile, data, size, &bytesRead, &ov) || bytesRead == 0)
+			return false;
+		data = OffsetPointer(data, bytesRead);
+		size -= bytesRead;
+		pos += bytesRead;
+	}
+	return true;
+}
+
+address_t appStartProcess(int argc, const char* const* argv)
+{
+	char exeName[MAX_PATH];
+	if (!GetModuleFileNameA(NULL, ARRAY_ARG(exeName)))
+		return 0;
+
+	// Build command line, quote every argument using CommandLineToArgvW rules
+	static char cmdLine[32768];
+	char* d = cmdLine;
+	char* end = cmdLine + ARRAY_COUNT(cmdLine) - 4;
+	*d++ = '"';
+	for (const char* s = exeName; *s && d < end; s++)
+		*d++ = *s;
+	*d++ = '"';
+	for (int i = 1; i < argc; i++)
+	{
+		if (d >= end) return 0;
+		*d++ = ' ';
+		*d++ = '"';
+		int numSlashes = 0;
+		for (const char* s = argv[i]; *s && d < end; s++)
+		{
+			char c = *s;
+			if (c == '\\')
+			{
+				numSlashes++;
+			}
+			else
+			{
+				// backslashes before a quote should be doubled, and quote should be escaped
+				if (c == '"')
+				{
+					for (int j = 0; j <= numSlashes && d < end; j++)
+						*d++ = '\\';
+				}
+				numSlashes = 0;
+			}
+			*d++ = c;
+		}
+		// closing quote follows, so double trailing backslashes
+		for (int j = 0; j < numSlashes && d < end; j++)
+			*d++ = '\\';
+		if (d >= end) return 0;
+		*d++ = '"';
+	}
+	*d = 0;
+
+	// Keep the order of console output
+	fflush(NULL);
+
+	STARTUPINFOA si;
+	memset(&si, 0, sizeof(si));
+	si.cb = sizeof(si);
+	PROCESS_INFORMATION pi;
+	if (!CreateProcessA(exeName, cmdLine, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
+		return 0;
+	CloseHandle(pi.hThread);
+	return (address_t)pi.hProcess;
+}
+
+int appWaitProcess(address_t process)
+{
+	HANDLE hProcess = (HANDLE)process;
+	DWORD exitCode = (DWORD)-1;
+	if (WaitForSingleObject(hProcess, INFINITE) != WAIT_OBJECT_0 || !GetExitCodeProcess(hProcess, &exitCode))
+		exitCode = (DWORD)-1;
+	CloseHandle(hProcess);
+	return (int)exitCode;
+}
+
+int appGetProcessId()
+{
+	return (int)GetCurrentProcessId();
+}
+
 
 #if defined(OLDCRT) && (_MSC_VER  >= 1900)
 
@@ -0,0 +1,13 @@
+#ifndef __MATH_SSE2_H__
+#define __MATH_SSE2_H__
+
+// SSE2 is always available for x64, and for 32-bit builds when compiler targets it.
+// Code using SSE2 intrinsics should provide a scalar fallback for USE_SSE2 == 0.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define USE_SSE2					1
+#include <emmintrin.h>
+#else
+#define USE_SSE2					0
+#endif
+
+#endif // __MATH_SSE2_H__
@@ -357,7 +357,7 @@ void CMemoryChain::operator delete(void *ptr)
 	{
 		// free memory block
 		next = curr->next;
-		free(curr);				//!! deallocate
+		appFree(curr);			// allocated with appMalloc
 	}
 	unguard;
 }
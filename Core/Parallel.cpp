@@ -12,6 +12,7 @@
 #include "Parallel.h"
 
 bool GEnableThreads = true;
+int GMaxThreads = 0;		// limit for the number of threads used by the process, 0 = number of logical CPUs
 
 volatile int CThread::NumThreads = 0;
 
@@ -454,6 +455,7 @@ CPoolThread* AllocateFreeThread()
 	if (MaxThreads < 0)
 	{
 		MaxThreads = CThread::GetLogicalCPUCount();
+		if (GMaxThreads > 0) MaxThreads = min(MaxThreads, GMaxThreads);
 		MaxThreads = min(MaxThreads, MAX_POOL_THREADS);
 		--MaxThreads; // exclude main thread
 		if (!GEnableThreads) MaxThreads = 0;
@@ -562,11 +564,12 @@ void Shutdown()
 namespace ParallelForImpl
 {
 
-ParallelForBase::ParallelForBase(int inCount)
+ParallelForBase::ParallelForBase(int inCount, int inMinStep)
 : numActiveThreads(0)
 , bAllSentToThreads(false)
 , currentIndex(0)
 , lastIndex(inCount)
+, minStep(inMinStep > 0 ? inMinStep : 1)
 {}
 
 ParallelForBase::~ParallelForBase()
@@ -590,7 +593,7 @@ void ParallelForBase::Start(ThreadPool::ThreadTask worker)
 	int maxThreads = CThread::GetLogicalCPUCount();
 	int stepDivisor = maxThreads * 20;		// assume each thread will request for data 20 times
 	step = (lastIndex + stepDivisor - 1) / stepDivisor;
-	if (step < 20) step = 20; //?? should override for slow tasks, e.g. processing 10 items 1 second each
+	if (step < minStep) step = minStep; // slow tasks, e.g. processing 10 items 1 second each, are using small minStep
 
 	// Divide index count by 'step' with rounding up
 	int numThreads = (lastIndex + step - 1) / step;
@@ -340,8 +340,9 @@ public:
 	int currentIndex;
 	int lastIndex;
 	int step;
+	int minStep;
 
-	ParallelForBase(int inCount);
+	ParallelForBase(int inCount, int inMinStep);
 	~ParallelForBase();
 
 	void Start(::ThreadPool::ThreadTask worker);
@@ -355,8 +356,8 @@ class ParallelForWorker : public ParallelForBase
 public:
 	F Func;
 
-	ParallelForWorker(int InCount, F&& InFunc)
-	: ParallelForBase(InCount)
+	ParallelForWorker(int InCount, F&& InFunc, int InMinStep)
+	: ParallelForBase(InCount, InMinStep)
 	, Func(InFunc)
 	{
 		guard(ParallelFor);
@@ -414,10 +415,12 @@ public:
 
 } // namespace ParallelForImpl
 
+// MinStep is the smallest number of items passed to a single thread at once. Default value is good
+// for lightweight items, use smaller value for slow tasks (e.g. decompression of large data blocks).
 template<typename F>
-FORCEINLINE void ParallelFor(int Count, F&& Func)
+FORCEINLINE void ParallelFor(int Count, F&& Func, int MinStep = 20)
 {
-	ParallelForImpl::ParallelForWorker<F> Worker(Count, MoveTemp(Func));
+	ParallelForImpl::ParallelForWorker<F> Worker(Count, MoveTemp(Func), MinStep);
 }
 
 
@@ -446,7 +449,7 @@ FORCEINLINE T InterlockedAdd(T* Value, T2 Amount)
 }
 
 template<typename F>
-FORCEINLINE void ParallelFor(int Count, F&& Func)
+FORCEINLINE void ParallelFor(int Count, F&& Func, int MinStep = 20)
 {
 	for (int i = 0; i < Count; i++)
 		Func(i);
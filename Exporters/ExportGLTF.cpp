@@ -641,6 +641,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 	for (int SeqIndex = 0; SeqIndex < Anim->Sequences.Num(); SeqIndex++)
 	{
 		const CAnimSequence &Seq = *Anim->Sequences[SeqIndex];
+		const CAnimTrackData* Tracks = Seq.GetTracks();
 
 		Ar.Printf(
 			"    {\n"
@@ -658,7 +659,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 
 			int BoneNodeIndex;
 			ChannelType Type;
-			const CAnimTrack* Track;
+			const CAnimTrackData* Track;
 		};
 
 		TArray<AnimSampler> Samplers;
@@ -676,7 +677,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 			int MeshBoneIndex = AnimBones[BoneIndex];
 			int AnimBoneIndex = BoneMap[MeshBoneIndex];
 
-			const CAnimTrack* Track = Seq.Tracks[AnimBoneIndex];
+			const CAnimTrackData* Track = &Tracks[AnimBoneIndex];
 
 			int TranslationSamplerIndex = Samplers.Num();
 			AnimSampler* Sampler = new (Samplers) AnimSampler;
@@ -709,7 +710,7 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 			const AnimSampler& Sampler = Samplers[SamplerIndex];
 
 			// Prepare time array
-			const TArray<float>* TimeArray = (Sampler.Type == AnimSampler::TRANSLATION) ? &Sampler.Track->KeyPosTime : &Sampler.Track->KeyQuatTime;
+			const TAnimKeyArray<float>* TimeArray = (Sampler.Type == AnimSampler::TRANSLATION) ? &Sampler.Track->KeyPosTime : &Sampler.Track->KeyQuatTime;
 			if (TimeArray->Num() == 0)
 			{
 				// For this situation, use track's time array
@@ -791,6 +792,9 @@ static void ExportAnimations(GLTFExportContext& Context, FArchive& Ar)
 		Ar.Printf("      ]\n");
 
 		Ar.Printf("    }%s\n", SeqIndex == Anim->Sequences.Num()-1 ? "" : ",");
+
+		// all sequence data were copied to buffers, release decoded tracks
+		Seq.ReleaseTracks();
 	}
 
 	Ar.Printf("  ],\n");
@@ -104,7 +104,7 @@ void ExportMaterial(const UUnrealMaterial* Mat)
 		const UMaterialInstanceConstant* Inst = static_cast<const UMaterialInstanceConstant*>(Mat);
 		if (Inst->Parent)
 		{
-			ExportMaterial(Inst->Parent);
+			ExportObject(Inst->Parent);
 		}
 	}
 
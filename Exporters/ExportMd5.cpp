@@ -349,6 +349,11 @@ void ExportMd5Anim(const CAnimSet *Anim)
 		Ar->Printf("}\n\n");
 
 		// baseframe and frames
+		CAnimPoseSampler Sampler(S, numBones);
+		TArray<CVec3> BonePos;
+		TArray<CQuat> BoneQuat;
+		BonePos.SetNumUninitialized(numBones);
+		BoneQuat.SetNumUninitialized(numBones);
 		for (int Frame = -1; Frame < S.NumFrames; Frame++)
 		{
 			int t = Frame;
@@ -360,11 +365,11 @@ void ExportMd5Anim(const CAnimSet *Anim)
 			else
 				Ar->Printf("frame %d {\n", Frame);
 
+			Sampler.SamplePose(t, false, BonePos.GetData(), BoneQuat.GetData());
 			for (int b = 0; b < numBones; b++)
 			{
-				CVec3 BP;
-				CQuat BO;
-				S.Tracks[b]->GetBonePosition(t, S.NumFrames, false, BP, BO);
+				CVec3 BP = BonePos[b];
+				CQuat BO = BoneQuat[b];
 				if (!b) BO.Conjugate();			// root bone
 #if MIRROR_MESH
 				BO.y  *= -1;
@@ -379,6 +384,7 @@ void ExportMd5Anim(const CAnimSet *Anim)
 			}
 			Ar->Printf("}\n\n");
 		}
+		S.ReleaseTracks();
 
 		delete Ar;
 	}
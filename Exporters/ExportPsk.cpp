@@ -588,43 +588,57 @@ void ExportPsa(const CAnimSet *Anim)
 	{
 		guard(Sequence);
 		const CAnimSequence &S = *Anim->Sequences[i];
+		const CAnimTrackData* Tracks = S.GetTracks();
+		// check for user error
+		for (int b = 0; b < numBones; b++)
+		{
+			if ((Tracks[b].KeyPos.Num() == 0) || (Tracks[b].KeyQuat.Num() == 0))
+				requireConfig = true;
+		}
+		// sample all bones of a frame at once
+		CAnimPoseSampler Sampler(S, numBones);
+		TArray<CVec3> BonePos;
+		TArray<CQuat> BoneQuat;
+		TArray<VQuatAnimKey> Keys;
+		BonePos.SetNumUninitialized(numBones);
+		BoneQuat.SetNumUninitialized(numBones);
+		Keys.SetNumUninitialized(numBones);
 		for (int t = 0; t < S.NumFrames; t++)
 		{
 			for (int b = 0; b < numBones; b++)
 			{
-				VQuatAnimKey K;
-				CVec3 BP;
-				CQuat BO;
-
-				BP.Set(0, 0, 0);			// GetBonePosition() will not alter BP and BO when animation tracks are not exists
-				BO.Set(0, 0, 0, 1);
-				S.Tracks[b]->GetBonePosition(t, S.NumFrames, false, BP, BO);
+				BonePos[b].Set(0, 0, 0);	// SamplePose() will not alter position and rotation when animation tracks are not exists
+				BoneQuat[b].Set(0, 0, 0, 1);
+			}
+			Sampler.SamplePose(t, false, BonePos.GetData(), BoneQuat.GetData());
 
-				K.Position    = (FVector&) BP;
-				K.Orientation = (FQuat&)   BO;
+			for (int b = 0; b < numBones; b++)
+			{
+				VQuatAnimKey& K = Keys[b];
+				K.Position    = (FVector&) BonePos[b];
+				K.Orientation = (FQuat&)   BoneQuat[b];
 				K.Time        = 1;
 #if MIRROR_MESH
 				K.Orientation.Y *= -1;
 				K.Orientation.W *= -1;
 				K.Position.Y    *= -1;
 #endif
+			}
 
-				if (sizeof(VQuatAnimKey) == sizeof(float) * 8)
-				{
-					// Packed structure, serialize with a single call
-					Ar.Serialize(&K, sizeof(K));
-				}
-				else
-				{
-					Ar << K;
-				}
-				keysCount--;
-
-				// check for user error
-				if ((S.Tracks[b]->KeyPos.Num() == 0) || (S.Tracks[b]->KeyQuat.Num() == 0))
-					requireConfig = true;
+			if (sizeof(VQuatAnimKey) == sizeof(float) * 8)
+			{
+				// Packed structure, serialize whole frame with a single call
+				Ar.Serialize(Keys.GetData(), numBones * sizeof(VQuatAnimKey));
+			}
+			else
+			{
+				for (int b = 0; b < numBones; b++)
+					Ar << Keys[b];
 			}
+			keysCount -= numBones;
 		}
+		// sequences are processed one by one, don't keep decoded tracks in memory
+		S.ReleaseTracks();
 		unguard;
 	}
 	assert(keysCount == 0);
@@ -666,19 +680,21 @@ void ExportPsa(const CAnimSet *Anim)
 		for (i = 0; i < numAnims; i++)
 		{
 			const CAnimSequence &S = *Anim->Sequences[i];
+			const CAnimTrackData* Tracks = S.GetTracks();
 			for (int b = 0; b < numBones; b++)
 			{
 #define FLAG_NO_TRANSLATION		1
 #define FLAG_NO_ROTATION		2
 				static const char *FlagInfo[] = { "", "trans", "rot", "all" };
 				int flag = 0;
-				if (S.Tracks[b]->KeyPos.Num() == 0)
+				if (Tracks[b].KeyPos.Num() == 0)
 					flag |= FLAG_NO_TRANSLATION;
-				if (S.Tracks[b]->KeyQuat.Num() == 0)
+				if (Tracks[b].KeyQuat.Num() == 0)
 					flag |= FLAG_NO_ROTATION;
 				if (flag)
 					Ar1->Printf("%s.%d=%s\n", *S.Name, b, FlagInfo[flag]);
 			}
+			S.ReleaseTracks();
 		}
 	}
 
@@ -44,65 +44,39 @@ struct GCC_PACK tgaHdr_t
 bool GNoTgaCompress = false;
 bool GExportPNG = false;
 bool GExportDDS = false;
+byte GPngCompression = PNG_COMPRESS_DEFAULT;
+int  GExportTextureMip = 0;
+int  GExportTextureMaxSize = 0;
 
 //?? place this function outside (cannot place to Core - using FArchive)
 
-void WriteTGA(FArchive &Ar, int width, int height, byte *pic)
+// Encode a single image row with RLE, packets never cross row boundary. Pixels are converted
+// from RGBA to BGR(A) format. Returns number of bytes written to 'dst', which should have space
+// for at least width * (colorBytes + 1) bytes.
+static int EncodeTGARow(const byte* src, int width, int colorBytes, byte* dst)
 {
-	guard(WriteTGA);
-
-	int		i;
-
-	byte *src;
-	int size = width * height;
-	// convert RGB to BGR (inplace!)
-	for (i = 0, src = pic; i < size; i++, src += 4)
-		Exchange(src[0], src[2]);
-
-	// check for 24 bit image possibility
-	int colorBytes = 3;
-	for (i = 0, src = pic + 3; i < size; i++, src += 4)
-		if (src[0] != 255)									// src initialized with offset 3
-		{
-			colorBytes = 4;
-			break;
-		}
-
-	byte *packed = (byte*)appMalloc(width * height * colorBytes + 4); // +4 for being able to put uint32 even when 3 bytes needed
-	byte *threshold = packed + width * height * colorBytes - 16; // threshold for "dst"
-
-	src = pic;
-	byte *dst = packed;
-	int column = 0;
+	byte *start = dst;
 	byte *flag = NULL;
 	bool rle = false;
 
-	bool useCompression = true;
-	if (GNoTgaCompress)
-		threshold = dst;									// will break compression loop immediately
-
-	for (i = 0; i < size; i++)
+	for (int column = 0; column < width; column++, src += 4)
 	{
-		if (dst >= threshold)								// when compressed is too large, same uncompressed
-		{
-			useCompression = false;
-			break;
-		}
+		uint32 pix = *(const uint32*)src;
 
-		uint32 pix = *(uint32*)src;
-		src += 4;
-
-		if (column < width - 1 &&							// not on screen edge; NOTE: when i == size-1, col==width-1
-			pix == *(uint32*)src &&							// next pixel will be the same
-			!(rle && flag && *flag == 254))					// flag overflow
+		if (column < width - 1 &&							// not on screen edge
+			pix == *(const uint32*)(src + 4) &&				// next pixel will be the same
+			!(rle && *flag == 254))							// flag overflow
 		{
-			if (!rle || !flag)
+			if (!rle)
 			{
 				// starting new RLE sequence
 				flag = dst++;
 				*flag = 128 - 1;							// will be incremented below
-				*(uint32*)dst = pix;						// store RGBA
-				dst += colorBytes;							// increment dst by 3 or 4 bytes
+				dst[0] = src[2];							// store BGR(A)
+				dst[1] = src[1];
+				dst[2] = src[0];
+				if (colorBytes == 4) dst[3] = src[3];
+				dst += colorBytes;
 			}
 			(*flag)++;										// enqueue one more texel
 			rle = true;
@@ -118,163 +92,376 @@ void WriteTGA(FArchive &Ar, int width, int height, byte *pic)
 			}
 			else
 			{
-				if (column == 0)							// check for screen edge
-					flag = NULL;
 				if (!flag)
 				{
 					// start new copy sequence
 					flag = dst++;
 					*flag = 255;
 				}
-				*(uint32*)dst = pix;						// store RGBA
-				dst += colorBytes;							// increment dst by 3 or 4 bytes
+				dst[0] = src[2];							// store BGR(A)
+				dst[1] = src[1];
+				dst[2] = src[0];
+				if (colorBytes == 4) dst[3] = src[3];
+				dst += colorBytes;
 				(*flag)++;
 				if (*flag == 127) flag = NULL;				// check for overflow
 			}
 			rle = false;
 		}
-
-		if (++column == width) column = 0;
 	}
 
+	return dst - start;
+}
+
+// Image is written row by row, so memory usage doesn't depend on image height, and source
+// image is not modified. When 'flip' is set, rows are taken in bottom-to-top order.
+void WriteTGA(FArchive &Ar, int width, int height, const byte *pic, bool flip)
+{
+	guard(WriteTGA);
+
+	int		i, y;
+
+	const byte *src;
+	int size = width * height;
+
+	// check for 24 bit image possibility
+	int colorBytes = 3;
+	for (i = 0, src = pic + 3; i < size; i++, src += 4)
+		if (src[0] != 255)									// src initialized with offset 3
+		{
+			colorBytes = 4;
+			break;
+		}
+
+	// buffer for a single row, large enough for worst RLE case
+	byte *row = (byte*)appMallocNoInit(width * (colorBytes + 1));
+
 	// write header
+	bool useCompression = !GNoTgaCompress;
+	int headerPos = Ar.Tell();
 	tgaHdr_t header;
 	memset(&header, 0, sizeof(header));
 	header.width  = width;
 	header.height = height;
-#if 0
-	// debug: write black/white image
-	header.pixel_size = 8;
-	header.image_type = 3;
-	fwrite(&header, 1, sizeof(header), f);
-	for (i = 0; i < width * height; i++, pic += 4)
-	{
-		int c = (pic[0]+pic[1]+pic[2]) / 3;
-		fwrite(&c, 1, 1, f);
-	}
-#else
 	header.pixel_size = colorBytes * 8;
 #if TGA_SAVE_BOTTOMLEFT
 	header.attributes = TGA_BOTLEFT;
 #else
 	header.attributes = TGA_TOPLEFT;
 #endif
+	header.image_type = useCompression ? 10 : 2;		// RLE or uncompressed
+	Ar.Serialize(&header, sizeof(header));
+
+	// Write compressed data. When compressed data becomes too large, seek back and save the image
+	// uncompressed. A row is written only when the data stays below the threshold, so uncompressed
+	// data overwrites everything written before.
 	if (useCompression)
 	{
-		header.image_type = 10;		// RLE
-		// write data
-		Ar.Serialize(&header, sizeof(header));
-		Ar.Serialize(packed, dst - packed);
+		int64 threshold = (int64)size * colorBytes - 16;
+		int64 packedSize = 0;
+		for (y = 0; y < height; y++)
+		{
+			src = pic + (flip ? height - 1 - y : y) * width * 4;
+			int rowSize = EncodeTGARow(src, width, colorBytes, row);
+			packedSize += rowSize;
+			if (packedSize >= threshold)
+			{
+				useCompression = false;
+				break;
+			}
+			Ar.Serialize(row, rowSize);
+		}
+		if (!useCompression)
+		{
+			header.image_type = 2;
+			Ar.Seek(headerPos);
+			Ar.Serialize(&header, sizeof(header));
+		}
 	}
-	else
+
+	// write uncompressed data
+	if (!useCompression)
 	{
-		header.image_type = 2;		// uncompressed
-		// convert to 24 bits image, when needed
-		if (colorBytes == 3)
+		for (y = 0; y < height; y++)
 		{
-			// Use uint32 for faster data moving
-			dst = pic;
-			uint32* src = (uint32*)pic;
-			for (i = 0; i < size; i++)
+			src = pic + (flip ? height - 1 - y : y) * width * 4;
+			// convert RGBA to BGR(A)
+			byte *dst = row;
+			for (i = 0; i < width; i++, src += 4, dst += colorBytes)
 			{
-				uint32 pix = *src++;
-				*((uint32*)dst) = pix;
-				dst += 3;	// increment 'dst' only by 3
+				dst[0] = src[2];
+				dst[1] = src[1];
+				dst[2] = src[0];
+				if (colorBytes == 4) dst[3] = src[3];
 			}
+			Ar.Serialize(row, width * colorBytes);
 		}
-		// write data
-		Ar.Serialize(&header, sizeof(header));
-		Ar.Serialize(pic, size * colorBytes);
 	}
-#endif
 
-	appFree(packed);
+	appFree(row);
 
 	unguard;
 }
 
 // Radiance file format
 
-static void float2rgbe(float red, float green, float blue, byte* rgbe)
-{
-	float v;
-	int e;
-	v = red;
-	if (green > v) v = green;
-	if (blue > v) v = blue;
-	if (v < 1e-32)
-	{
-		rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
-	}
-	else
-	{
-		v = frexp(v, &e) * 256.0f / v; //?? TODO: check if frexp is slow and could be optimized
-		rgbe[0] = byte(red * v);
-		rgbe[1] = byte(green * v);
-		rgbe[2] = byte(blue * v);
-		rgbe[3] = byte(e + 128);
-	}
-}
-
-static void WriteHDR(FArchive &Ar, int width, int height, byte *pic)
+static void WriteHDR(FArchive &Ar, int width, int height, const byte *pic)
 {
 	guard(WriteHDR);
 
 	char hdr[64];
 	appSprintf(ARRAY_ARG(hdr), "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
 
+	Ar.Serialize(hdr, strlen(hdr));
+
 	//!! TODO: compress HDR file (seems have RLE support)
-	// Convert float[w*h*4] to rgbe[w*h] inplace
-	const float* floatSrc = (float*)pic;
-	byte* byteDst = pic;
-	for (int p = 0; p < width * height; p++, floatSrc += 4, byteDst += 4)
+	// Convert float[w*h*4] to rgbe[w*h] row by row
+	byte* row = (byte*)appMallocNoInit(width * 4);
+	const float* floatSrc = (const float*)pic;
+	for (int y = 0; y < height; y++, floatSrc += width * 4)
 	{
-		float2rgbe(floatSrc[0], floatSrc[1], floatSrc[2], byteDst);
+		ConvertFloatToRGBE(floatSrc, row, width);
+		Ar.Serialize(row, width * 4);
 	}
-
-	Ar.Serialize(hdr, strlen(hdr));
-	Ar.Serialize(pic, width * height * 4);
+	appFree(row);
 
 	unguard;
 }
 
 
-static void WriteDDS(FArchive& Ar, const CTextureData& TexData, int Slice)
+/*-----------------------------------------------------------------------------
+	Compressed texture export (DDS and KTX)
+	Data is written exactly as it stored in the texture, without decompression.
+-----------------------------------------------------------------------------*/
+
+#define DXGI_FORMAT_BC6H_UF16		95
+#define DXGI_FORMAT_BC7_UNORM		98
+
+// DXGI format for DDS files with DX10 header, used for formats without FourCC code
+static unsigned GetDXGIFormat(ETexturePixelFormat Format)
 {
-	guard(WriteDDS);
+	switch (Format)
+	{
+	case TPF_BC6H:
+		return DXGI_FORMAT_BC6H_UF16;
+	case TPF_BC7:
+		return DXGI_FORMAT_BC7_UNORM;
+	default:
+		return 0;
+	}
+}
 
-	if (!TexData.Mips.Num()) return;
-	const CMipMap& Mip = TexData.Mips[0];
+#define GL_RGB								0x1907
+#define GL_RGBA								0x1908
+#define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG	0x8C02
+#define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG	0x8C03
+#define GL_ETC1_RGB8_OES					0x8D64
+#define GL_COMPRESSED_RGB8_ETC2				0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC		0x9278
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR		0x93B0
+#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR		0x93B4
+#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR		0x93B7
+#define GL_COMPRESSED_RGBA_ASTC_10x10_KHR	0x93BB
+#define GL_COMPRESSED_RGBA_ASTC_12x12_KHR	0x93BD
+
+// OpenGL internal format for KTX files, used for mobile formats
+static unsigned GetKTXFormat(ETexturePixelFormat Format)
+{
+	switch (Format)
+	{
+#if SUPPORT_IPHONE
+	case TPF_PVRTC2:
+		return GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG;
+	case TPF_PVRTC4:
+		return GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG;
+#endif
+#if SUPPORT_ANDROID
+	case TPF_ETC1:
+		return GL_ETC1_RGB8_OES;
+	case TPF_ETC2_RGB:
+		return GL_COMPRESSED_RGB8_ETC2;
+	case TPF_ETC2_RGBA:
+		return GL_COMPRESSED_RGBA8_ETC2_EAC;
+	case TPF_ASTC_4x4:
+		return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+	case TPF_ASTC_6x6:
+		return GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+	case TPF_ASTC_8x8:
+		return GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+	case TPF_ASTC_10x10:
+		return GL_COMPRESSED_RGBA_ASTC_10x10_KHR;
+	case TPF_ASTC_12x12:
+		return GL_COMPRESSED_RGBA_ASTC_12x12_KHR;
+#endif
+	default:
+		return 0;
+	}
+}
 
-	unsigned fourCC = TexData.GetFourCC();
+// Size of compressed data for a single slice of the mip level
+static int GetMipSliceSize(ETexturePixelFormat Format, int USize, int VSize)
+{
+	const CPixelFormatInfo& Info = PixelFormatInfo[Format];
+	int NumBlocksX = (USize + Info.BlockSizeX - 1) / Info.BlockSizeX;
+	int NumBlocksY = (VSize + Info.BlockSizeY - 1) / Info.BlockSizeY;
+#if SUPPORT_IPHONE
+	if (Format == TPF_PVRTC2 || Format == TPF_PVRTC4)
+	{
+		// PVRTC image has at least 2x2 blocks
+		NumBlocksX = max(NumBlocksX, 2);
+		NumBlocksY = max(NumBlocksY, 2);
+	}
+#endif
+	return NumBlocksX * NumBlocksY * Info.BytesPerBlock;
+}
 
-	// code from CTextureData::Decompress()
-	if (!fourCC)
-		appError("unknown texture format %d \n", TexData.Format);	// should not happen - IsDXT() should not pass execution here
+// Count mips which could be exported: they should form a complete mip chain, and
+// should have data for all slices. The first mip is always exported.
+static int GetExportMipCount(const CTextureData& TexData, int NumSlices)
+{
+	int MipCount = 1;
+	for ( ; MipCount < TexData.Mips.Num(); MipCount++)
+	{
+		const CMipMap& Prev = TexData.Mips[MipCount - 1];
+		const CMipMap& Mip = TexData.Mips[MipCount];
+		if (Mip.USize != max(Prev.USize / 2, 1) || Mip.VSize != max(Prev.VSize / 2, 1))
+			break;
+		if (!Mip.CompressedData || Mip.DataSize / NumSlices < GetMipSliceSize(TexData.Format, Mip.USize, Mip.VSize))
+			break;
+	}
+	return MipCount;
+}
 
+static void WriteMipSlice(FArchive& Ar, const CTextureData& TexData, int MipLevel, int Slice)
+{
+	const CMipMap& Mip = TexData.Mips[MipLevel];
 	int DataSize = Mip.DataSize;
 	const byte* DataPtr = Mip.CompressedData;
 	if (Slice >= 0)
 	{
+		// 6 slices in UE4 follows each other in memory
 		DataSize /= 6;
 		DataPtr += Slice * DataSize;
 	}
+	// Mip could have padding after the image data, don't write it. Only the first mip could
+	// have not enough data, see GetExportMipCount(). Pad it with zeros, so the file has exactly
+	// the size declared in DDS and KTX headers.
+	int SliceSize = GetMipSliceSize(TexData.Format, Mip.USize, Mip.VSize);
+	Ar.Serialize(const_cast<byte*>(DataPtr), min(DataSize, SliceSize));
+	if (DataSize < SliceSize)
+	{
+		byte Zero[4096];
+		memset(Zero, 0, sizeof(Zero));
+		for (int Size = SliceSize - DataSize; Size > 0; /* empty */)
+		{
+			int Count = min(Size, (int)sizeof(Zero));
+			Ar.Serialize(Zero, Count);
+			Size -= Count;
+		}
+	}
+}
+
+static void WriteDDS(FArchive& Ar, const CTextureData& TexData, int Slice)
+{
+	guard(WriteDDS);
+
+	if (!TexData.Mips.Num()) return;
+	const CMipMap& Mip = TexData.Mips[0];
+	int MipCount = GetExportMipCount(TexData, Slice >= 0 ? 6 : 1);
 
 	nv::DDSHeader header;
-	header.setFourCC(fourCC & 0xFF, (fourCC >> 8) & 0xFF, (fourCC >> 16) & 0xFF, (fourCC >> 24) & 0xFF);
+	unsigned fourCC = TexData.GetFourCC();
+	if (fourCC)
+	{
+		header.setFourCC(fourCC & 0xFF, (fourCC >> 8) & 0xFF, (fourCC >> 16) & 0xFF, (fourCC >> 24) & 0xFF);
+	}
+	else
+	{
+		unsigned dxgiFormat = GetDXGIFormat(TexData.Format);
+		if (!dxgiFormat)
+			appError("unknown texture format %d \n", TexData.Format);	// should not happen - Setup() should not pass execution here
+		header.setFourCC('D', 'X', '1', '0');
+		header.setDX10Format(dxgiFormat);
+		header.setTexture2D();
+		header.header10.arraySize = 1;
+	}
 //	header.setPixelFormat(32, 0xFF, 0xFF << 8, 0xFF << 16, 0xFF << 24);	// bit count and per-channel masks
 	//!! Note: should use setFourCC for compressed formats, and setPixelFormat for uncompressed - these functions are
 	//!! incompatible. When fourcc is used, color masks are zero, and vice versa.
 	header.setWidth(Mip.USize);
 	header.setHeight(Mip.VSize);
+	header.setMipmapCount(MipCount);
 //	header.setNormalFlag(TexData.Format == TPF_DXT5N || TexData.Format == TPF_3DC); -- required for decompression only
-	header.setLinearSize(DataSize);
+	header.setLinearSize(GetMipSliceSize(TexData.Format, Mip.USize, Mip.VSize));
 
-	byte headerBuffer[128];							// DDS header is 128 bytes long
-	memset(headerBuffer, 0, 128);
+	byte headerBuffer[148];							// DDS header is 128 bytes long, plus 20 bytes of DX10 header
+	memset(headerBuffer, 0, sizeof(headerBuffer));
 	WriteDDSHeader(headerBuffer, header);
-	Ar.Serialize(headerBuffer, 128);
-	Ar.Serialize(const_cast<byte*>(DataPtr), DataSize);
+	Ar.Serialize(headerBuffer, header.hasDX10Header() ? 148 : 128);
+
+	for (int MipLevel = 0; MipLevel < MipCount; MipLevel++)
+	{
+		WriteMipSlice(Ar, TexData, MipLevel, Slice);
+	}
+
+	unguard;
+}
+
+struct KTXHeader
+{
+	byte		Identifier[12];
+	uint32		Endianness;
+	uint32		glType;
+	uint32		glTypeSize;
+	uint32		glFormat;
+	uint32		glInternalFormat;
+	uint32		glBaseInternalFormat;
+	uint32		PixelWidth;
+	uint32		PixelHeight;
+	uint32		PixelDepth;
+	uint32		NumberOfArrayElements;
+	uint32		NumberOfFaces;
+	uint32		NumberOfMipmapLevels;
+	uint32		BytesOfKeyValueData;
+};
+
+static void WriteKTX(FArchive& Ar, const CTextureData& TexData, int Slice)
+{
+	guard(WriteKTX);
+
+	static const byte KTXIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	if (!TexData.Mips.Num()) return;
+	const CMipMap& Mip = TexData.Mips[0];
+	int MipCount = GetExportMipCount(TexData, Slice >= 0 ? 6 : 1);
+
+	KTXHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.Identifier, KTXIdentifier, sizeof(KTXIdentifier));
+	header.Endianness = 0x04030201;
+	header.glTypeSize = 1;				// glType and glFormat are 0 for compressed textures
+	header.glInternalFormat = GetKTXFormat(TexData.Format);
+	if (!header.glInternalFormat)
+		appError("unknown texture format %d \n", TexData.Format);	// should not happen - Setup() should not pass execution here
+#if SUPPORT_ANDROID
+	header.glBaseInternalFormat = (TexData.Format == TPF_ETC1 || TexData.Format == TPF_ETC2_RGB) ? GL_RGB : GL_RGBA;
+#else
+	header.glBaseInternalFormat = GL_RGBA;
+#endif
+	header.PixelWidth = Mip.USize;
+	header.PixelHeight = Mip.VSize;
+	header.NumberOfFaces = 1;
+	header.NumberOfMipmapLevels = MipCount;
+	Ar.Serialize(&header, sizeof(header));
+
+	for (int MipLevel = 0; MipLevel < MipCount; MipLevel++)
+	{
+		// All block sizes are multiple of 4, so no mip padding is required
+		const CMipMap& CurMip = TexData.Mips[MipLevel];
+		int32 ImageSize = GetMipSliceSize(TexData.Format, CurMip.USize, CurMip.VSize);
+		Ar << ImageSize;
+		WriteMipSlice(Ar, TexData, MipLevel, Slice);
+	}
 
 	unguard;
 }
@@ -284,6 +471,11 @@ static void ExportDDS_Worker(FArchive& Ar, CTextureData& TexData, byte* /*pic*/,
 	WriteDDS(Ar, TexData, Slice);
 }
 
+static void ExportKTX_Worker(FArchive& Ar, CTextureData& TexData, byte* /*pic*/, int Slice)
+{
+	WriteKTX(Ar, TexData, Slice);
+}
+
 static void ExportHDR_Worker(FArchive& Ar, CTextureData& TexData, byte* pic, int /*Slice*/)
 {
 	WriteHDR(Ar, TexData.Mips[0].USize, TexData.Mips[0].VSize, pic);
@@ -292,7 +484,7 @@ static void ExportHDR_Worker(FArchive& Ar, CTextureData& TexData, byte* pic, int
 static void ExportPNG_Worker(FArchive& Ar, CTextureData& TexData, byte* pic, int /*Slice*/)
 {
 	TArray<byte> Data;
-	CompressPNG(pic, TexData.Mips[0].USize, TexData.Mips[0].VSize, Data);
+	CompressPNG(pic, TexData.Mips[0].USize, TexData.Mips[0].VSize, Data, GPngCompression);
 	Ar.Serialize(Data.GetData(), Data.Num());
 }
 
@@ -303,15 +495,92 @@ static void ExportTGA_Worker(FArchive& Ar, CTextureData& TexData, byte* pic, int
 #if TGA_SAVE_BOTTOMLEFT
 	// flip image vertically (UnrealEd for UE2 have a bug with importing TGA_TOPLEFT images,
 	// it simply ignores orientation flags)
-	for (int i = 0; i < height / 2; i++)
+	WriteTGA(Ar, width, height, pic, true);
+#else
+	WriteTGA(Ar, width, height, pic);
+#endif // TGA_SAVE_BOTTOMLEFT
+}
+
+/*-----------------------------------------------------------------------------
+	Texture export memory management
+-----------------------------------------------------------------------------*/
+
+// Maximal amount of memory held by texture export tasks queued to the thread pool (copies of
+// texture data and decompressed images). When exceeded, texture is exported in the caller's thread.
+#define TEXTURE_EXPORT_MEMORY_BUDGET	(512 << 20)
+// Decompression buffers larger than this size are released after use instead of being reused
+#define TEXTURE_SCRATCH_KEEP_SIZE		(64 << 20)
+
+struct CTextureScratchBuffer
+{
+	byte*		Data;
+	int			Size;
+	bool		bInUse;
+};
+
+// Decompression buffers are reused by subsequent exports, so the number of allocated buffers
+// never exceeds the number of textures exported at the same time
+static TArray<CTextureScratchBuffer> GTextureScratchBuffers;
+
+#if THREADING
+static CMutex TextureScratchMutex;
+static volatile int32 GTextureExportMemoryKB = 0;
+#endif
+
+static byte* AllocTextureScratch(int Size)
+{
+#if THREADING
+	CMutex::ScopedLock Lock(TextureScratchMutex);
+#endif
+
+	// Find the smallest free buffer which fits the data, or any free buffer for reallocation
+	CTextureScratchBuffer* Found = NULL;
+	for (CTextureScratchBuffer& Buf : GTextureScratchBuffers)
 	{
-		uint32 *p1 = (uint32*)(pic + width * 4 * i);
-		uint32 *p2 = (uint32*)(pic + width * 4 * (height - i - 1));
-		for (int j = 0; j < width; j++)
-			Exchange(*p1++, *p2++);
+		if (Buf.bInUse) continue;
+		if (!Found ||
+			(Buf.Size >= Size && (Found->Size < Size || Buf.Size < Found->Size)))
+		{
+			Found = &Buf;
+		}
 	}
-#endif // TGA_SAVE_BOTTOMLEFT
-	WriteTGA(Ar, width, height, pic);
+	if (!Found)
+	{
+		Found = &GTextureScratchBuffers[GTextureScratchBuffers.AddZeroed()];
+	}
+	if (Found->Size < Size)
+	{
+		// Previous contents is not needed, so don't use realloc
+		if (Found->Data) appFree(Found->Data);
+		Found->Data = (byte*)appMallocNoInit(Size);
+		Found->Size = Size;
+	}
+	Found->bInUse = true;
+	return Found->Data;
+}
+
+static void ReleaseTextureScratch(byte* Data)
+{
+#if THREADING
+	CMutex::ScopedLock Lock(TextureScratchMutex);
+#endif
+
+	for (int i = 0; i < GTextureScratchBuffers.Num(); i++)
+	{
+		CTextureScratchBuffer& Buf = GTextureScratchBuffers[i];
+		if (Buf.Data != Data) continue;
+		if (Buf.Size > TEXTURE_SCRATCH_KEEP_SIZE)
+		{
+			appFree(Buf.Data);
+			GTextureScratchBuffers.RemoveAt(i);
+		}
+		else
+		{
+			Buf.bInUse = false;
+		}
+		return;
+	}
+	assert(0);
 }
 
 struct CTextureExportWorker
@@ -327,6 +596,11 @@ struct CTextureExportWorker
 	FString ExportPath;
 	FString ExportExt;
 
+#if THREADING
+	// Amount of memory accounted in GTextureExportMemoryKB for this worker
+	int32 ReservedMemoryKB = 0;
+#endif
+
 	FORCEINLINE CTextureExportWorker()
 	{}
 
@@ -340,6 +614,25 @@ struct CTextureExportWorker
 	~CTextureExportWorker()
 	{
 		assert(!Ar);
+#if THREADING
+		if (ReservedMemoryKB)
+			InterlockedAdd(&GTextureExportMemoryKB, -ReservedMemoryKB);
+#endif
+	}
+
+	// Estimate amount of memory used by the worker: owned texture data and decompressed image
+	int64 GetMemoryUsage() const
+	{
+		int64 Size = 0;
+		for (const CMipMap& Mip : TexData.Mips)
+		{
+			if (Mip.ShouldFreeData) Size += Mip.DataSize;
+		}
+		if (bNeedDecompressedData && !bFail)
+		{
+			Size += TexData.GetDecompressedSize(0);
+		}
+		return Size;
 	}
 
 	bool Setup(const UUnrealMaterial* Tex, bool InHasSlices = false)
@@ -347,6 +640,9 @@ struct CTextureExportWorker
 		guard(CTextureExportWorker::Setup);
 
 		HasSlices = InHasSlices;
+		// Select exported mip before texture data is loaded
+		TexData.MipBias = GExportTextureMip;
+		TexData.MaxMipSize = GExportTextureMaxSize;
 
 		ETexturePixelFormat Format = Tex->GetTexturePixelFormat();
 		if (Format == TPF_UNKNOWN)
@@ -357,12 +653,18 @@ struct CTextureExportWorker
 
 		const char* Ext = NULL;
 
-		if (GExportDDS && PixelFormatInfo[Format].IsDXT())
+		if (GExportDDS && (PixelFormatInfo[Format].IsDXT() || GetDXGIFormat(Format)))
 		{
 			Func = ExportDDS_Worker;
 			bNeedDecompressedData = false;
 			Ext = "dds";
 		}
+		else if (GExportDDS && GetKTXFormat(Format))
+		{
+			Func = ExportKTX_Worker;
+			bNeedDecompressedData = false;
+			Ext = "ktx";
+		}
 		else if (PixelFormatInfo[Format].Float)
 		{
 			Func = ExportHDR_Worker;
@@ -379,6 +681,30 @@ struct CTextureExportWorker
 			Ext = "tga";
 		}
 
+		// Deduplication of decompressed textures: the key is computed from the first mip data, so
+		// texture data is required before creating the file
+		bool bDataRequested = false, bHasData = false;
+		bool bDedup = false;
+		CExportDedupKey DedupKey;
+		if (GExportDedup && !GDummyExport && !HasSlices && bNeedDecompressedData)
+		{
+			bDataRequested = true;
+			bHasData = Tex->GetTextureData(TexData) && TexData.Mips.Num() != 0;
+			if (bHasData && !TexData.Palette)
+			{
+				const CMipMap& Mip = TexData.Mips[0];
+				int32 Params[] = { TexData.Format, Mip.USize, Mip.VSize, TexData.isNormalmap,
+					Ext[0] | (Ext[1] << 8) | (Ext[2] << 16), GNoTgaCompress, GPngCompression };
+				DedupKey.Compute(Mip.CompressedData, Mip.DataSize, Params, sizeof(Params));
+				bDedup = true;
+				if (ExportDuplicateFile(Tex, DedupKey, "%s.%s", Tex->Name, Ext))
+				{
+					// Exported as a copy of another file, or skipped
+					return false;
+				}
+			}
+		}
+
 		if (!HasSlices)
 		{
 			Ar = CreateExportArchive(Tex, 0, "%s.%s", Tex->Name, Ext);
@@ -397,7 +723,11 @@ struct CTextureExportWorker
 		}
 
 		// Get texture data in context of the main thread: it's fast anyway
-		if (!Tex->GetTextureData(TexData) || TexData.Mips.Num() == 0)
+		if (!bDataRequested)
+		{
+			bHasData = Tex->GetTextureData(TexData) && TexData.Mips.Num() != 0;
+		}
+		if (!bHasData)
 		{
 			appPrintf("WARNING: texture %s has no valid mipmaps\n", Tex->Name);
 			bFail = true;
@@ -406,6 +736,12 @@ struct CTextureExportWorker
 			//?? and number will match these "no mipmaps" textures.
 		}
 
+		if (bDedup)
+		{
+			if (FFileArchive* FileAr = Ar->CastTo<FFileArchive>())
+				RegisterExportedFile(DedupKey, FileAr->GetFileName());
+		}
+
 		return true;
 
 		unguard;
@@ -413,6 +749,13 @@ struct CTextureExportWorker
 
 	void operator()()
 	{
+		// The same decompression buffer is used for all slices
+		byte* Scratch = NULL;
+		if (!bFail && bNeedDecompressedData)
+		{
+			Scratch = AllocTextureScratch(TexData.GetDecompressedSize(0));
+		}
+
 		int SliceCount = HasSlices ? 6 : 1;
 		for (int Slice = 0; Slice < SliceCount; Slice++)
 		{
@@ -445,7 +788,7 @@ struct CTextureExportWorker
 			byte* pic = NULL;
 			if (!bFail && bNeedDecompressedData)
 			{
-				pic = TexData.Decompress(0, HasSlices ? Slice : -1);
+				pic = TexData.Decompress(0, HasSlices ? Slice : -1, Scratch);
 				if (!pic)
 				{
 					bFail = true;
@@ -471,7 +814,6 @@ struct CTextureExportWorker
 			}
 
 			// Cleanup
-			if (pic) delete[] pic;
 			delete Ar;
 			Ar = NULL;
 
@@ -482,10 +824,32 @@ struct CTextureExportWorker
 				break;
 			}
 		}
+
+		if (Scratch) ReleaseTextureScratch(Scratch);
 //		Tex->ReleaseTextureData(); - the texture might not exist anymore
 	}
 };
 
+static void ExecuteTextureExport(CTextureExportWorker& Worker)
+{
+#if THREADING
+	if (Worker.TexData.OwnsAllData())
+	{
+		// Queue the worker only when it fits into memory budget, otherwise export the texture
+		// right now - this also throttles the caller until queued tasks are completed
+		int32 MemoryKB = (int32)((Worker.GetMemoryUsage() + 1023) >> 10);
+		if (GTextureExportMemoryKB == 0 || GTextureExportMemoryKB + MemoryKB <= (TEXTURE_EXPORT_MEMORY_BUDGET >> 10))
+		{
+			Worker.ReservedMemoryKB = MemoryKB;
+			InterlockedAdd(&GTextureExportMemoryKB, MemoryKB);
+			ThreadPool::TryExecuteInThread(MoveTemp(Worker), NULL, true);
+			return;
+		}
+	}
+#endif // THREADING
+	Worker();
+}
+
 void ExportTexture(const UUnrealMaterial* Tex)
 {
 	guard(ExportTexture);
@@ -512,18 +876,7 @@ void ExportTexture(const UUnrealMaterial* Tex)
 		return;
 	}
 
-#if THREADING
-	if (Worker.TexData.OwnsAllData())
-	{
-		ThreadPool::TryExecuteInThread(MoveTemp(Worker), NULL, true);
-	}
-	else
-	{
-		Worker();
-	}
-#else
-	Worker();
-#endif
+	ExecuteTextureExport(Worker);
 
 	unguard;
 }
@@ -571,18 +924,7 @@ void ExportCubemap(const UUnrealMaterial* Tex)
 				return;
 			}
 
-	#if THREADING
-			if (Worker.TexData.OwnsAllData())
-			{
-				ThreadPool::TryExecuteInThread(MoveTemp(Worker), NULL, true);
-			}
-			else
-			{
-				Worker();
-			}
-	#else
-			Worker();
-	#endif
+			ExecuteTextureExport(Worker);
 		}
 	}
 #endif // UNREAL4
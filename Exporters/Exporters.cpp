@@ -17,6 +17,8 @@ bool GExportInProgress   = false;
 
 bool GDummyExport        = false;
 
+bool GExportDedup        = false;
+
 
 /*-----------------------------------------------------------------------------
 	Exporter function management
@@ -46,6 +48,32 @@ void RegisterExporter(const char* ClassName, ExporterFunc_t Func)
 }
 
 
+// Export worker processes
+
+static int GExportWorkerIndex = -1;
+static int GNumExportWorkers = 0;
+
+void SetExportWorker(int WorkerIndex, int NumWorkers)
+{
+	assert(WorkerIndex >= 0 && WorkerIndex < NumWorkers);
+	GExportWorkerIndex = WorkerIndex;
+	GNumExportWorkers = NumWorkers;
+}
+
+bool IsPackageOwnedByWorker(const char* PackageFilename)
+{
+	if (GNumExportWorkers <= 1) return true;
+
+	// FNV-1a hash of lowercase package path
+	uint32 Hash = 2166136261u;
+	for (const char* s = PackageFilename; *s; s++)
+	{
+		Hash = (Hash ^ (byte)tolower(*s)) * 16777619u;
+	}
+	return (int)(Hash % GNumExportWorkers) == GExportWorkerIndex;
+}
+
+
 // List of already exported objects
 
 #define EXPORTED_LIST_HASH_SIZE		4096
@@ -176,6 +204,8 @@ void BeginExport(bool bBatch)
 	ctx.startTime = appMilliseconds();
 }
 
+static void FlushExportDedup();
+
 void EndExport(bool profile)
 {
 //	assert(GExportInProgress); - in non-batch export this might be 'false'
@@ -185,6 +215,9 @@ void EndExport(bool profile)
 	ThreadPool::WaitForCompletion();
 #endif
 
+	// Create duplicate files, all source files are written at this point
+	FlushExportDedup();
+
 	GExportInProgress = false;
 	GBeforeLoadObjectCallback = NULL;
 
@@ -325,6 +358,12 @@ bool ExportObject(const UObject *Obj)
 	if (IsObjectExported(Obj))
 		return true;
 
+	// Objects are exported by the worker process which owns their package. This applies to objects referenced
+	// by other exported objects too (textures of materials, animations of meshes etc), so when several workers
+	// are loading the same object, only one of them is writing its files.
+	if (Obj->Package && !IsPackageOwnedByWorker(*Obj->Package->GetFilename()))
+		return true;
+
 	static CUniqueNameList ExportedNames;
 
 	// For "uncook", different packages may have copies of the same object, which are stored with different quality.
@@ -536,9 +575,11 @@ bool CheckExportFilePresence(const UObject* Obj, const char* fmt, ...)
 }
 
 
-FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const char* fmt, ...)
+// Common part of CreateExportArchive() and ExportDuplicateFile(). Registers the object and returns
+// the name of file to create, or NULL if nothing should be written.
+static const char* PrepareExportFile(const UObject* Obj, const char* fmt, va_list args)
 {
-	guard(CreateExportArchive);
+	guard(PrepareExportFile);
 
 	bool bNewObject = false;
 	if (ctx.LastExported != Obj)
@@ -550,10 +591,7 @@ FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const ch
 		ctx.LastExported = Obj;
 	}
 
-	va_list	argptr;
-	va_start(argptr, fmt);
-	const char* filename = GetExportFileName(Obj, fmt, argptr);
-	va_end(argptr);
+	const char* filename = GetExportFileName(Obj, fmt, args);
 
 	if (!filename) return NULL;
 
@@ -574,12 +612,31 @@ FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const ch
 		}
 	}
 
+	return filename;
+
+	unguard;
+}
+
+FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const char* fmt, ...)
+{
+	guard(CreateExportArchive);
+
+	va_list	argptr;
+	va_start(argptr, fmt);
+	const char* filename = PrepareExportFile(Obj, fmt, argptr);
+	va_end(argptr);
+
+	if (!filename) return NULL;
+
 	if (GDummyExport)
 	{
 		return new FDummyArchive();
 	}
 
 	appMakeDirectoryForFile(filename);
+	// The file could be a hard link created by export deduplication, so don't overwrite it in place:
+	// that would change all files sharing the same data. Remove the file and create a new one.
+	remove(filename);
 	FFileWriter *Ar = new FFileWriter(filename, FAO_NoOpenError | FileOptions);
 	if (!Ar->IsOpen())
 	{
@@ -594,3 +651,317 @@ FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const ch
 
 	unguard;
 }
+
+
+/*-----------------------------------------------------------------------------
+	Export deduplication
+-----------------------------------------------------------------------------*/
+
+#define EXPORT_DEDUP_MAGIC			0x44444D55		// 'UMDD'
+#define EXPORT_DEDUP_VERSION		1				// increment when key computation or exported file format changes
+#define EXPORT_DEDUP_HASH_SIZE		4096
+
+extern "C" unsigned long adler32(unsigned long adler, const byte* buf, unsigned int len);
+
+struct CExportDedupEntry
+{
+	CExportDedupKey	Key;
+	FString			Filename;		// relative to BaseExportDir, empty when entry was removed
+	// File size and modification time, used to verify files exported in previous session.
+	// Size is -1 for files exported in the current session.
+	int64			Size;
+	int64			ModTime;
+	int				HashNext;
+	int				NameHashNext;
+
+	CExportDedupEntry()
+	:	Size(0)
+	,	ModTime(0)
+	,	HashNext(-1)
+	,	NameHashNext(-1)
+	{}
+};
+
+struct CExportDedupLink
+{
+	FString			SrcFilename;
+	FString			DstFilename;
+};
+
+static TArray<CExportDedupEntry> GDedupEntries;
+static int GDedupHash[EXPORT_DEDUP_HASH_SIZE];
+static int GDedupNameHash[EXPORT_DEDUP_HASH_SIZE];
+static TArray<CExportDedupLink> GDedupLinks;
+static FString GDedupIndexName(".umodel_exported");
+static FString GDedupIndexFile;						// full name of currently loaded index
+static bool GDedupChanged = false;
+
+void CExportDedupKey::Compute(const void* Data, int Size, const void* Params, int ParamsSize)
+{
+	DataHash[0] = crc32(0, (const byte*)Data, Size);
+	DataHash[1] = adler32(1, (const byte*)Data, Size);
+	DataSize = Size;
+	ParamsHash = crc32(0, (const byte*)Params, ParamsSize);
+}
+
+static int GetDedupNameHash(const char* Filename)
+{
+	return crc32(0, (const byte*)Filename, strlen(Filename)) & (EXPORT_DEDUP_HASH_SIZE - 1);
+}
+
+static int AddDedupEntry(const CExportDedupKey& Key, const char* Filename, int64 Size, int64 ModTime)
+{
+	int Index = GDedupEntries.AddDefaulted();
+	CExportDedupEntry& E = GDedupEntries[Index];
+	E.Key = Key;
+	E.Filename = Filename;
+	E.Size = Size;
+	E.ModTime = ModTime;
+	int h = Key.DataHash[0] & (EXPORT_DEDUP_HASH_SIZE - 1);
+	E.HashNext = GDedupHash[h];
+	GDedupHash[h] = Index;
+	h = GetDedupNameHash(Filename);
+	E.NameHashNext = GDedupNameHash[h];
+	GDedupNameHash[h] = Index;
+	return Index;
+}
+
+// Returns file name relative to the export directory, or NULL if file is outside of it
+static const char* GetDedupRelativeName(const char* Filename)
+{
+	int len = strlen(BaseExportDir);
+	if (strncmp(Filename, BaseExportDir, len) != 0 || Filename[len] != '/')
+		return NULL;
+	return Filename + len + 1;
+}
+
+// Load list of exported files for the current export directory, when not loaded yet
+static void LoadDedupIndex()
+{
+	guard(LoadDedupIndex);
+
+	if (!BaseExportDir[0])
+		appSetBaseExportDirectory(".");
+
+	char IndexFile[MAX_PACKAGE_PATH];
+	appSprintf(ARRAY_ARG(IndexFile), "%s/%s", BaseExportDir, *GDedupIndexName);
+	if (GDedupIndexFile == IndexFile)
+		return;
+
+	GDedupIndexFile = IndexFile;
+	GDedupEntries.Empty();
+	memset(GDedupHash, -1, sizeof(GDedupHash));
+	memset(GDedupNameHash, -1, sizeof(GDedupNameHash));
+	GDedupChanged = false;
+
+	FArchive* Ar = new FFileReader(IndexFile, FAO_NoOpenError);
+	Ar->Game = GAME_UE4_BASE;					// use the same serialization format for any game
+	if (Ar->IsOpen())
+	{
+		TRY {
+			int32 Magic, Version, NumEntries;
+			*Ar << Magic << Version << NumEntries;
+			if (Magic == EXPORT_DEDUP_MAGIC && Version == EXPORT_DEDUP_VERSION && NumEntries >= 0)
+			{
+				GDedupEntries.Empty(NumEntries);
+				for (int i = 0; i < NumEntries; i++)
+				{
+					CExportDedupKey Key;
+					FString Filename;
+					int64 Size, ModTime;
+					*Ar << Key.DataHash[0] << Key.DataHash[1] << Key.DataSize << Key.ParamsHash << Filename << Size << ModTime;
+					AddDedupEntry(Key, *Filename, Size, ModTime);
+				}
+			}
+		} CATCH {
+			// Damaged file, will be rebuilt
+			GError.Reset();
+			GDedupEntries.Empty();
+			memset(GDedupHash, -1, sizeof(GDedupHash));
+			memset(GDedupNameHash, -1, sizeof(GDedupNameHash));
+		}
+	}
+	delete Ar;
+
+	unguard;
+}
+
+// Check if file from the entry is still valid
+static bool VerifyDedupEntry(const CExportDedupEntry& E, const char* FullName)
+{
+	if (E.Filename.IsEmpty())
+		return false;
+	if (E.Size < 0)
+		return true;							// exported in this session
+	int64 Size, ModTime;
+	return appGetFileSizeAndTime(FullName, Size, ModTime) && Size == E.Size && ModTime == E.ModTime;
+}
+
+void SetExportDedupIndexName(const char* Name)
+{
+	GDedupIndexName = Name;
+	GDedupIndexFile.Empty();					// force reload
+}
+
+void RegisterExportedFile(const CExportDedupKey& Key, const char* Filename)
+{
+	guard(RegisterExportedFile);
+
+	LoadDedupIndex();
+	const char* RelativeName = GetDedupRelativeName(Filename);
+	if (!RelativeName) return;
+
+	// The file is overwritten, so remove entries which were referencing it
+	int h = GetDedupNameHash(RelativeName);
+	for (int Index = GDedupNameHash[h]; Index >= 0; Index = GDedupEntries[Index].NameHashNext)
+	{
+		CExportDedupEntry& E = GDedupEntries[Index];
+		if (E.Filename == RelativeName)
+			E.Filename.Empty();
+	}
+
+	AddDedupEntry(Key, RelativeName, -1, 0);
+	GDedupChanged = true;
+
+	unguardf("%s", Filename);
+}
+
+bool ExportDuplicateFile(const UObject* Obj, const CExportDedupKey& Key, const char* fmt, ...)
+{
+	guard(ExportDuplicateFile);
+
+	if (!GExportDedup || GDummyExport) return false;
+
+	LoadDedupIndex();
+
+	va_list	argptr;
+	va_start(argptr, fmt);
+	const char* filename = GetExportFileName(Obj, fmt, argptr);
+	va_end(argptr);
+	if (!filename) return false;
+	const char* RelativeName = GetDedupRelativeName(filename);
+	if (!RelativeName) return false;
+
+	// Find a file with the same key, prefer the file at the same location
+	const CExportDedupEntry* Found = NULL;
+	char FullName[MAX_PACKAGE_PATH];
+	int h = Key.DataHash[0] & (EXPORT_DEDUP_HASH_SIZE - 1);
+	for (int Index = GDedupHash[h]; Index >= 0; Index = GDedupEntries[Index].HashNext)
+	{
+		const CExportDedupEntry& E = GDedupEntries[Index];
+		if (!(E.Key == Key)) continue;
+		appSprintf(ARRAY_ARG(FullName), "%s/%s", BaseExportDir, *E.Filename);
+		if (!VerifyDedupEntry(E, FullName)) continue;
+		Found = &E;
+		if (E.Filename == RelativeName) break;
+	}
+	if (!Found) return false;
+
+	FString SrcFilename;
+	SrcFilename = *Found->Filename;
+	FString DstFilename;
+	DstFilename = RelativeName;
+
+	va_start(argptr, fmt);
+	filename = PrepareExportFile(Obj, fmt, argptr);
+	va_end(argptr);
+	if (!filename) return true;					// file is skipped or object was already exported
+
+	if (SrcFilename != DstFilename)
+	{
+		// Create file when all exported files will be written
+		CExportDedupLink* Link = new (GDedupLinks) CExportDedupLink;
+		Link->SrcFilename = SrcFilename;
+		Link->DstFilename = DstFilename;
+		RegisterExportedFile(Key, filename);
+	}
+	// else: the file is up to date
+	return true;
+
+	unguardf("%s", Obj->Name);
+}
+
+static bool CopyExportedFile(const char* SrcFilename, const char* DstFilename)
+{
+	FILE* Src = fopen(SrcFilename, "rb");
+	if (!Src) return false;
+	FILE* Dst = fopen(DstFilename, "wb");
+	if (!Dst)
+	{
+		fclose(Src);
+		return false;
+	}
+	bool bOk = true;
+	byte Buffer[65536];
+	while (true)
+	{
+		size_t Size = fread(Buffer, 1, sizeof(Buffer), Src);
+		if (Size == 0) break;
+		if (fwrite(Buffer, 1, Size, Dst) != Size)
+		{
+			bOk = false;
+			break;
+		}
+	}
+	fclose(Src);
+	fclose(Dst);
+	return bOk;
+}
+
+static void FlushExportDedup()
+{
+	guard(FlushExportDedup);
+
+	if (GDedupIndexFile.IsEmpty()) return;		// nothing was registered
+
+	// Create duplicate files
+	for (const CExportDedupLink& Link : GDedupLinks)
+	{
+		char SrcFilename[MAX_PACKAGE_PATH], DstFilename[MAX_PACKAGE_PATH];
+		appSprintf(ARRAY_ARG(SrcFilename), "%s/%s", BaseExportDir, *Link.SrcFilename);
+		appSprintf(ARRAY_ARG(DstFilename), "%s/%s", BaseExportDir, *Link.DstFilename);
+		appMakeDirectoryForFile(DstFilename);
+		remove(DstFilename);
+		// Hard link could fail if file system doesn't support it, make a copy then
+		if (!appLinkFile(SrcFilename, DstFilename) && !CopyExportedFile(SrcFilename, DstFilename))
+		{
+			appPrintf("WARNING: unable to create \"%s\" from \"%s\"\n", DstFilename, SrcFilename);
+			remove(DstFilename);
+		}
+	}
+	GDedupLinks.Empty();
+
+	if (!GDedupChanged) return;
+
+	// Save the list of exported files, drop files which are not valid anymore
+	FArchive* Ar = new FFileWriter(*GDedupIndexFile, FAO_NoOpenError);
+	if (!Ar->IsOpen())
+	{
+		appPrintf("WARNING: unable to write \"%s\"\n", *GDedupIndexFile);
+		delete Ar;
+		return;
+	}
+	Ar->Game = GAME_UE4_BASE;
+
+	int32 Magic = EXPORT_DEDUP_MAGIC, Version = EXPORT_DEDUP_VERSION, NumEntries = 0;
+	*Ar << Magic << Version << NumEntries;
+	for (CExportDedupEntry& E : GDedupEntries)
+	{
+		char FullName[MAX_PACKAGE_PATH];
+		appSprintf(ARRAY_ARG(FullName), "%s/%s", BaseExportDir, *E.Filename);
+		if (!VerifyDedupEntry(E, FullName) || !appGetFileSizeAndTime(FullName, E.Size, E.ModTime))
+		{
+			E.Filename.Empty();
+			continue;
+		}
+		*Ar << E.Key.DataHash[0] << E.Key.DataHash[1] << E.Key.DataSize << E.Key.ParamsHash << E.Filename << E.Size << E.ModTime;
+		NumEntries++;
+	}
+	Ar->Seek(8);
+	*Ar << NumEntries;
+	delete Ar;
+
+	GDedupChanged = false;
+
+	unguard;
+}
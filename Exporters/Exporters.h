@@ -36,16 +36,51 @@ bool CheckExportFilePresence(const UObject* Obj, const char* fmt, ...);
 // Function may return NULL.
 FArchive* CreateExportArchive(const UObject* Obj, unsigned FileOptions, const char* fmt, ...);
 
+// Export deduplication (enabled with GExportDedup). Exported files are registered with the key computed
+// from the data which defines file contents. When a file with the same key has been already exported,
+// in this or in previous session, the object is exported as a hard link or copy of the existing file.
+// The list of exported files is saved into the export directory.
+struct CExportDedupKey
+{
+	uint32		DataHash[2];
+	int32		DataSize;
+	uint32		ParamsHash;				// hash of other parameters which affects exported file
+
+	void Compute(const void* Data, int Size, const void* Params, int ParamsSize);
+
+	bool operator==(const CExportDedupKey& Other) const
+	{
+		return memcmp(this, &Other, sizeof(*this)) == 0;
+	}
+};
+
+// Export the object as a copy of previously exported file with the same key, when such file exists. The file
+// is created in EndExport(), when all files are written. Returns false if the object should be exported normally.
+bool ExportDuplicateFile(const UObject* Obj, const CExportDedupKey& Key, const char* fmt, ...);
+// Register a file created with CreateExportArchive()
+void RegisterExportedFile(const CExportDedupKey& Key, const char* Filename);
+// Set name of the file with the list of exported files (used by export worker processes)
+void SetExportDedupIndexName(const char* Name);
+
+// Export worker processes (-threads=N). Every package is owned by a single worker, selected with the hash of
+// package path. ExportObject() skips objects from packages owned by other workers.
+void SetExportWorker(int WorkerIndex, int NumWorkers);
+bool IsPackageOwnedByWorker(const char* PackageFilename);
+
 // Configuration
 extern bool GExportScripts;
 extern bool GExportLods;
 extern bool GNoTgaCompress;
 extern bool GExportPNG;
 extern bool GExportDDS;
+extern byte GPngCompression;
+extern int  GExportTextureMip;
+extern int  GExportTextureMaxSize;
 extern bool GUncook;
 extern bool GUseGroups;
 extern bool GDontOverwriteFiles;
 extern bool GDummyExport;
+extern bool GExportDedup;
 
 // forwards
 class UObject;
@@ -88,7 +123,7 @@ void ExportGfx(const USwfMovie* Swf);
 void ExportFaceFXAnimSet(const UFaceFXAnimSet* Fx);
 void ExportFaceFXAsset(const UFaceFXAsset* Fx);
 
-void WriteTGA(FArchive& Ar, int width, int height, byte* pic);
+void WriteTGA(FArchive& Ar, int width, int height, const byte* pic, bool flip = false);
 
 
 #endif // __EXPORT_H__
@@ -440,7 +440,7 @@ void CSkelMeshInstance::UpdateSkeleton()
 
 		const CAnimSequence *AnimSeq1 = Chn->Anim1;
 		const CAnimSequence *AnimSeq2 = NULL;
-		float Time2;
+		float Time2 = 0;
 		if (AnimSeq1)
 		{
 			if (Chn->Anim2 && Chn->SecondaryBlend)
@@ -450,6 +450,9 @@ void CSkelMeshInstance::UpdateSkeleton()
 				Time2 = Chn->Time / AnimSeq1->NumFrames * AnimSeq2->NumFrames;
 			}
 		}
+		// get packed tracks once for all bones
+		const CAnimTrackData *Tracks1 = AnimSeq1 ? AnimSeq1->GetTracks() : NULL;
+		const CAnimTrackData *Tracks2 = AnimSeq2 ? AnimSeq2->GetTracks() : NULL;
 
 		// compute bone range, affected by specified animation bone
 		int firstBone = Chn->RootBone;
@@ -486,20 +489,20 @@ void CSkelMeshInstance::UpdateSkeleton()
 				// get bone position from track
 				if (!AnimSeq2 || Chn->SecondaryBlend != 1.0f)
 				{
-					AnimSeq1->Tracks[BoneIndex]->GetBonePosition(Chn->Time, AnimSeq1->NumFrames, Chn->Looped, BP, BO);
+					Tracks1[BoneIndex].GetBonePosition(Chn->Time, AnimSeq1->NumFrames, Chn->Looped, BP, BO);
 //const char *bname = *Bone.Name;
 //CQuat BOO = BO;
 //if (!strcmp(bname, "b_MF_UpperArm_L")) { BO.Set(-0.225, -0.387, -0.310,  0.839); }
 #if SHOW_ANIM
 //if (i == 6 || i == 8 || i == 10 || i == 11 || i == 29)	//??
 					DrawTextLeft("%s%d Bone (%s) : P{ %8.3f %8.3f %8.3f }  Q{ %6.3f %6.3f %6.3f %6.3f }",
-						AnimSeq1->Tracks[BoneIndex]->HasKeys() ? S_GREEN : S_BLUE,
+						Tracks1[BoneIndex].HasKeys() ? S_GREEN : S_BLUE,
 						i, *Bone.Name, VECTOR_ARG(BP), QUAT_ARG(BO));
 //if (!strcmp(bname, "b_MF_UpperArm_L")) DrawTextLeft("%g %g %g %g [%g %g]", BO.x-BOO.x,BO.y-BOO.y,BO.z-BOO.z,BO.w-BOO.w, BO.w, BOO.w);
 #endif
 //BO.Normalize();
 #if SHOW_BONE_UPDATES
-					if (AnimSeq1->Tracks[BoneIndex]->HasKeys())
+					if (Tracks1[BoneIndex].HasKeys())
 						BoneUpdateCounts[i]++;
 #endif
 				}
@@ -510,7 +513,7 @@ void CSkelMeshInstance::UpdateSkeleton()
 					CQuat BO2;
 					BP2 = Bone.Position;		// default position - from bind pose
 					BO2 = Bone.Orientation;		// ...
-					AnimSeq2->Tracks[BoneIndex]->GetBonePosition(Time2, AnimSeq2->NumFrames, Chn->Looped, BP2, BO2);
+					Tracks2[BoneIndex].GetBonePosition(Time2, AnimSeq2->NumFrames, Chn->Looped, BP2, BO2);
 					if (Chn->SecondaryBlend == 1.0f)
 					{
 						BO = BO2;
@@ -23,6 +23,7 @@
 #include "UnThirdParty.h"
 
 #include "Exporters/Exporters.h"
+#include "Wrappers/TexturePNG.h"
 
 #if DECLARE_VIEWER_PROPS
 #include "Mesh/SkeletalMesh.h"
@@ -36,6 +37,7 @@
 #include "UmodelCommands.h"
 #include "Version.h"
 #include "MiscStrings.h"
+#include "Parallel.h"
 
 #define APP_CAPTION					"UE Viewer"
 
@@ -49,6 +51,7 @@ CUmodelSettings GSettings;
 
 #if THREADING
 extern bool GEnableThreads;
+extern int GMaxThreads;
 #endif
 
 /*-----------------------------------------------------------------------------
@@ -372,6 +375,7 @@ static void PrintUsage()
 			"\n"
 			"Developer commands:\n"
 			"    -log=file       write log to the specified file\n"
+			"    -noloadlog      don't print names of loaded objects\n"
 			"    -dump           dump object information to console\n"
 			"    -pkginfo        load package and display its information\n"
 			"    -testexport     perform fake export\n"
@@ -397,6 +401,8 @@ static void PrintUsage()
 #endif
 			"    -aes=key        provide AES decryption key for encrypted pak files,\n"
 			"                    key is ASCII or hex string (hex format is 0xAABBCCDD)\n"
+			"    -filecache=file store pak file directories and package scan results\n"
+			"                    in the file for faster startup\n"
 			"\n"
 			"Compatibility options:\n"
 			"    -nomesh         disable loading of SkeletalMesh classes in a case of\n"
@@ -434,18 +440,32 @@ static void PrintUsage()
 			"    -md5            use md5mesh/md5anim format for skeletal mesh\n"
 			"    -gltf           use glTF 2.0 format for mesh\n"
 			"    -lods           export all available mesh LOD levels\n"
-			"    -dds            export textures in DDS format whenever possible\n"
+			"    -dds            export compressed textures as DDS or KTX without decoding\n"
 			"    -png            export textures in PNG format instead of TGA\n"
+			"    -pngfast, -pngbest\n"
+			"                    export PNG with faster or better compression\n"
 			"    -notgacomp      disable TGA compression\n"
 			"    -nooverwrite    prevent existing files from being overwritten (better\n"
 			"                    performance)\n"
+			"    -dedup          export textures with identical data once, create other files\n"
+			"                    as links or copies; list of exported files is kept in the\n"
+			"                    export directory for faster next export; with -threads,\n"
+			"                    every worker process has its own list\n"
+			"    -threads=N      export multiple packages with N parallel worker processes;\n"
+			"                    ignored with -uncook\n"
+			"    -texmip=N       export texture mip level N instead of the largest one\n"
+			"    -texmaxsize=N   export the largest texture mip not exceeding N pixels\n"
+			"    -texcache=MB    size of decoded texture cache, 0 to disable (default is\n"
+			"                    256 MB in viewer, disabled for export)\n"
+			"    -animcache=MB   memory limit for decoded animation tracks, 0 for no limit\n"
+			"                    (default is 256 MB)\n"
 			"\n"
 			"Supported resources for export:\n"
 			"    SkeletalMesh    exported as ActorX psk file, MD5Mesh or glTF\n"
 			"    MeshAnimation   exported as ActorX psa file or MD5Anim\n"
 			"    VertMesh        exported as Unreal 3d file\n"
 			"    StaticMesh      exported as psk file with no skeleton (pskx) or glTF\n"
-			"    Texture         exported in tga or dds format\n"
+			"    Texture         exported in tga, dds or ktx format\n"
 			"    Sounds          file extension depends on object contents\n"
 			"    ScaleForm       gfx\n"
 			"    FaceFX          fxa\n"
@@ -736,9 +756,13 @@ int main(int argc, const char **argv)
 
 	static byte mainCmd = CMD_View;
 	static bool bAll = false, hasRootDir = false, forceUI = false;
+	static int numExportWorkers = 0, exportWorkerIndex = -1;
+	static int textureCacheSize = -1;
+	static int animCacheSize = -1;
 	TArray<const char*> packagesToLoad, objectsToLoad;
 	TArray<const char*> params;
 	const char *attachAnimName = NULL;
+	const char *gameFileCacheName = NULL;
 	for (int arg = 1; arg < argc; arg++)
 	{
 		const char *opt = argv[arg];
@@ -770,6 +794,7 @@ int main(int argc, const char **argv)
 			OPT_BOOL ("groups",  GSettings.Export.SaveGroups)
 			OPT_BOOL ("lods",    GExportLods)
 			OPT_BOOL ("uc",      GExportScripts)
+			OPT_NBOOL("noloadlog", GLogObjectLoading)
 			// disable classes
 			OPT_NBOOL("nomesh",  GSettings.Startup.UseSkeletalMesh)
 			OPT_NBOOL("nostat",  GSettings.Startup.UseStaticMesh)
@@ -781,6 +806,7 @@ int main(int argc, const char **argv)
 			OPT_BOOL ("dds",     GSettings.Export.ExportDdsTexture)
 			OPT_BOOL ("notgacomp", GNoTgaCompress)
 			OPT_BOOL ("nooverwrite", GDontOverwriteFiles)
+			OPT_BOOL ("dedup",   GExportDedup)
 #if HAS_UI
 			OPT_BOOL ("gui",     forceUI)
 #endif
@@ -806,6 +832,11 @@ int main(int argc, const char **argv)
 			GSettings.Export.TextureFormat = ETextureExportFormat::png;
 			//!! todo: also screenshots
 		}
+		else if (!stricmp(opt, "pngfast") || !stricmp(opt, "pngbest"))
+		{
+			GSettings.Export.TextureFormat = ETextureExportFormat::png;
+			GPngCompression = !stricmp(opt, "pngfast") ? PNG_COMPRESS_FAST : PNG_COMPRESS_BEST;
+		}
 		else if (!stricmp(opt, "md5"))
 		{
 			GSettings.Export.SkeletalMeshFormat = GSettings.Export.StaticMeshFormat = EExportMeshFormat::md5;
@@ -853,6 +884,65 @@ int main(int argc, const char **argv)
 			}
 			GForcePackageVersion = ver;
 		}
+		else if (!strnicmp(opt, "threads=", 8))
+		{
+			numExportWorkers = atoi(opt+8);
+			if (numExportWorkers < 1)
+			{
+				appPrintf("ERROR: number of threads is not valid: %s\n", opt+8);
+				exit(0);
+			}
+		}
+		else if (!strnicmp(opt, "worker=", 7))
+		{
+			// Internal option: this process is a worker started with -threads=N
+			if (sscanf(opt+7, "%d/%d", &exportWorkerIndex, &numExportWorkers) != 2 ||
+				exportWorkerIndex < 0 || exportWorkerIndex >= numExportWorkers)
+			{
+				CommandLineError("invalid option: -%s", opt);
+			}
+#if THREADING
+			// Share CPU cores between worker processes. This should be done before any
+			// filesystem work, because the first ParallelFor call creates the thread pool.
+			GMaxThreads = max(CThread::GetLogicalCPUCount() / numExportWorkers, 1);
+#endif
+		}
+		else if (!strnicmp(opt, "texmip=", 7))
+		{
+			GExportTextureMip = atoi(opt+7);
+			if (GExportTextureMip < 0)
+			{
+				appPrintf("ERROR: mip level is not valid: %s\n", opt+7);
+				exit(0);
+			}
+		}
+		else if (!strnicmp(opt, "texmaxsize=", 11))
+		{
+			GExportTextureMaxSize = atoi(opt+11);
+			if (GExportTextureMaxSize < 1)
+			{
+				appPrintf("ERROR: texture size is not valid: %s\n", opt+11);
+				exit(0);
+			}
+		}
+		else if (!strnicmp(opt, "texcache=", 9))
+		{
+			textureCacheSize = atoi(opt+9);
+			if (textureCacheSize < 0)
+			{
+				appPrintf("ERROR: texture cache size is not valid: %s\n", opt+9);
+				exit(0);
+			}
+		}
+		else if (!strnicmp(opt, "animcache=", 10))
+		{
+			animCacheSize = atoi(opt+10);
+			if (animCacheSize < 0)
+			{
+				appPrintf("ERROR: animation cache size is not valid: %s\n", opt+10);
+				exit(0);
+			}
+		}
 		else if (!strnicmp(opt, "pkg=", 4))
 		{
 			const char *pkg = opt+4;
@@ -879,6 +969,12 @@ int main(int argc, const char **argv)
 			GAesKey.TrimStartAndEndInline();
 			CheckHexAesKey();
 		}
+#if UNREAL4
+		else if (!strnicmp(opt, "filecache=", 10))
+		{
+			gameFileCacheName = opt+10;
+		}
+#endif
 		// information commands
 		else if (!stricmp(opt, "taglist"))
 		{
@@ -922,6 +1018,14 @@ int main(int argc, const char **argv)
 		}
 	}
 
+#if UNREAL4
+	if (gameFileCacheName)
+	{
+		// Export workers are only reading the cache, it is saved by the main process
+		appSetGameFileCache(gameFileCacheName, exportWorkerIndex >= 0);
+	}
+#endif
+
 	// Parse UMODEL [package_name [obj_name [class_name]]]
 	const char *argPkgName   = (params.Num() >= 1) ? params[0] : NULL;
 	const char *argObjName   = (params.Num() >= 2) ? params[1] : NULL;
@@ -1009,6 +1113,32 @@ int main(int argc, const char **argv)
 		appSetRootDirectory(".");			// scan for packages
 	}
 
+	if (exportWorkerIndex >= 0)
+	{
+		SetupExportWorker(exportWorkerIndex, numExportWorkers);
+	}
+	else if (numExportWorkers > 1 && mainCmd == CMD_Export && !objectsToLoad.Num())
+	{
+		// Batch export of whole packages: run worker processes when there's enough packages
+		int numPackages = 0;
+		for (int i = 0; i < packagesToLoad.Num(); i++)
+		{
+			TStaticArray<const CGameFileInfo*, 32> Files;
+			appFindGameFiles(packagesToLoad[i], Files);
+			numPackages += Files.Num();
+		}
+		if (GUncook)
+		{
+			// Unique names of uncooked objects are computed using objects from all packages, so
+			// these packages should be exported by a single process
+			appPrintf("WARNING: -threads option is not compatible with -uncook, exporting with a single process\n");
+		}
+		else if (numPackages > 1)
+		{
+			return RunExportWorkers(min(numExportWorkers, numPackages), argc, argv) ? 0 : 1;
+		}
+	}
+
 	bool bShouldLoadPackages = (mainCmd != CMD_Save);
 	TArray<const CGameFileInfo*> GameFiles;
 
@@ -1027,6 +1157,9 @@ int main(int argc, const char **argv)
 		{
 			for (int j = 0; j < Files.Num(); j++)
 			{
+				// Worker process handles only its own packages
+				if (!IsPackageOwnedByWorker(*Files[j]->GetRelativeName()))
+					continue;
 				bool failed = false;
 				if (bShouldLoadPackages)
 				{
@@ -1048,6 +1181,12 @@ int main(int argc, const char **argv)
 		}
 	}
 
+	if (exportWorkerIndex >= 0 && !GameFiles.Num())
+	{
+		// No packages for this worker
+		return 0;
+	}
+
 #if !HAS_UI
 	if (!GameFiles.Num())
 	{
@@ -1184,6 +1323,23 @@ int main(int argc, const char **argv)
 	appPrintProfiler();
 #endif
 
+	if (textureCacheSize >= 0)
+	{
+		SetTextureCacheSize(textureCacheSize);
+	}
+	else if (mainCmd == CMD_Export)
+	{
+		// Export without a viewer decodes every texture once, so the cache would only waste memory
+#if HAS_UI || RENDERING
+		if (!GApplication.GuiShown)
+#endif
+			SetTextureCacheSize(0);
+	}
+	if (animCacheSize >= 0)
+	{
+		SetAnimTrackCacheSize(animCacheSize);
+	}
+
 	if (mainCmd == CMD_Export)
 	{
 		// If we have list of objects, the process only those ones. Otherwise, process full packages.
@@ -159,7 +159,7 @@ UIElement& UISettingsDialog::MakeExportOptions()
 					.AddItem("TGA (uncompressed)", ETextureExportFormat::tga_uncomp)
 					.AddItem("PNG", ETextureExportFormat::png)
 			]
-			+ NewControl(UICheckbox, "Export compressed textures to dds format", &Opt.Export.ExportDdsTexture)
+			+ NewControl(UICheckbox, "Export compressed textures to dds or ktx format", &Opt.Export.ExportDdsTexture)
 		]
 		+ NewControl(UICheckbox, "Don't overwrite already exported files", &Opt.Export.DontOverwriteFiles)
 		;
@@ -7,6 +7,7 @@
 #include "PackageUtils.h"
 #include "Exporters/Exporters.h"
 #include "UmodelApp.h"
+#include "UmodelCommands.h"
 
 
 bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress)
@@ -120,6 +121,64 @@ bool ExportPackages(const TArray<UnPackage*>& Packages, IProgressCallback* Progr
 }
 
 
+bool RunExportWorkers(int NumWorkers, int argc, const char** argv)
+{
+	guard(RunExportWorkers);
+
+	appPrintf("Exporting packages with %d workers ...\n", NumWorkers);
+	unsigned long startTime = appMilliseconds();
+
+	// Workers are using the same command line with added worker index
+	TArray<const char*> Args;
+	Args.AddUninitialized(argc + 1);
+	memcpy(Args.GetData(), argv, argc * sizeof(const char*));
+
+	bool failed = false;
+	TArray<address_t> Processes;
+	for (int i = 0; i < NumWorkers; i++)
+	{
+		char WorkerArg[64];
+		appSprintf(ARRAY_ARG(WorkerArg), "-worker=%d/%d", i, NumWorkers);
+		Args[argc] = WorkerArg;
+		address_t Process = appStartProcess(Args.Num(), Args.GetData());
+		if (!Process)
+		{
+			appPrintf("ERROR: unable to start worker process %d\n", i);
+			failed = true;
+			break;
+		}
+		Processes.Add(Process);
+	}
+
+	// Wait for all started workers, even if some of them were not started
+	for (int i = 0; i < Processes.Num(); i++)
+	{
+		int ExitCode = appWaitProcess(Processes[i]);
+		if (ExitCode != 0)
+		{
+			appPrintf("ERROR: worker %d failed with exit code %d\n", i, ExitCode);
+			failed = true;
+		}
+	}
+
+	appPrintf("Export with %d workers completed in %.1f sec\n", NumWorkers, (appMilliseconds() - startTime) / 1000.0f);
+	return !failed;
+
+	unguard;
+}
+
+void SetupExportWorker(int WorkerIndex, int NumWorkers)
+{
+	SetExportWorker(WorkerIndex, NumWorkers);
+
+	// Workers are sharing the export directory, use separate lists of exported files. Files are not
+	// deduplicated between workers: the same texture exported by 2 workers is written twice.
+	char IndexName[64];
+	appSprintf(ARRAY_ARG(IndexName), ".umodel_exported_%d", WorkerIndex);
+	SetExportDedupIndexName(IndexName);
+}
+
+
 void DisplayPackageStats(const TArray<UnPackage*> &Packages)
 {
 	if (Packages.Num() == 0)
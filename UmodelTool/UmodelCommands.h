@@ -10,6 +10,13 @@ bool ExportObjects(const TArray<UObject*> *Objects, IProgressCallback* progress
 // Export everything from provided package list.
 bool ExportPackages(const TArray<UnPackage*>& Packages, IProgressCallback* Progress = NULL);
 
+// Parallel export using worker processes. Each worker is started with the same command line plus
+// "-worker=Index/NumWorkers" option, and exports only packages it owns. Package owner is selected
+// with the hash of package path, so every object is exported exactly once, and export paths don't
+// depend on the number of workers.
+bool RunExportWorkers(int NumWorkers, int argc, const char** argv);
+void SetupExportWorker(int WorkerIndex, int NumWorkers);
+
 void DisplayPackageStats(const TArray<UnPackage*> &Packages);
 
 void SavePackages(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress = NULL);
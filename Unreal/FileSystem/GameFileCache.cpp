@@ -0,0 +1,300 @@
+#include "Core.h"
+#include "UnCore.h"
+#include "GameFileSystem.h"
+
+#include "Parallel.h"
+
+#if UNREAL4
+
+/*-----------------------------------------------------------------------------
+	Persistent game file cache
+
+	Cache file contains data of virtual file systems (pak file directories with
+	package scan results) from previous session. Each record is validated with
+	file name, size and modification time of the archive, and with hash of the
+	settings which affects parsing of the archive (AES key, game override).
+	Cache file is memory-mapped, and released after game directory scan.
+-----------------------------------------------------------------------------*/
+
+#define GAME_FILE_CACHE_MAGIC		0x43464D55		// 'UMFC'
+#define GAME_FILE_CACHE_VERSION		1				// increment when any cached data format changes
+
+struct CGameFileCacheRecord
+{
+	FString		Filename;
+	int64		Size;
+	int64		ModTime;
+	uint32		ContextHash;
+	// Data from the cache file (valid only while file is loaded)
+	int64		DataOffset;
+	int32		DataSize;
+	// VFS object from the current session, used for saving the cache
+	FVirtualFileSystem* Vfs;
+
+	CGameFileCacheRecord()
+	:	Size(0)
+	,	ModTime(0)
+	,	ContextHash(0)
+	,	DataOffset(0)
+	,	DataSize(0)
+	,	Vfs(NULL)
+	{}
+};
+
+static FString GGameFileCacheName;
+static TArray<CGameFileCacheRecord> GGameFileCacheRecords;
+static FMappedFileReader* GGameFileCacheReader = NULL;	// non-null while old cache is loaded
+static TArray<byte> GGameFileCacheBuffer;				// used when cache file couldn't be memory-mapped
+static bool GGameFileCacheChanged = false;
+static bool GGameFileCacheReadOnly = false;
+
+#if THREADING
+static CMutex GameFileCacheMutex;			// pak directories could be preloaded in worker threads
+#endif
+
+static uint32 GetCacheContextHash()
+{
+	// FNV-1a hash of everything which could affect VFS directory
+	uint32 hash = 0x811C9DC5;
+	for (const char* s = *GAesKey; *s; s++)
+	{
+		hash = (hash ^ (byte)*s) * 0x01000193;
+	}
+	hash = (hash ^ GForceGame) * 0x01000193;
+	return hash;
+}
+
+static const byte* GetCacheData()
+{
+	if (GGameFileCacheReader)
+		return GGameFileCacheReader->GetData();
+	return GGameFileCacheBuffer.GetData();
+}
+
+static void ReleaseCacheFile()
+{
+	if (GGameFileCacheReader)
+	{
+		delete GGameFileCacheReader;
+		GGameFileCacheReader = NULL;
+	}
+	GGameFileCacheBuffer.Empty();
+}
+
+static void LoadCacheFile()
+{
+	guard(LoadCacheFile);
+
+	FMappedFileReader* Reader = new FMappedFileReader(*GGameFileCacheName, FAO_NoOpenError);
+	if (Reader->IsOpen())
+	{
+		GGameFileCacheReader = Reader;
+	}
+	else
+	{
+		delete Reader;
+		// Mapping is not possible, read the file into memory
+		FILE* f = fopen(*GGameFileCacheName, "rb");
+		if (!f) return;
+		fseek(f, 0, SEEK_END);
+		int size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		GGameFileCacheBuffer.SetNumUninitialized(size > 0 ? size : 0);
+		bool ok = (size > 0) && fread(GGameFileCacheBuffer.GetData(), size, 1, f) == 1;
+		fclose(f);
+		if (!ok)
+		{
+			GGameFileCacheBuffer.Empty();
+			return;
+		}
+	}
+
+	int64 CacheSize = GGameFileCacheReader ? GGameFileCacheReader->GetFileSize64() : GGameFileCacheBuffer.Num();
+	bool bValid = false;
+
+	if (CacheSize >= 12)
+	{
+		FMemReader Ar(GetCacheData(), (int)min(CacheSize, (int64)0x7FFFFFFF));
+		Ar.Game = GAME_UE4_BASE;
+		int32 Magic, Version, NumRecords;
+		Ar << Magic << Version << NumRecords;
+		if (Magic == GAME_FILE_CACHE_MAGIC && Version == GAME_FILE_CACHE_VERSION && NumRecords >= 0)
+		{
+			TRY {
+				GGameFileCacheRecords.AddDefaulted(NumRecords);
+				for (int i = 0; i < NumRecords; i++)
+				{
+					CGameFileCacheRecord& R = GGameFileCacheRecords[i];
+					Ar << R.Filename << R.Size << R.ModTime << R.ContextHash << R.DataSize;
+					R.DataOffset = Ar.Tell();
+					if (R.DataSize < 0 || R.DataOffset + R.DataSize > CacheSize)
+						appError("Bad cache record");
+					Ar.Seek(R.DataOffset + R.DataSize);
+				}
+				bValid = true;
+			} CATCH {
+				// Damaged file, will be rebuilt
+				GError.Reset();
+			}
+		}
+	}
+
+	if (!bValid)
+	{
+		appPrintf("Game file cache \"%s\" is not valid, rebuilding\n", *GGameFileCacheName);
+		GGameFileCacheRecords.Empty();
+		ReleaseCacheFile();
+	}
+
+	unguard;
+}
+
+void appSetGameFileCache(const char* filename, bool readOnly)
+{
+	guard(appSetGameFileCache);
+
+	ReleaseCacheFile();
+	GGameFileCacheRecords.Empty();
+	GGameFileCacheName = filename;
+	GGameFileCacheChanged = false;
+	GGameFileCacheReadOnly = readOnly;
+	if (filename && filename[0])
+	{
+		LoadCacheFile();
+	}
+
+	unguard;
+}
+
+FArchive* appOpenGameFileCacheRecord(const char* Filename)
+{
+	guard(appOpenGameFileCacheRecord);
+
+	if (GGameFileCacheName.IsEmpty()) return NULL;
+
+	int64 Size, ModTime;
+	if (GetCacheData() && appGetFileSizeAndTime(Filename, Size, ModTime))
+	{
+		for (const CGameFileCacheRecord& R : GGameFileCacheRecords)
+		{
+			if (R.Vfs || stricmp(*R.Filename, Filename) != 0)
+				continue;
+			if (R.Size != Size || R.ModTime != ModTime || R.ContextHash != GetCacheContextHash())
+				break;
+			FMemReader* Reader = new FMemReader(GetCacheData() + R.DataOffset, R.DataSize);
+			Reader->Game = GAME_UE4_BASE;
+			return Reader;
+		}
+	}
+
+	// The file is not cached or was modified, cache should be updated
+	{
+#if THREADING
+		CMutex::ScopedLock Lock(GameFileCacheMutex);
+#endif
+		GGameFileCacheChanged = true;
+	}
+	return NULL;
+
+	unguardf("%s", Filename);
+}
+
+void appAddGameFileCacheRecord(const char* Filename, FVirtualFileSystem* vfs)
+{
+	guard(appAddGameFileCacheRecord);
+
+	if (GGameFileCacheName.IsEmpty()) return;
+
+	CGameFileCacheRecord* R = NULL;
+	for (CGameFileCacheRecord& Other : GGameFileCacheRecords)
+	{
+		if (!stricmp(*Other.Filename, Filename))
+		{
+			R = &Other;
+			break;
+		}
+	}
+	if (!R)
+	{
+		R = &GGameFileCacheRecords[GGameFileCacheRecords.AddDefaulted()];
+		R->Filename = Filename;
+	}
+
+	R->Vfs = vfs;
+	if (!appGetFileSizeAndTime(Filename, R->Size, R->ModTime))
+		R->Vfs = NULL;						// will not be saved
+	R->ContextHash = GetCacheContextHash();
+
+	unguardf("%s", Filename);
+}
+
+void appSaveGameFileCache(bool force)
+{
+	guard(appSaveGameFileCache);
+
+	if (GGameFileCacheName.IsEmpty()) return;
+
+	// Old cache data is not needed anymore
+	ReleaseCacheFile();
+
+	if (GGameFileCacheReadOnly) return;
+
+	// Remove records for files which were not found in this session
+	for (int i = GGameFileCacheRecords.Num() - 1; i >= 0; i--)
+	{
+		if (!GGameFileCacheRecords[i].Vfs)
+		{
+			GGameFileCacheRecords.RemoveAt(i);
+			GGameFileCacheChanged = true;
+		}
+	}
+
+	if (!force && !GGameFileCacheChanged) return;
+
+	// Write to a temporary file and then replace the cache file, so other processes which are reading
+	// the cache will not see a partially written file. Temporary file name is unique for the process,
+	// so different umodel instances are not writing the same file.
+	char TempName[MAX_PACKAGE_PATH];
+	appSprintf(ARRAY_ARG(TempName), "%s.%d.tmp", *GGameFileCacheName, appGetProcessId());
+	appMakeDirectoryForFile(TempName);
+
+	FArchive* Ar = new FFileWriter(TempName, FAO_NoOpenError);
+	if (!Ar->IsOpen())
+	{
+		appPrintf("WARNING: unable to write game file cache \"%s\"\n", TempName);
+		delete Ar;
+		return;
+	}
+	// Use the same serialization format for all cache data, it depends on the game
+	Ar->Game = GAME_UE4_BASE;
+
+	int32 Magic = GAME_FILE_CACHE_MAGIC, Version = GAME_FILE_CACHE_VERSION, NumRecords = GGameFileCacheRecords.Num();
+	*Ar << Magic << Version << NumRecords;
+
+	for (CGameFileCacheRecord& R : GGameFileCacheRecords)
+	{
+		FMemWriter Data;
+		Data.Game = GAME_UE4_BASE;
+		R.Vfs->SaveToCache(Data);
+		R.DataSize = Data.GetData().Num();
+		*Ar << R.Filename << R.Size << R.ModTime << R.ContextHash << R.DataSize;
+		Ar->Serialize(const_cast<byte*>(Data.GetData().GetData()), R.DataSize);
+	}
+	delete Ar;
+
+#if _WIN32
+	remove(*GGameFileCacheName);			// rename() doesn't replace existing files on Windows
+#endif
+	if (rename(TempName, *GGameFileCacheName) != 0)
+	{
+		appPrintf("WARNING: unable to write game file cache \"%s\"\n", *GGameFileCacheName);
+		remove(TempName);
+		return;
+	}
+
+	GGameFileCacheChanged = false;
+
+	unguard;
+}
+
+#endif // UNREAL4
@@ -348,29 +348,39 @@ int RegisterGameFolder(const char* FolderName)
 }
 
 
+// Open a file from OS file system. Files are memory-mapped when possible: reading doesn't require
+// system calls, and uncompressed pak file entries are copied directly from the mapped memory.
+static FArchive* CreateOSFileReader(const char* FullName)
+{
+	FMappedFileReader* MappedReader = new FMappedFileReader(FullName, FAO_NoOpenError);
+	if (MappedReader->IsOpen())
+		return MappedReader;
+	// Fallback to buffered reader
+	delete MappedReader;
+	return new FFileReader(FullName);
+}
+
 //!! add define USE_VFS = SUPPORT_ANDROID || UNREAL4, perhaps || SUPPORT_IOS
 
-static void RegisterGameFile(const char* FullName)
+// Find if this file in an archive with VFS inside. Returns NULL for regular files.
+static FVirtualFileSystem* CreateGameFileVFS(const char* FullName, FArchive*& reader)
 {
-	guard(RegisterGameFile);
-
-//	printf("..file %s\n", FullName);
+	guard(CreateGameFileVFS);
 
+	reader = NULL;
 	const char* ext = strrchr(FullName, '.');
-	if (ext == NULL) return;
+	if (ext == NULL) return NULL;
 
 	ext++;
 
-	// Find if this file in an archive with VFS inside
 	FVirtualFileSystem* vfs = NULL;
-	FArchive* reader = NULL;
 
 #if SUPPORT_ANDROID
 	if (!stricmp(ext, "obb"))
 	{
 		GForcePlatform = PLATFORM_ANDROID;
-		reader = new FFileReader(FullName);
-		if (!reader) return;
+		reader = CreateOSFileReader(FullName);
+		if (!reader) return NULL;
 		reader->Game = GAME_UE3;
 		vfs = new FObbVFS(FullName);
 	}
@@ -378,17 +388,37 @@ static void RegisterGameFile(const char* FullName)
 #if UNREAL4
 	if (!stricmp(ext, "pak"))
 	{
-		reader = new FFileReader(FullName);
-		if (!reader) return;
+		reader = CreateOSFileReader(FullName);
+		if (!reader) return NULL;
 		reader->Game = GAME_UE4_BASE;
 		vfs = new FPakVFS(FullName);
-		GIsUE4PackageMode = true; // ignore non-UE4 extensions for speedup file registration
 	}
 #endif // UNREAL4
+	return vfs;
+
+	unguardf("%s", FullName);
+}
+
+// Register a file. When file is an archive, 'vfs' and 'reader' are results of CreateGameFileVFS().
+static void RegisterGameFile(const char* FullName, FVirtualFileSystem* vfs, FArchive* reader)
+{
+	guard(RegisterGameFile);
+
+//	printf("..file %s\n", FullName);
+
+	const char* ext = strrchr(FullName, '.');
+	if (ext == NULL) return;
+
+	ext++;
+
 	//!! note: VFS pointer is not stored in any global list, and not released upon program exit
 	if (vfs)
 	{
 		assert(reader);
+#if UNREAL4
+		if (!stricmp(ext, "pak"))
+			GIsUE4PackageMode = true; // ignore non-UE4 extensions for speedup file registration
+#endif
 		// read VF directory
 		FString error;
 		if (!vfs->AttachReader(reader, error))
@@ -694,10 +724,37 @@ static bool ScanGameDirectory(const char *dir, bool recurse)
 			return stricmp(*p1, *p2) > 0;
 		});
 
+	// Open archive files and read their directories in parallel. Files from archives are registered
+	// later, in sorted order, so patch archives will override files from earlier archives.
+	struct CArchiveInfo
+	{
+		FVirtualFileSystem* Vfs;
+		FArchive* Reader;
+	};
+	TArray<CArchiveInfo> Archives;
+	Archives.AddZeroed(Filenames.Num());
+	int NumArchives = 0;
 	for (int i = 0; i < Filenames.Num(); i++)
 	{
 		appSprintf(ARRAY_ARG(Path), "%s/%s", dir, *Filenames[i]);
-		RegisterGameFile(Path);
+		CArchiveInfo& Archive = Archives[i];
+		Archive.Vfs = CreateGameFileVFS(Path, Archive.Reader);
+		if (Archive.Vfs) NumArchives++;
+	}
+	if (NumArchives > 1)
+	{
+		ParallelFor(Archives.Num(), [&Archives](int Index)
+			{
+				const CArchiveInfo& Archive = Archives[Index];
+				if (Archive.Vfs)
+					Archive.Vfs->PreloadDirectory(Archive.Reader);
+			}, 1);
+	}
+
+	for (int i = 0; i < Filenames.Num(); i++)
+	{
+		appSprintf(ARRAY_ARG(Path), "%s/%s", dir, *Filenames[i]);
+		RegisterGameFile(Path, Archives[i].Vfs, Archives[i].Reader);
 	}
 
 	return res;
@@ -720,6 +777,11 @@ void appSetRootDirectory(const char *dir, bool recurse)
 	appStrncpyz(GRootDirectory, dir, ARRAY_COUNT(GRootDirectory));
 	ScanGameDirectory(GRootDirectory, recurse);
 
+#if UNREAL4
+	// Update the game file cache if any pak file was added or changed
+	appSaveGameFileCache();
+#endif
+
 #if GEARS4
 	if (GForceGame == GAME_Gears4)
 	{
@@ -1213,7 +1275,7 @@ FArchive* CGameFileInfo::CreateReader() const
 		GetRelativeName(RelativeName);
 		char buf[MAX_PACKAGE_PATH];
 		appSprintf(ARRAY_ARG(buf), "%s/%s", GRootDirectory, *RelativeName);
-		return new FFileReader(buf);
+		return CreateOSFileReader(buf);
 	}
 	else
 	{
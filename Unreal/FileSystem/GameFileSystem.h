@@ -27,8 +27,16 @@ public:
 	// Attach FArchive which will be used for reading VFS content. This function should scan
 	// VFS directory. If function failed, it should return false and optionally fill error string.
 	virtual bool AttachReader(FArchive* reader, FString& error) = 0;
+	// Optional step performed before AttachReader(), could be executed in a worker thread. VFS
+	// could read and decode its directory here, but it should not register files: this is done
+	// later by AttachReader(), in the main thread and in the order of archive files.
+	virtual void PreloadDirectory(FArchive* reader)
+	{}
 	// Open a file from VFS.
 	virtual FArchive* CreateReader(int index) = 0;
+	// Store VFS directory to the game file cache. Data is loaded back by AttachReader().
+	virtual void SaveToCache(FArchive& Ar)
+	{}
 
 	// Reserve space for 'count' files
 	void Reserve(int count);
@@ -42,4 +50,15 @@ public:
 
 int RegisterGameFolder(const char* FolderName);
 
+#if UNREAL4
+
+// Find data stored to the game file cache for archive file. Returns NULL when cache is disabled,
+// or when file was not cached or was changed since cache was saved. Returned archive should be
+// deleted by the caller.
+FArchive* appOpenGameFileCacheRecord(const char* Filename);
+// Register VFS of archive file, its directory will be saved to the game file cache.
+void appAddGameFileCacheRecord(const char* Filename, FVirtualFileSystem* vfs);
+
+#endif // UNREAL4
+
 #endif // __GAME_FILE_SYSTEM_H__
@@ -25,10 +25,8 @@ public:
 		guard(FObbFile::Serialize);
 		if (ArStopper > 0 && ArPos + size > ArStopper)
 			appError("Serializing behind stopper (%X+%X > %X)", ArPos, size, ArStopper);
-		// seek every time in a case if the same 'Reader' was used by different FObbFile
-		// (this is a lightweight operation for buffered FArchive)
-		Reader->Seek64(Info->Pos + ArPos);
-		Reader->Serialize(data, size);
+		// use positional read in a case if the same 'Reader' was used by different FObbFile
+		Reader->ReadAt(Info->Pos + ArPos, data, size);
 		ArPos += size;
 		unguard;
 	}
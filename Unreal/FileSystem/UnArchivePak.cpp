@@ -4,6 +4,8 @@
 
 #include "UnArchivePak.h"
 
+#include "Parallel.h"
+
 #if UNREAL4
 
 #define PAK_FILE_MAGIC		0x5A6F12E1
@@ -278,6 +280,91 @@ void FPakEntry::DecodeFrom(const uint8* Data)
 	unguard;
 }
 
+static void DecompressPakBlock(const FPakEntry* Entry, int BlockIndex, byte* CompressedBlock, byte* Dest)
+{
+	const FPakCompressedBlock& Block = Entry->CompressionBlocks[BlockIndex];
+	int CompressedBlockSize = (int)(Block.CompressedEnd - Block.CompressedStart);
+	int BlockSize = Entry->CompressionBlockSize;
+	int UncompressedBlockSize = min(BlockSize, (int)Entry->UncompressedSize - BlockSize * BlockIndex); // don't pass file end
+	appDecompress(CompressedBlock, CompressedBlockSize, Dest, UncompressedBlockSize, Entry->CompressionMethod);
+}
+
+void FPakFile::DecompressBlocks(int FirstBlock, int NumBlocks, byte* Dest)
+{
+	guard(FPakFile::DecompressBlocks);
+
+	// Find the range of compressed data. Blocks are usually stored one after another, so this
+	// is a single contiguous read.
+	int64 ReadStart = Info->CompressionBlocks[FirstBlock].CompressedStart;
+	int64 ReadEnd = 0;
+	for (int BlockIndex = FirstBlock; BlockIndex < FirstBlock + NumBlocks; BlockIndex++)
+	{
+		const FPakCompressedBlock& Block = Info->CompressionBlocks[BlockIndex];
+		int64 BlockEnd = Block.CompressedEnd;
+		if (Info->bEncrypted)
+			BlockEnd = Block.CompressedStart + Align(Block.CompressedEnd - Block.CompressedStart, EncryptionAlign);
+		ReadStart = min(ReadStart, Block.CompressedStart);
+		ReadEnd = max(ReadEnd, BlockEnd);
+	}
+	int ReadSize = (int)(ReadEnd - ReadStart);
+
+	byte* CompressedData;
+	bool bOwnCompressedData = true;
+	if (MappedReader && MappedReader->GetData() && !Info->bEncrypted)
+	{
+		// Decompress directly from the mapped pak file
+		CompressedData = const_cast<byte*>(MappedReader->GetData()) + ReadStart;
+		bOwnCompressedData = false;
+	}
+	else
+	{
+		CompressedData = (byte*)appMallocNoInit(ReadSize);
+		Reader->ReadAt(ReadStart, CompressedData, ReadSize);
+	}
+	if (Info->bEncrypted)
+		PakRequireAesKey();
+
+	// Decompress blocks, each block has its own place in Dest. An error in a worker thread would
+	// terminate the process, so errors are only marked there, and raised later in this thread.
+	const FPakEntry* Entry = Info;
+	TArray<byte> FailedBlocks;
+	FailedBlocks.AddZeroed(NumBlocks);
+	ParallelFor(NumBlocks, [Entry, FirstBlock, ReadStart, CompressedData, Dest, &FailedBlocks](int Index)
+		{
+			int BlockIndex = FirstBlock + Index;
+			const FPakCompressedBlock& Block = Entry->CompressionBlocks[BlockIndex];
+			byte* CompressedBlock = CompressedData + (Block.CompressedStart - ReadStart);
+			if (Entry->bEncrypted)
+				appDecryptAES(CompressedBlock, Align((int)(Block.CompressedEnd - Block.CompressedStart), EncryptionAlign));
+			TRY
+			{
+				DecompressPakBlock(Entry, BlockIndex, CompressedBlock, Dest + Index * Entry->CompressionBlockSize);
+			}
+			CATCH
+			{
+				FailedBlocks[Index] = 1;
+			}
+		}, 1);
+
+	for (int Index = 0; Index < NumBlocks; Index++)
+	{
+		if (FailedBlocks[Index])
+		{
+			// Decompress the first failed block again, to raise its error here. Error history
+			// was written by worker threads, drop it.
+			GError.Reset();
+			int BlockIndex = FirstBlock + Index;
+			byte* CompressedBlock = CompressedData + (Info->CompressionBlocks[BlockIndex].CompressedStart - ReadStart);
+			DecompressPakBlock(Info, BlockIndex, CompressedBlock, Dest + Index * Info->CompressionBlockSize);
+		}
+	}
+
+	if (bOwnCompressedData)
+		appFree(CompressedData);
+
+	unguardf("blocks=%d+%d", FirstBlock, NumBlocks);
+}
+
 void FPakFile::Serialize(void *data, int size)
 {
 	PROFILE_IF(size >= 1024);
@@ -289,44 +376,61 @@ void FPakFile::Serialize(void *data, int size)
 	{
 		guard(SerializeCompressed);
 
+		int BlockSize = Info->CompressionBlockSize;
+		int NumBlocks = Info->CompressionBlocks.Num();
+
 		while (size > 0)
 		{
-			if ((UncompressedBuffer == NULL) || (ArPos < UncompressedBufferPos) || (ArPos >= UncompressedBufferPos + Info->CompressionBlockSize))
+			if ((UncompressedBuffer == NULL) || (ArPos < UncompressedBufferPos) || (ArPos >= UncompressedBufferPos + UncompressedBufferSize))
 			{
 				// buffer is not ready
-				if (UncompressedBuffer == NULL)
-				{
-					UncompressedBuffer = (byte*)appMallocNoInit((int)Info->CompressionBlockSize); // size of uncompressed block
-				}
-				// prepare buffer
-				int BlockIndex = ArPos / Info->CompressionBlockSize;
-				UncompressedBufferPos = Info->CompressionBlockSize * BlockIndex;
-
-				const FPakCompressedBlock& Block = Info->CompressionBlocks[BlockIndex];
-				int CompressedBlockSize = (int)(Block.CompressedEnd - Block.CompressedStart);
-				int UncompressedBlockSize = min((int)Info->CompressionBlockSize, (int)Info->UncompressedSize - UncompressedBufferPos); // don't pass file end
-				byte* CompressedData;
-				if (!Info->bEncrypted)
+				int BlockIndex = ArPos / BlockSize;
+
+				if (ArPos == BlockIndex * BlockSize)
 				{
-					CompressedData = (byte*)appMallocNoInit(CompressedBlockSize);
-					Reader->Seek64(Block.CompressedStart);
-					Reader->Serialize(CompressedData, CompressedBlockSize);
+					// Blocks which are completely covered by the request are decompressed directly to
+					// the destination memory. The last block of the file may be shorter than BlockSize.
+					int NumFullBlocks = (ArPos + size >= Info->UncompressedSize) ? NumBlocks - BlockIndex : size / BlockSize;
+					if (NumFullBlocks > 0)
+					{
+						if (NumFullBlocks > MaxBlocksPerRead)
+							NumFullBlocks = MaxBlocksPerRead;
+						DecompressBlocks(BlockIndex, NumFullBlocks, (byte*)data);
+						LastBlockIndex = BlockIndex + NumFullBlocks - 1;
+
+						int BytesRead = min(NumFullBlocks * BlockSize, (int)Info->UncompressedSize - ArPos);
+						ArPos += BytesRead;
+						size  -= BytesRead;
+						data  = OffsetPointer(data, BytesRead);
+						continue;
+					}
 				}
+
+				// Fill UncompressedBuffer. When blocks are requested one after another, read-ahead window
+				// is growing, so the following small reads will be served from memory.
+				int NumBufferBlocks = min(ReadAheadBlocks, NumBlocks - BlockIndex);
+				if (BlockIndex == LastBlockIndex + 1)
+					ReadAheadBlocks = min(ReadAheadBlocks * 2, max(MaxReadAheadSize / BlockSize, 1));
 				else
+					ReadAheadBlocks = 1;
+
+				int RequiredCapacity = NumBufferBlocks * BlockSize;
+				if (UncompressedBufferCapacity < RequiredCapacity)
 				{
-					int EncryptedSize = Align(CompressedBlockSize, EncryptionAlign);
-					CompressedData = (byte*)appMallocNoInit(EncryptedSize);
-					Reader->Seek64(Block.CompressedStart);
-					Reader->Serialize(CompressedData, EncryptedSize);
-					PakRequireAesKey();
-					appDecryptAES(CompressedData, EncryptedSize);
+					if (UncompressedBuffer)
+						appFree(UncompressedBuffer);
+					UncompressedBuffer = (byte*)appMallocNoInit(RequiredCapacity);
+					UncompressedBufferCapacity = RequiredCapacity;
 				}
-				appDecompress(CompressedData, CompressedBlockSize, UncompressedBuffer, UncompressedBlockSize, Info->CompressionMethod);
-				appFree(CompressedData);
+
+				DecompressBlocks(BlockIndex, NumBufferBlocks, UncompressedBuffer);
+				LastBlockIndex = BlockIndex + NumBufferBlocks - 1;
+				UncompressedBufferPos = BlockSize * BlockIndex;
+				UncompressedBufferSize = min(RequiredCapacity, (int)Info->UncompressedSize - UncompressedBufferPos);
 			}
 
 			// data is in buffer, copy it
-			int BytesToCopy = UncompressedBufferPos + Info->CompressionBlockSize - ArPos; // number of bytes until end of the buffer
+			int BytesToCopy = UncompressedBufferPos + UncompressedBufferSize - ArPos; // number of bytes until end of the buffer
 			if (BytesToCopy > size) BytesToCopy = size;
 			assert(BytesToCopy > 0);
 
@@ -359,12 +463,11 @@ void FPakFile::Serialize(void *data, int size)
 				// Should fetch block and decrypt it.
 				// Note: AES is block encryption, so we should always align read requests for correct decryption.
 				UncompressedBufferPos = ArPos & ~(EncryptionAlign - 1);
-				Reader->Seek64(Info->Pos + Info->StructSize + UncompressedBufferPos);
 				int RemainingSize = Info->Size - UncompressedBufferPos;
 				if (RemainingSize > EncryptedBufferSize)
 					RemainingSize = EncryptedBufferSize;
 				RemainingSize = Align(RemainingSize, EncryptionAlign); // align for AES, pak contains aligned data
-				Reader->Serialize(UncompressedBuffer, RemainingSize);
+				Reader->ReadAt(Info->Pos + Info->StructSize + UncompressedBufferPos, UncompressedBuffer, RemainingSize);
 				PakRequireAesKey();
 				appDecryptAES(UncompressedBuffer, RemainingSize);
 			}
@@ -390,12 +493,41 @@ void FPakFile::Serialize(void *data, int size)
 	{
 		guard(SerializeUncompressed);
 
-		// Pure data
-		// seek every time in a case if the same 'Reader' was used by different FPakFile
-		// (this is a lightweight operation for buffered FArchive)
-		Reader->Seek64(Info->Pos + Info->StructSize + ArPos);
-		Reader->Serialize(data, size);
-		ArPos += size;
+		// Pure data. Use positional reads, so the same 'Reader' could be shared by different FPakFile
+		// objects, possibly working in different threads.
+		if (ArPos + size > Info->UncompressedSize)
+			appError("Unable to read %d bytes at pos=0x%X", size, ArPos);
+		int64 DataPos = Info->Pos + Info->StructSize;
+		if (MappedReader || size >= UncompressedReadBufferSize / 2)
+		{
+			// Mapped file doesn't need buffering, and large blocks are read directly to the destination
+			Reader->ReadAt(DataPos + ArPos, data, size);
+			ArPos += size;
+		}
+		else
+		{
+			// Small reads are served from own buffer, otherwise each of them would be a system call
+			if (UncompressedBuffer == NULL)
+			{
+				UncompressedBuffer = (byte*)appMallocNoInit(UncompressedReadBufferSize);
+				UncompressedBufferCapacity = UncompressedReadBufferSize;
+			}
+			while (size > 0)
+			{
+				if (ArPos < UncompressedBufferPos || ArPos >= UncompressedBufferPos + UncompressedBufferSize)
+				{
+					UncompressedBufferPos = ArPos;
+					UncompressedBufferSize = min((int)UncompressedReadBufferSize, (int)Info->UncompressedSize - ArPos);
+					Reader->ReadAt(DataPos + ArPos, UncompressedBuffer, UncompressedBufferSize);
+				}
+				int OffsetInBuffer = ArPos - UncompressedBufferPos;
+				int BytesToCopy = min(UncompressedBufferSize - OffsetInBuffer, size);
+				memcpy(data, UncompressedBuffer + OffsetInBuffer, BytesToCopy);
+				ArPos += BytesToCopy;
+				size  -= BytesToCopy;
+				data  = OffsetPointer(data, BytesToCopy);
+			}
+		}
 
 		unguard;
 	}
@@ -439,11 +571,66 @@ void FPakVFS::CompactFilePath(FString& Path)
 }
 
 bool FPakVFS::AttachReader(FArchive* reader, FString& error)
+{
+	guard(FPakVFS::AttachReader);
+	PROFILE_LABEL(*Filename);
+
+	if (!IsPreloaded)
+	{
+		// PreloadDirectory() wasn't called, or it was unable to complete the work in a worker thread
+		ReadDirectory(reader, true);
+	}
+
+	if (CacheReader)
+	{
+		// Pick the pak directory from the game file cache
+		LoadFromCache(reader, *CacheReader);
+		delete CacheReader;
+		CacheReader = NULL;
+		appAddGameFileCacheRecord(*Filename, this);
+		return true;
+	}
+
+	if (!PreloadResult)
+	{
+		error = PreloadError;
+		return false;
+	}
+
+	RegisterPendingFiles();
+	appAddGameFileCacheRecord(*Filename, this);
+
+	// Print statistics
+	appPrintf("Pak %s: %d files", *Filename, FileInfos.Num());
+	if (NumEncryptedFiles)
+		appPrintf(" (%d encrypted)", NumEncryptedFiles);
+	if (strcmp(*MountPoint, "/") != 0)
+		appPrintf(", mount point: \"%s\"", *MountPoint);
+	appPrintf(", version %d\n", PakVersion);
+
+	return true;
+
+	unguardf("%s", *Filename);
+}
+
+void FPakVFS::PreloadDirectory(FArchive* reader)
+{
+	ReadDirectory(reader, false);
+}
+
+void FPakVFS::ReadDirectory(FArchive* reader, bool canAskKey)
 {
 	int mainVer = 0, subVer = 0;
 
 	guard(FPakVFS::ReadDirectory);
-	PROFILE_LABEL(*Filename);
+
+	IsPreloaded = true;
+	PreloadResult = false;
+
+	// Try to pick the pak directory from the game file cache
+	CacheReader = appOpenGameFileCacheRecord(*Filename);
+	if (CacheReader)
+		return;
 
 	// Pak file may have different header sizes, try them all
 	static const int OffsetsToTry[] = { FPakInfo::Size, FPakInfo::Size8, FPakInfo::Size8a, FPakInfo::Size9 };
@@ -456,7 +643,7 @@ bool FPakVFS::AttachReader(FArchive* reader, FString& error)
 		if (HeaderOffset <= 0)
 		{
 			// The file is too small
-			return false;
+			return;
 		}
 		reader->Seek64(HeaderOffset);
 
@@ -474,27 +661,34 @@ bool FPakVFS::AttachReader(FArchive* reader, FString& error)
 	if (info.Magic != PAK_FILE_MAGIC)
 	{
 		// We didn't find a pak header
-		return false;
-	}
-
-	if (info.Version > PakFile_Version_Latest)
-	{
-		appPrintf("WARNING: Pak file \"%s\" has unsupported version %d\n", *Filename, info.Version);
+		return;
 	}
 
-	mainVer = info.Version;
-
-	if (info.bEncryptedIndex)
+	if (info.bEncryptedIndex && GAesKey.Len() == 0)
 	{
+		if (!canAskKey)
+		{
+			// Asking for AES key should be done in the main thread, AttachReader() will do the work
+			IsPreloaded = false;
+			return;
+		}
 		if (!PakRequireAesKey(false))
 		{
 			char buf[1024];
 			appSprintf(ARRAY_ARG(buf), "WARNING: Pak \"%s\" has encrypted index. Skipping.", *Filename);
-			error = buf;
-			return false;
+			PreloadError = buf;
+			return;
 		}
 	}
 
+	if (info.Version > PakFile_Version_Latest)
+	{
+		appPrintf("WARNING: Pak file \"%s\" has unsupported version %d\n", *Filename, info.Version);
+	}
+
+	mainVer = info.Version;
+	PakVersion = info.Version;
+
 	// Read pak index
 
 	// Set PakVer
@@ -502,30 +696,64 @@ bool FPakVFS::AttachReader(FArchive* reader, FString& error)
 
 	reader->Seek64(info.IndexOffset);
 
-	bool result = false;
 	if (info.Version < PakFile_Version_PathHashIndex)
 	{
-		result = LoadPakIndexLegacy(reader, info, error);
+		PreloadResult = LoadPakIndexLegacy(reader, info, PreloadError);
 	}
 	else
 	{
-		result = LoadPakIndex(reader, info, error);
+		PreloadResult = LoadPakIndex(reader, info, PreloadError);
+	}
+
+	unguardf("%s, PakVer=%d.%d", *Filename, mainVer, subVer);
+}
+
+const char* FPakVFS::AllocPendingName(const char* Name)
+{
+	if (!PendingNames) PendingNames = new CMemoryChain();
+	int len = strlen(Name) + 1;
+	char* buf = (char*)PendingNames->Alloc(len, 1);
+	memcpy(buf, Name, len);
+	return buf;
+}
+
+void FPakVFS::RegisterPendingFiles()
+{
+	guard(FPakVFS::RegisterPendingFiles);
+
+	assert(PendingFiles.Num() == FileInfos.Num());
+	Reserve(FileInfos.Num());
+
+	TArray<int> Folders;
+	Folders.SetNumUninitialized(PendingFolders.Num());
+	for (int i = 0; i < PendingFolders.Num(); i++)
+	{
+		Folders[i] = RegisterGameFolder(PendingFolders[i]);
 	}
 
-	if (result)
+	for (int i = 0; i < FileInfos.Num(); i++)
 	{
-		// Print statistics
-		appPrintf("Pak %s: %d files", *Filename, FileInfos.Num());
-		if (NumEncryptedFiles)
-			appPrintf(" (%d encrypted)", NumEncryptedFiles);
-		if (strcmp(*MountPoint, "/") != 0)
-			appPrintf(", mount point: \"%s\"", *MountPoint);
-		appPrintf(", version %d\n", info.Version);
+		FPakEntry& E = FileInfos[i];
+		const FPendingFile& P = PendingFiles[i];
+		CRegisterFileInfo reg;
+		reg.Filename = P.Filename;
+		if (P.FolderIndex >= 0)
+			reg.FolderIndex = Folders[P.FolderIndex];
+		reg.Size = E.UncompressedSize;
+		reg.IndexInArchive = i;
+		E.FileInfo = RegisterFile(reg);
 	}
 
-	return result;
+	// Release memory used by names
+	PendingFiles.Empty();
+	PendingFolders.Empty();
+	if (PendingNames)
+	{
+		delete PendingNames;
+		PendingNames = NULL;
+	}
 
-	unguardf("PakVer=%d.%d", mainVer, subVer);
+	unguardf("%s", *Filename);
 }
 
 static bool ValidateString(FArchive& Ar)
@@ -647,7 +875,7 @@ bool FPakVFS::LoadPakIndexLegacy(FArchive* reader, const FPakInfo& info, FString
 
 	// Read file information
 	FileInfos.AddZeroed(count);
-	Reserve(count);
+	PendingFiles.SetNumUninitialized(count);
 
 	for (int i = 0; i < count; i++)
 	{
@@ -681,12 +909,10 @@ bool FPakVFS::LoadPakIndexLegacy(FArchive* reader, const FPakInfo& info, FString
 			E.CompressionMethod = COMPRESS_FIND;
 		}
 
-		// Register the file
-		CRegisterFileInfo reg;
-		reg.Filename = *CombinedPath;
-		reg.Size = E.UncompressedSize;
-		reg.IndexInArchive = i;
-		E.FileInfo = RegisterFile(reg);
+		// Queue the file for registration
+		FPendingFile& P = PendingFiles[i];
+		P.Filename = AllocPendingName(*CombinedPath);
+		P.FolderIndex = -1;
 
 		unguardf("Index=%d/%d", i, count);
 	}
@@ -768,7 +994,6 @@ bool FPakVFS::LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& erro
 		appPrintf("Empty pak file \"%s\"\n", *Filename);
 		return true;
 	}
-	Reserve(count);
 
 	// Process MountPoint
 	ValidateMountPoint(MountPoint);
@@ -839,6 +1064,7 @@ bool FPakVFS::LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& erro
 	// Now InfoReader points to the full index data, either with use of 'reader' or 'InfoReaderProxy'.
 	// Build "legacy" FileInfos array from new data format
 	FileInfos.AddZeroed(count);
+	PendingFiles.SetNumUninitialized(count);
 
 	guard(BuildFullDirectory);
 	int FileIndex = 0;
@@ -870,7 +1096,7 @@ bool FPakVFS::LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& erro
 		if (DirectoryPath[DirectoryPath.Len()-1] == '/')
 			DirectoryPath.RemoveAt(DirectoryPath.Len()-1, 1);
 
-		int FolderIndex = RegisterGameFolder(*DirectoryPath);
+		int FolderIndex = PendingFolders.Add(AllocPendingName(*DirectoryPath));
 
 		// Read size of FPakDirectory (DirectoryIndex::Value)
 		int32 NumFilesInDirectory;
@@ -913,13 +1139,10 @@ bool FPakVFS::LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& erro
 			assert(CompressionMethodIndex >= 0 && CompressionMethodIndex <= 4);
 			E.CompressionMethod = CompressionMethodIndex > 0 ? info.CompressionMethods[CompressionMethodIndex-1] : 0;
 
-			// Register the file
-			CRegisterFileInfo reg;
-			reg.Filename = *DirectoryFileName;
-			reg.FolderIndex = FolderIndex;
-			reg.Size = E.UncompressedSize;
-			reg.IndexInArchive = FileIndex;
-			E.FileInfo = RegisterFile(reg);
+			// Queue the file for registration
+			FPendingFile& P = PendingFiles[FileIndex];
+			P.Filename = AllocPendingName(*DirectoryFileName);
+			P.FolderIndex = FolderIndex;
 
 			FileIndex++;
 			unguard;
@@ -948,6 +1171,139 @@ bool FPakVFS::LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& erro
 	unguard;
 }
 
+// Serialize FPakEntry fields which are needed for reading the file, in the game file cache format
+static void SerializePakEntryForCache(FArchive& Ar, FPakEntry& E)
+{
+	Ar << E.Pos << E.Size << E.UncompressedSize << E.CompressionMethod << E.CompressionBlockSize;
+	Ar << E.CompressionBlocks << E.bEncrypted << E.StructSize;
+}
+
+void FPakVFS::SaveToCache(FArchive& Ar)
+{
+	guard(FPakVFS::SaveToCache);
+
+	int32 PakVersion = Reader ? Reader->ArLicenseeVer : 0;
+	Ar << PakVersion << MountPoint << NumEncryptedFiles;
+
+	// Build table of folders used by this pak file. Folder is saved as a string, because
+	// folder indices depends on the order of pak loading.
+	TArray<int32> FolderRemap;
+	FolderRemap.Init(-1, appGetGameFolderCount());
+	TArray<int32> Folders;
+	TArray<int32> EntryFolders;
+	EntryFolders.SetNumUninitialized(FileInfos.Num());
+	for (int i = 0; i < FileInfos.Num(); i++)
+	{
+		const CGameFileInfo* Info = FileInfos[i].FileInfo;
+		int32 FolderIndex = -1;
+		if (Info)
+		{
+			int32& Remap = FolderRemap[Info->FolderIndex];
+			if (Remap < 0)
+				Remap = Folders.Add(Info->FolderIndex);
+			FolderIndex = Remap;
+		}
+		EntryFolders[i] = FolderIndex;
+	}
+
+	int32 NumFolders = Folders.Num();
+	Ar << NumFolders;
+	for (int32 FolderIndex : Folders)
+	{
+		FString FolderName = CGameFileInfo::GetPathByIndex(FolderIndex);
+		Ar << FolderName;
+	}
+
+	int32 Count = FileInfos.Num();
+	Ar << Count;
+	FStaticString<MAX_PACKAGE_PATH> CleanName;
+	for (int i = 0; i < Count; i++)
+	{
+		FPakEntry& E = FileInfos[i];
+		const CGameFileInfo* Info = E.FileInfo;
+		Ar << EntryFolders[i];
+		if (Info)
+			Info->GetCleanName(CleanName);
+		else
+			CleanName.Empty();
+		Ar << CleanName;
+		SerializePakEntryForCache(Ar, E);
+		// Save package scan results, when file wasn't replaced with another pak file
+		byte bScanned = (Info && Info->IsPackageScanned && Info->FileSystem == this && Info->IndexInVfs == i);
+		Ar << bScanned;
+		if (bScanned)
+		{
+			uint16 NumSkeletalMeshes = Info->NumSkeletalMeshes, NumStaticMeshes = Info->NumStaticMeshes;
+			uint16 NumAnimations = Info->NumAnimations, NumTextures = Info->NumTextures;
+			Ar << NumSkeletalMeshes << NumStaticMeshes << NumAnimations << NumTextures;
+		}
+	}
+
+	unguardf("%s", *Filename);
+}
+
+void FPakVFS::LoadFromCache(FArchive* reader, FArchive& Ar)
+{
+	guard(FPakVFS::LoadFromCache);
+
+	Reader = reader;
+	Ar << reader->ArLicenseeVer << MountPoint << NumEncryptedFiles;
+
+	int32 NumFolders;
+	Ar << NumFolders;
+	TArray<int32> Folders;
+	Folders.SetNumUninitialized(NumFolders);
+	for (int i = 0; i < NumFolders; i++)
+	{
+		FStaticString<MAX_PACKAGE_PATH> FolderName;
+		Ar << FolderName;
+		Folders[i] = RegisterGameFolder(*FolderName);
+	}
+
+	int32 Count;
+	Ar << Count;
+	Reserve(Count);
+	FileInfos.AddZeroed(Count);
+	FStaticString<MAX_PACKAGE_PATH> CleanName;
+	for (int i = 0; i < Count; i++)
+	{
+		FPakEntry& E = FileInfos[i];
+		int32 FolderIndex;
+		Ar << FolderIndex << CleanName;
+		SerializePakEntryForCache(Ar, E);
+		byte bScanned;
+		Ar << bScanned;
+
+		if (FolderIndex >= 0)
+		{
+			CRegisterFileInfo reg;
+			reg.Filename = *CleanName;
+			reg.FolderIndex = Folders[FolderIndex];
+			reg.Size = E.UncompressedSize;
+			reg.IndexInArchive = i;
+			E.FileInfo = RegisterFile(reg);
+		}
+
+		if (bScanned)
+		{
+			uint16 NumSkeletalMeshes, NumStaticMeshes, NumAnimations, NumTextures;
+			Ar << NumSkeletalMeshes << NumStaticMeshes << NumAnimations << NumTextures;
+			if (CGameFileInfo* Info = E.FileInfo)
+			{
+				Info->IsPackageScanned = true;
+				Info->NumSkeletalMeshes = NumSkeletalMeshes;
+				Info->NumStaticMeshes = NumStaticMeshes;
+				Info->NumAnimations = NumAnimations;
+				Info->NumTextures = NumTextures;
+			}
+		}
+	}
+
+	appPrintf("Pak %s: %d files (cached)\n", *Filename, FileInfos.Num());
+
+	unguardf("%s", *Filename);
+}
+
 #if 0
 const FPakEntry* FPakVFS::FindFile(const char* name)
 {
@@ -114,7 +114,12 @@ public:
 	FPakFile(const FPakEntry* info, FArchive* reader)
 	:	Info(info)
 	,	Reader(reader)
+	,	MappedReader(reader->CastTo<FMappedFileReader>())
 	,	UncompressedBuffer(NULL)
+	,	UncompressedBufferSize(0)
+	,	UncompressedBufferCapacity(0)
+	,	LastBlockIndex(-1)
+	,	ReadAheadBlocks(1)
 	{}
 
 	virtual ~FPakFile()
@@ -150,17 +155,31 @@ public:
 		{
 			appFree(UncompressedBuffer);
 			UncompressedBuffer = NULL;
+			UncompressedBufferSize = 0;
+			UncompressedBufferCapacity = 0;
 		}
 	}
 
 	enum { EncryptionAlign = 16 }; // AES-specific constant
 	enum { EncryptedBufferSize = 256 }; //?? TODO: check - may be value 16 will be better for performance
+	enum { MaxReadAheadSize = 1 << 20 }; // limit for UncompressedBuffer when reading compressed file sequentially
+	enum { MaxBlocksPerRead = 64 }; // limit number of compressed blocks fetched from Reader at once
+	enum { UncompressedReadBufferSize = 64 * 1024 }; // buffer for small reads of uncompressed files
 
 protected:
 	const FPakEntry* Info;
 	FArchive*	Reader;
+	FMappedFileReader* MappedReader;		// non-null when Reader is memory-mapped, allows decompression without copying
 	byte*		UncompressedBuffer;
 	int			UncompressedBufferPos;
+	int			UncompressedBufferSize;		// number of valid bytes in UncompressedBuffer (not used for encrypted files)
+	int			UncompressedBufferCapacity;
+	int			LastBlockIndex;				// last decompressed block, used to detect sequential reading
+	int			ReadAheadBlocks;			// number of blocks decompressed to UncompressedBuffer at once
+
+	// Read compressed blocks [FirstBlock, FirstBlock+NumBlocks) with a single request to Reader,
+	// and decompress them to Dest in parallel.
+	void DecompressBlocks(int FirstBlock, int NumBlocks, byte* Dest);
 };
 
 
@@ -172,17 +191,27 @@ public:
 	,	Reader(NULL)
 //	,	HashTable(NULL)
 	,	NumEncryptedFiles(0)
+	,	IsPreloaded(false)
+	,	PreloadResult(false)
+	,	PakVersion(0)
+	,	CacheReader(NULL)
+	,	PendingNames(NULL)
 	{}
 
 	virtual ~FPakVFS()
 	{
 		delete Reader;
 //		if (HashTable) delete[] HashTable;
+		if (CacheReader) delete CacheReader;
+		if (PendingNames) delete PendingNames;
 	}
 
 	void CompactFilePath(FString& Path);
 
 	virtual bool AttachReader(FArchive* reader, FString& error);
+	virtual void PreloadDirectory(FArchive* reader);
+
+	virtual void SaveToCache(FArchive& Ar);
 
 	virtual FArchive* CreateReader(int index)
 	{
@@ -199,12 +228,38 @@ protected:
 	FStaticString<MAX_PACKAGE_PATH> MountPoint;
 	int					NumEncryptedFiles;
 
+	// Results of ReadDirectory(), used by AttachReader()
+	bool				IsPreloaded;
+	bool				PreloadResult;
+	FString				PreloadError;
+	int					PakVersion;
+	FArchive*			CacheReader;		// non-null when directory should be taken from the game file cache
+
+	// Files which are read from the pak index, but not registered yet. Registration is done in
+	// the main thread with RegisterPendingFiles(), because it modifies global file and folder lists.
+	struct FPendingFile
+	{
+		const char*		Filename;			// path relative to the mount point when FolderIndex is -1
+		int32			FolderIndex;		// index in PendingFolders
+	};
+	CMemoryChain*		PendingNames;
+	TArray<const char*>	PendingFolders;
+	TArray<FPendingFile> PendingFiles;		// matches FileInfos
+
+	const char* AllocPendingName(const char* Name);
+	void RegisterPendingFiles();
+
+	// Read pak header and index, could be called from any thread
+	void ReadDirectory(FArchive* reader, bool canAskKey);
+
 	void ValidateMountPoint(FString& MountPoint);
 
 	// UE4.24 and older
 	bool LoadPakIndexLegacy(FArchive* reader, const FPakInfo& info, FString& error);
 	// UE4.25 and newer
 	bool LoadPakIndex(FArchive* reader, const FPakInfo& info, FString& error);
+	// Directory stored with SaveToCache()
+	void LoadFromCache(FArchive* reader, FArchive& Ar);
 
 #if 0
 	enum { HASH_SIZE = 1024 };
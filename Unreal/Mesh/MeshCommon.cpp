@@ -5,8 +5,13 @@
 #include "UnrealMesh/UnMathTools.h"		// CVertexShare
 #include "UnrealMaterial/UnMaterial.h"
 
+#include "Parallel.h"
+
 #define STRIP_BINORMAL		1
 
+#define BUILD_TRIS_MIN_STEP	1024	// smallest number of triangles processed by a single thread at once
+#define BUILD_VERTS_MIN_STEP	4096	// the same for vertices
+
 // WARNING for BuildNnnCommon functions: do not access Verts[i] directly, use VERT macro only!
 #define VERT(n)		OffsetPointer(Verts, (n) * VertexSize)
 
@@ -14,7 +19,7 @@ void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const
 {
 	guard(BuildNormalsCommon);
 
-	int i, j;
+	int i;
 
 	// Find vertices to share.
 	// We are using very simple algorithm here: to share all vertices with the same position
@@ -30,17 +35,17 @@ void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const
 		Share.AddVertex(VERT(i)->Position, NullVec);
 	}
 
+	// Compute weighted face normal for each triangle corner in parallel. Sum them later in a single
+	// thread, in the same order as serial code would do, so the result doesn't depend on thread count.
 	CIndexBuffer::IndexAccessor_t Index = Indices.GetAccessor();
-	for (i = 0; i < Indices.Num() / 3; i++)
+	int NumTris = Indices.Num() / 3;
+	TArray<CVec3> cornerNorm;
+	cornerNorm.AddUninitialized(NumTris * 3);
+	ParallelFor(NumTris, [&](int Tri)
 	{
 		CMeshVertex *V[3];
-		CVec3 *N[3];
-		for (j = 0; j < 3; j++)
-		{
-			int idx = Index(i * 3 + j);				// index in Verts[]
-			V[j] = VERT(idx);
-			N[j] = &tmpNorm[Share.WedgeToVert[idx]]; // remap to shared verts
-		}
+		for (int j = 0; j < 3; j++)
+			V[j] = VERT(Index(Tri * 3 + j));	// index in Verts[]
 
 		// compute edges
 		CVec3 D[3];				// 0->1, 1->2, 2->0
@@ -52,26 +57,34 @@ void BuildNormalsCommon(CMeshVertex *Verts, int VertexSize, int NumVerts, const
 		cross(D[1], D[0], norm);
 		norm.Normalize();
 		// compute angles
-		for (j = 0; j < 3; j++) D[j].Normalize();
+		for (int j = 0; j < 3; j++) D[j].Normalize();
 		float angle[3];
 		angle[0] = acos(-dot(D[0], D[2]));
 		angle[1] = acos(-dot(D[0], D[1]));
 		angle[2] = acos(-dot(D[1], D[2]));
-		// add normals for triangle verts
-		for (j = 0; j < 3; j++)
-			VectorMA(*N[j], angle[j], norm);
-	}
+		// weighted normals for triangle verts
+		for (int j = 0; j < 3; j++)
+			VectorScale(norm, angle[j], cornerNorm[Tri * 3 + j]);
+	}, BUILD_TRIS_MIN_STEP);
+
+	// add normals for triangle verts
+	for (i = 0; i < NumTris * 3; i++)
+		tmpNorm[Share.WedgeToVert[Index(i)]].Add(cornerNorm[i]);	// remap to shared verts
 
 	// TODO: add "hard angle threshold" - do not share vertex between faces when angle between them
 	// is too large.
 
 	// normalize shared normals ...
-	for (i = 0; i < Share.Points.Num(); i++)
-		tmpNorm[i].Normalize();
+	ParallelFor(Share.Points.Num(), [&tmpNorm](int Point)
+	{
+		tmpNorm[Point].Normalize();
+	}, BUILD_VERTS_MIN_STEP);
 
 	// ... then place ("unshare") normals to Verts
-	for (i = 0; i < NumVerts; i++)
-		Pack(VERT(i)->Normal, tmpNorm[Share.WedgeToVert[i]]);
+	ParallelFor(NumVerts, [&](int Vert)
+	{
+		Pack(VERT(Vert)->Normal, tmpNorm[Share.WedgeToVert[Vert]]);
+	}, BUILD_VERTS_MIN_STEP);
 
 	unguard;
 }
@@ -81,8 +94,6 @@ void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer
 {
 	guard(BuildTangentsCommon);
 
-	int i, j;
-
 	// TODO: this is not a 100% correct algorithm. Here we're iterating over all indices, processing the
 	// same wedge as many times as many triangles using it, with overwriting previous results. We should
 	// accumulate tangent value between triangles, counting number of triangles using them in a first
@@ -92,13 +103,38 @@ void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer
 	// share tangent space due to mirored texture (i.e. vertex use different tangent vector direction
 	// for different triangles).
 	CIndexBuffer::IndexAccessor_t Index = Indices.GetAccessor();
-	for (i = 0; i < Indices.Num() / 3; i++)
+	int NumTris = Indices.Num() / 3;
+
+	// Triangles are processed in parallel, so find the last triangle corner referencing each wedge:
+	// only this corner stores its result, exactly as the last write in serial loop would do.
+	int NumVerts = 0;
+	for (int i = 0; i < NumTris * 3; i++)
+		NumVerts = max(NumVerts, Index(i) + 1);
+	TArray<int> lastCorner;
+	lastCorner.Init(-1, NumVerts);
+	for (int i = 0; i < NumTris * 3; i++)
+		lastCorner[Index(i)] = i;
+
+	// Tangent space is stored into temporary arrays, because writing binormal sign directly into
+	// Normal.W would race with other threads reading the same vertex normal.
+	TArray<CPackedNormal> tmpTangent;
+	tmpTangent.AddUninitialized(NumVerts);
+#if !STRIP_BINORMAL
+	TArray<CPackedNormal> tmpBinormal;
+	tmpBinormal.AddUninitialized(NumVerts);
+#else
+	TArray<float> tmpBinormalScale;
+	tmpBinormalScale.AddUninitialized(NumVerts);
+#endif
+
+	ParallelFor(NumTris, [&](int Tri)
 	{
 		CMeshVertex *V[3];
-		for (j = 0; j < 3; j++)
+		int idx[3];
+		for (int j = 0; j < 3; j++)
 		{
-			int idx = Index(i * 3 + j);
-			V[j] = VERT(idx);
+			idx[j] = Index(Tri * 3 + j);
+			V[j] = VERT(idx[j]);
 		}
 
 		// compute tangent
@@ -131,9 +167,9 @@ void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer
 		// now, tang is on triangle plane
 		// now we should place tangent orthogonal to normal, then normalize vector
 		float binormalScale = 1.0f;
-		for (j = 0; j < 3; j++)
+		for (int j = 0; j < 3; j++)
 		{
-			CMeshVertex &DW = *V[j];
+			const CMeshVertex &DW = *V[j];
 			CVecT normal;
 			Unpack(normal, DW.Normal);
 			float pos = dot(normal, tang);
@@ -141,7 +177,6 @@ void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer
 			CVecT tangent;
 			VectorMA(tang, -pos, normal, tangent);
 			tangent.Normalize();
-			Pack(DW.Tangent, tangent);		// store
 
 			CVecT binormal;
 			cross(normal, tangent, binormal);
@@ -158,14 +193,30 @@ void BuildTangentsCommon(CMeshVertex *Verts, int VertexSize, const CIndexBuffer
 				if ((p1 - p2) * (V[W1]->UV.V - V[W2]->UV.V) < 0)
 					binormalScale = -1.0f;
 			}
+			if (lastCorner[idx[j]] != Tri * 3 + j)
+				continue;				// this wedge will be overwritten by another triangle
+			Pack(tmpTangent[idx[j]], tangent);		// store
 #if !STRIP_BINORMAL
 			binormal.Scale(binormalScale);
-			Pack(DW.Binormal, binormal);	// store
+			Pack(tmpBinormal[idx[j]], binormal);	// store
 #else
-			DW.Normal.SetW(binormalScale);
+			tmpBinormalScale[idx[j]] = binormalScale;
 #endif
 		}
-	}
+	}, BUILD_TRIS_MIN_STEP);
+
+	// Place tangent space to Verts. Wedges not referenced by any triangle are left intact.
+	ParallelFor(NumVerts, [&](int Vert)
+	{
+		if (lastCorner[Vert] < 0) return;
+		CMeshVertex &DW = *VERT(Vert);
+		DW.Tangent = tmpTangent[Vert];
+#if !STRIP_BINORMAL
+		DW.Binormal = tmpBinormal[Vert];
+#else
+		DW.Normal.SetW(tmpBinormalScale[Vert]);
+#endif
+	}, BUILD_VERTS_MIN_STEP);
 
 	unguard;
 }
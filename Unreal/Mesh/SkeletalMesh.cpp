@@ -2,6 +2,7 @@
 #include "UnCore.h"
 #include "UnObject.h"		// for typeinfo
 #include "SkeletalMesh.h"
+#include "MathSSE2.h"
 
 
 /*-----------------------------------------------------------------------------
@@ -282,14 +283,23 @@ void CSkeletalMesh::FinalizeMesh()
 
 #define MAX_LINEAR_KEYS		4
 
-static int FindTimeKey(const TArray<float> &KeyTime, float Frame)
+// When Cursor is not NULL, it holds the key found by previous call. Frames are usually sampled in increasing
+// order, so the search starts from this key.
+static int FindTimeKey(const TAnimKeyArray<float> &KeyTime, float Frame, int* Cursor = NULL)
 {
 	guard(FindTimeKey);
 
 	// find index in time key array
 	int NumKeys = KeyTime.Num();
-	// *** binary search ***
 	int Low = 0, High = NumKeys-1;
+	if (Cursor && *Cursor < NumKeys && KeyTime[*Cursor] <= Frame)
+	{
+		// the key is either previous one or few keys after it
+		Low = *Cursor;
+		if (Low + MAX_LINEAR_KEYS < High && Frame < KeyTime[Low + MAX_LINEAR_KEYS])
+			High = Low + MAX_LINEAR_KEYS;
+	}
+	// *** binary search ***
 	while (Low + MAX_LINEAR_KEYS < High)
 	{
 		int Mid = (Low + High) / 2;
@@ -304,12 +314,16 @@ static int FindTimeKey(const TArray<float> &KeyTime, float Frame)
 	{
 		float CurrKeyTime = KeyTime[i];
 		if (Frame == CurrKeyTime)
-			return i;		// exact key
+			break;		// exact key
 		if (Frame < CurrKeyTime)
-			return (i > 0) ? i - 1 : 0;	// previous key
+		{
+			i = (i > 0) ? i - 1 : 0;	// previous key
+			break;
+		}
 	}
 	if (i > High)
 		i = High;
+	if (Cursor) *Cursor = i;
 	return i;
 
 	unguard;
@@ -318,10 +332,10 @@ static int FindTimeKey(const TArray<float> &KeyTime, float Frame)
 
 // In:  KeyTime, Frame, NumFrames, Loop
 // Out: X - previous key index, Y - next key index, F - fraction between keys
-static void GetKeyParams(const TArray<float> &KeyTime, float Frame, float NumFrames, bool Loop, int &X, int &Y, float &F)
+static void GetKeyParams(const TAnimKeyArray<float> &KeyTime, float Frame, float NumFrames, bool Loop, int &X, int &Y, float &F, int* Cursor)
 {
 	guard(GetKeyParams);
-	X = FindTimeKey(KeyTime, Frame);
+	X = FindTimeKey(KeyTime, Frame, Cursor);
 	Y = X + 1;
 	int NumTimeKeys = KeyTime.Num();
 	if (Y >= NumTimeKeys)
@@ -348,27 +362,56 @@ static void GetKeyParams(const TArray<float> &KeyTime, float Frame, float NumFra
 }
 
 
-// not 'static', because used in ExportPsa()
-void CAnimTrack::GetBonePosition(float Frame, float NumFrames, bool Loop, CVec3 &DstPos, CQuat &DstQuat) const
+// Keys for evenly spaced frames (without time array)
+static void GetUniformKeyParams(int NumKeys, float Frame, float NumFrames, bool Loop, int &X, int &Y, float &F)
+{
+	if (NumKeys > 1)
+	{
+		float Position = Frame / NumFrames * NumKeys;
+		X = appFloor(Position);
+		F = Position - X;
+		Y = X + 1;
+		if (Y >= NumKeys)
+		{
+			if (!Loop)
+			{
+				Y = NumKeys - 1;
+				F = 0;
+			}
+			else
+				Y = 0;
+		}
+	}
+	else
+	{
+		X = Y = 0;
+		F = 0;
+	}
+}
+
+
+struct CAnimKeyParams
 {
-	guard(CAnimTrack::GetBonePosition);
+	int		PosX, RotX;		// index of previous frame
+	int		PosY, RotY;		// index of next frame
+	float	PosF, RotF;		// fraction between X and Y for lerping
+};
 
+// Find keys used for lerping track at the specified Frame. Cursor is NULL or points to 2 ints, used
+// for translation and rotation time arrays.
+static void GetTrackKeyParams(const CAnimTrackData &Track, float Frame, float NumFrames, bool Loop, CAnimKeyParams &P, int* Cursor)
+{
 	// fast case: 1 frame only
-	if (KeyTime.Num() == 1 || NumFrames == 1 || Frame == 0)
+	if (Track.KeyTime.Num() == 1 || NumFrames == 1 || Frame == 0)
 	{
-		if (KeyPos.Num())  DstPos  = KeyPos[0];
-		if (KeyQuat.Num()) DstQuat = KeyQuat[0];
+		P.PosX = P.PosY = P.RotX = P.RotY = 0;
+		P.PosF = P.RotF = 0;
 		return;
 	}
 
-	// data for lerping
-	int posX, rotX;			// index of previous frame
-	int posY, rotY;			// index of next frame
-	float posF, rotF;		// fraction between X and Y for lerping
-
-	int NumTimeKeys = KeyTime.Num();
-	int NumPosKeys  = KeyPos.Num();
-	int NumRotKeys  = KeyQuat.Num();
+	int NumTimeKeys = Track.KeyTime.Num();
+	int NumPosKeys  = Track.KeyPos.Num();
+	int NumRotKeys  = Track.KeyQuat.Num();
 
 	if (NumTimeKeys)
 	{
@@ -376,91 +419,226 @@ void CAnimTrack::GetBonePosition(float Frame, float NumFrames, bool Loop, CVec3
 		assert(NumPosKeys <= 1 || NumPosKeys == NumTimeKeys);
 		assert(NumRotKeys == 1 || NumRotKeys == NumTimeKeys);
 
-		GetKeyParams(KeyTime, Frame, NumFrames, Loop, posX, posY, posF);
-		rotX = posX;
-		rotY = posY;
-		rotF = posF;
+		GetKeyParams(Track.KeyTime, Frame, NumFrames, Loop, P.PosX, P.PosY, P.PosF, Cursor);
+		P.RotX = P.PosX;
+		P.RotY = P.PosY;
+		P.RotF = P.PosF;
 
 		if (NumPosKeys <= 1)
 		{
-			posX = posY = 0;
-			posF = 0;
+			P.PosX = P.PosY = 0;
+			P.PosF = 0;
 		}
 		if (NumRotKeys == 1)
 		{
-			rotX = rotY = 0;
-			rotF = 0;
+			P.RotX = P.RotY = 0;
+			P.RotF = 0;
 		}
 	}
 	else
 	{
 		// empty KeyTime array - keys are evenly spaced on a time line
 		// note: KeyPos and KeyQuat sizes can be different
-		if (KeyPosTime.Num())
-		{
-			GetKeyParams(KeyPosTime, Frame, NumFrames, Loop, posX, posY, posF);
-		}
-		else if (NumPosKeys > 1)
-		{
-			float Position = Frame / NumFrames * NumPosKeys;
-			posX = appFloor(Position);
-			posF = Position - posX;
-			posY = posX + 1;
-			if (posY >= NumPosKeys)
-			{
-				if (!Loop)
-				{
-					posY = NumPosKeys - 1;
-					posF = 0;
-				}
-				else
-					posY = 0;
-			}
-		}
+		if (Track.KeyPosTime.Num())
+			GetKeyParams(Track.KeyPosTime, Frame, NumFrames, Loop, P.PosX, P.PosY, P.PosF, Cursor);
 		else
-		{
-			posX = posY = 0;
-			posF = 0;
-		}
+			GetUniformKeyParams(NumPosKeys, Frame, NumFrames, Loop, P.PosX, P.PosY, P.PosF);
 
-		if (KeyQuatTime.Num())
-		{
-			GetKeyParams(KeyQuatTime, Frame, NumFrames, Loop, rotX, rotY, rotF);
-		}
-		else if (NumRotKeys > 1)
+		if (Track.KeyQuatTime.Num())
+			GetKeyParams(Track.KeyQuatTime, Frame, NumFrames, Loop, P.RotX, P.RotY, P.RotF, Cursor ? Cursor + 1 : NULL);
+		else
+			GetUniformKeyParams(NumRotKeys, Frame, NumFrames, Loop, P.RotX, P.RotY, P.RotF);
+	}
+}
+
+
+// not 'static', because used in ExportPsa()
+void CAnimTrackData::GetBonePosition(float Frame, float NumFrames, bool Loop, CVec3 &DstPos, CQuat &DstQuat) const
+{
+	guard(CAnimTrackData::GetBonePosition);
+
+	CAnimKeyParams P;
+	GetTrackKeyParams(*this, Frame, NumFrames, Loop, P, NULL);
+
+	// get position
+	if (P.PosF > 0)
+		Lerp(KeyPos[P.PosX], KeyPos[P.PosY], P.PosF, DstPos);
+	else if (KeyPos.Num())		// do not change DstPos when no keys
+		DstPos = KeyPos[P.PosX];
+	// get orientation
+	if (P.RotF > 0)
+		Slerp(KeyQuat[P.RotX], KeyQuat[P.RotY], P.RotF, DstQuat);
+	else if (KeyQuat.Num())		// do not change DstQuat when no keys
+		DstQuat = KeyQuat[P.RotX];
+
+	unguard;
+}
+
+
+/*-----------------------------------------------------------------------------
+	CAnimPoseSampler
+-----------------------------------------------------------------------------*/
+
+/*
+	Rotations are interpolated with polynomial approximation of slerp, which has no trigonometric
+	functions and can process 4 quaternions at a time: D. Eberly, "A Fast and Accurate Algorithm for
+	Computing SLERP". sin(t*a)/sin(a) is computed as t * (1 + b1*(1 + b2*(1 + ... b8))), with
+	b[i] = (u[i]*t*t - v[i]) * (cos(a) - 1). Error is below 1e-6 when the angle between quaternions
+	is not larger than 60 degrees (bone rotation by 120 degrees between 2 keys); larger angles are
+	interpolated with Slerp().
+*/
+
+#define SLERP_NUM_TERMS				8
+#define SLERP_MIN_COSINE			0.5f
+#define SLERP_MU					1.85298109240830f	// correction of the last term
+
+// u[i] = 1 / (i * (2i+1)), v[i] = i / (2i+1)
+static const float SlerpU[SLERP_NUM_TERMS] =
+{
+	1.0f/3, 1.0f/10, 1.0f/21, 1.0f/36, 1.0f/55, 1.0f/78, 1.0f/105, SLERP_MU/136
+};
+static const float SlerpV[SLERP_NUM_TERMS] =
+{
+	1.0f/3, 2.0f/5, 3.0f/7, 4.0f/9, 5.0f/11, 6.0f/13, 7.0f/15, SLERP_MU*8/17
+};
+
+static void SlerpItemScalar(const CAnimPoseSampler::SlerpItem& S)
+{
+	const CQuat& A = *S.A;
+	const CQuat& B = *S.B;
+	float cosom = A.x * B.x + A.y * B.y + A.z * B.z + A.w * B.w;
+	float sign = 1;
+	if (cosom < 0)
+	{
+		cosom = -cosom;
+		sign  = -1;
+	}
+	if (cosom < SLERP_MIN_COSINE)
+	{
+		Slerp(A, B, S.Alpha, *S.Dst);
+		return;
+	}
+	float xm1 = cosom - 1;
+	float t = S.Alpha, d = 1.0f - t;
+	float tt = t * t, dd = d * d;
+	float cT = 1, cD = 1;
+	for (int i = SLERP_NUM_TERMS - 1; i >= 0; i--)
+	{
+		cT = 1 + (SlerpU[i] * tt - SlerpV[i]) * xm1 * cT;
+		cD = 1 + (SlerpU[i] * dd - SlerpV[i]) * xm1 * cD;
+	}
+	float scaleA = cD * d;
+	float scaleB = cT * t * sign;
+	CQuat& Dst = *S.Dst;
+	Dst.x = scaleA * A.x + scaleB * B.x;
+	Dst.y = scaleA * A.y + scaleB * B.y;
+	Dst.z = scaleA * A.z + scaleB * B.z;
+	Dst.w = scaleA * A.w + scaleB * B.w;
+}
+
+#if USE_SSE2
+
+static void SlerpItems4(const CAnimPoseSampler::SlerpItem* S)
+{
+	// Load quaternions and transpose them to x, y, z, w vectors
+	__m128 ax = _mm_loadu_ps(&S[0].A->x), ay = _mm_loadu_ps(&S[1].A->x), az = _mm_loadu_ps(&S[2].A->x), aw = _mm_loadu_ps(&S[3].A->x);
+	__m128 bx = _mm_loadu_ps(&S[0].B->x), by = _mm_loadu_ps(&S[1].B->x), bz = _mm_loadu_ps(&S[2].B->x), bw = _mm_loadu_ps(&S[3].B->x);
+	_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+	_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+	__m128 cosom = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+	__m128 sign = _mm_and_ps(cosom, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+	cosom = _mm_xor_ps(cosom, sign);			// abs(cosom)
+
+	__m128 t = _mm_setr_ps(S[0].Alpha, S[1].Alpha, S[2].Alpha, S[3].Alpha);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 d = _mm_sub_ps(one, t);
+	__m128 tt = _mm_mul_ps(t, t), dd = _mm_mul_ps(d, d);
+	__m128 xm1 = _mm_sub_ps(cosom, one);
+	__m128 cT = one, cD = one;
+	for (int i = SLERP_NUM_TERMS - 1; i >= 0; i--)
+	{
+		__m128 u = _mm_set1_ps(SlerpU[i]), v = _mm_set1_ps(SlerpV[i]);
+		cT = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, tt), v), xm1), cT));
+		cD = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, dd), v), xm1), cD));
+	}
+	__m128 scaleA = _mm_mul_ps(cD, d);
+	__m128 scaleB = _mm_xor_ps(_mm_mul_ps(cT, t), sign);
+
+	__m128 rx = _mm_add_ps(_mm_mul_ps(scaleA, ax), _mm_mul_ps(scaleB, bx));
+	__m128 ry = _mm_add_ps(_mm_mul_ps(scaleA, ay), _mm_mul_ps(scaleB, by));
+	__m128 rz = _mm_add_ps(_mm_mul_ps(scaleA, az), _mm_mul_ps(scaleB, bz));
+	__m128 rw = _mm_add_ps(_mm_mul_ps(scaleA, aw), _mm_mul_ps(scaleB, bw));
+	_MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+	_mm_storeu_ps(&S[0].Dst->x, rx);
+	_mm_storeu_ps(&S[1].Dst->x, ry);
+	_mm_storeu_ps(&S[2].Dst->x, rz);
+	_mm_storeu_ps(&S[3].Dst->x, rw);
+
+	// Rare case: large angle between keys, use precise slerp
+	int LargeAngleMask = _mm_movemask_ps(_mm_cmplt_ps(cosom, _mm_set1_ps(SLERP_MIN_COSINE)));
+	if (LargeAngleMask)
+	{
+		for (int i = 0; i < 4; i++)
 		{
-			float Position = Frame / NumFrames * NumRotKeys;
-			rotX = appFloor(Position);
-			rotF = Position - rotX;
-			rotY = rotX + 1;
-			if (rotY >= NumRotKeys)
-			{
-				if (!Loop)
-				{
-					rotY = NumRotKeys - 1;
-					rotF = 0;
-				}
-				else
-					rotY = 0;
-			}
+			if (LargeAngleMask & (1 << i))
+				Slerp(*S[i].A, *S[i].B, S[i].Alpha, *S[i].Dst);
 		}
-		else
+	}
+}
+
+#endif // USE_SSE2
+
+static void SlerpItems(const CAnimPoseSampler::SlerpItem* S, int Count)
+{
+	int i = 0;
+#if USE_SSE2
+	for ( ; i + 4 <= Count; i += 4)
+		SlerpItems4(S + i);
+#endif
+	for ( ; i < Count; i++)
+		SlerpItemScalar(S[i]);
+}
+
+CAnimPoseSampler::CAnimPoseSampler(const CAnimSequence& Seq, int InNumTracks)
+:	NumTracks(InNumTracks)
+,	NumFrames(Seq.NumFrames)
+{
+	Tracks = Seq.GetTracks();
+	Cursors.AddZeroed(NumTracks * 2);
+	Slerps.SetNumUninitialized(NumTracks);
+}
+
+void CAnimPoseSampler::SamplePose(float Frame, bool Loop, CVec3* DstPos, CQuat* DstQuat)
+{
+	guard(CAnimPoseSampler::SamplePose);
+
+	int NumSlerps = 0;
+	for (int TrackIndex = 0; TrackIndex < NumTracks; TrackIndex++)
+	{
+		const CAnimTrackData& Track = Tracks[TrackIndex];
+		CAnimKeyParams P;
+		GetTrackKeyParams(Track, Frame, NumFrames, Loop, P, &Cursors[TrackIndex * 2]);
+
+		// get position
+		if (P.PosF > 0)
+			Lerp(Track.KeyPos[P.PosX], Track.KeyPos[P.PosY], P.PosF, DstPos[TrackIndex]);
+		else if (Track.KeyPos.Num())		// do not change DstPos when no keys
+			DstPos[TrackIndex] = Track.KeyPos[P.PosX];
+		// get orientation; interpolation is deferred
+		if (P.RotF > 0)
 		{
-			rotX = rotY = 0;
-			rotF = 0;
+			SlerpItem& S = Slerps[NumSlerps++];
+			S.A = &Track.KeyQuat[P.RotX];
+			S.B = &Track.KeyQuat[P.RotY];
+			S.Alpha = P.RotF;
+			S.Dst = &DstQuat[TrackIndex];
 		}
+		else if (Track.KeyQuat.Num())		// do not change DstQuat when no keys
+			DstQuat[TrackIndex] = Track.KeyQuat[P.RotX];
 	}
 
-	// get position
-	if (posF > 0)
-		Lerp(KeyPos[posX], KeyPos[posY], posF, DstPos);
-	else if (NumPosKeys)		// do not change DstPos when no keys
-		DstPos = KeyPos[posX];
-	// get orientation
-	if (rotF > 0)
-		Slerp(KeyQuat[rotX], KeyQuat[rotY], rotF, DstQuat);
-	else if (NumRotKeys)		// do not change DstQuat when no keys
-		DstQuat = KeyQuat[rotX];
+	SlerpItems(Slerps.GetData(), NumSlerps);
 
 	unguard;
 }
@@ -474,3 +652,194 @@ void CAnimTrack::CopyFrom(const CAnimTrack &Src)
 	CopyArray(KeyQuatTime, Src.KeyQuatTime);
 	CopyArray(KeyPosTime,  Src.KeyPosTime );
 }
+
+
+/*-----------------------------------------------------------------------------
+	CAnimSequence
+-----------------------------------------------------------------------------*/
+
+#define ANIM_CACHE_DEFAULT_SIZE		256		// megabytes
+
+// Decoded sequences, most recently used one is at head. Animations are decoded and used from the
+// main thread only, so no locking is performed.
+static CAnimSequence* AnimCacheHead = NULL;
+static CAnimSequence* AnimCacheTail = NULL;
+static int64 AnimCacheSize = 0;
+static int64 AnimCacheLimit = (int64)ANIM_CACHE_DEFAULT_SIZE << 20;
+
+struct CAnimSequenceCache
+{
+	static void Unlink(CAnimSequence* S)
+	{
+		if (S->CachePrev) S->CachePrev->CacheNext = S->CacheNext; else AnimCacheHead = S->CacheNext;
+		if (S->CacheNext) S->CacheNext->CachePrev = S->CachePrev; else AnimCacheTail = S->CachePrev;
+		S->CachePrev = S->CacheNext = NULL;
+	}
+
+	static void Link(CAnimSequence* S)
+	{
+		S->CachePrev = NULL;
+		S->CacheNext = AnimCacheHead;
+		if (AnimCacheHead) AnimCacheHead->CachePrev = S; else AnimCacheTail = S;
+		AnimCacheHead = S;
+	}
+
+	static void Trim()
+	{
+		// Never release two most recently used sequences: their tracks are being accessed now, and the mesh
+		// viewer could blend two animations, which shouldn't cause decoding of both sequences for every bone
+		while (AnimCacheLimit && AnimCacheSize > AnimCacheLimit && AnimCacheTail != AnimCacheHead && AnimCacheTail != AnimCacheHead->CacheNext)
+			AnimCacheTail->FreeTracks();
+	}
+};
+
+void SetAnimTrackCacheSize(int SizeMB)
+{
+	AnimCacheLimit = (int64)max(SizeMB, 0) << 20;
+	CAnimSequenceCache::Trim();
+}
+
+CAnimSequence::~CAnimSequence()
+{
+	FreeTracks();
+}
+
+void CAnimSequence::FreeTracks()
+{
+	for (int i = 0; i < Tracks.Num(); i++)
+	{
+		delete Tracks[i];
+	}
+	Tracks.Empty();
+	if (TrackData)
+	{
+		if (DecodeTracks)
+		{
+			CAnimSequenceCache::Unlink(this);
+			AnimCacheSize -= TrackDataSize;
+		}
+		appFree(TrackData);
+		TrackData = NULL;
+		TrackDataSize = 0;
+	}
+}
+
+// Tracks released by PackTracks(), with allocated key arrays. Reused by AddTrack(), so decoding of a
+// sequence doesn't allocate memory for keys of every track again.
+static TArray<CAnimTrack*> FreeAnimTracks;
+
+CAnimTrack* CAnimSequence::AddTrack()
+{
+	CAnimTrack* Track;
+	if (FreeAnimTracks.Num())
+	{
+		Track = FreeAnimTracks.Last();
+		FreeAnimTracks.RemoveAt(FreeAnimTracks.Num() - 1);
+	}
+	else
+	{
+		Track = new CAnimTrack;
+	}
+	Tracks.Add(Track);
+	return Track;
+}
+
+template<typename T>
+static FORCEINLINE void PackKeys(TAnimKeyArray<T>& Dst, const TArray<T>& Src, T*& Buffer)
+{
+	Dst.Data = Buffer;
+	Dst.Count = Src.Num();
+	if (Dst.Count) memcpy(Buffer, Src.GetData(), Dst.Count * sizeof(T));
+	Buffer += Dst.Count;
+}
+
+// Move keys of all tracks into a single memory block, and put CAnimTrack objects to FreeAnimTracks
+void CAnimSequence::PackTracks()
+{
+	guard(CAnimSequence::PackTracks);
+
+	int NumTracks = Tracks.Num();
+	if (!NumTracks) return;
+
+	// Compute sizes of key arrays
+	int NumQuatKeys = 0, NumPosKeys = 0, NumTimeKeys = 0;
+	for (int i = 0; i < NumTracks; i++)
+	{
+		const CAnimTrack* T = Tracks[i];
+		NumQuatKeys += T->KeyQuat.Num();
+		NumPosKeys  += T->KeyPos.Num();
+		NumTimeKeys += T->KeyTime.Num() + T->KeyQuatTime.Num() + T->KeyPosTime.Num();
+	}
+
+	// Layout: track headers, rotation keys (16-byte aligned), translation keys, time keys
+	int HeaderSize = Align(NumTracks * (int)sizeof(CAnimTrackData), 16);
+	int Size = HeaderSize + NumQuatKeys * sizeof(CQuat) + NumPosKeys * sizeof(CVec3) + NumTimeKeys * sizeof(float);
+	TrackData = (CAnimTrackData*)appMallocNoInit(Size, 16);
+	TrackDataSize = Size;
+
+	CQuat* QuatKeys = (CQuat*)((byte*)TrackData + HeaderSize);
+	CVec3* PosKeys  = (CVec3*)(QuatKeys + NumQuatKeys);
+	float* TimeKeys = (float*)(PosKeys + NumPosKeys);
+	for (int i = 0; i < NumTracks; i++)
+	{
+		const CAnimTrack* T = Tracks[i];
+		CAnimTrackData& D = TrackData[i];
+		PackKeys(D.KeyQuat,     T->KeyQuat,     QuatKeys);
+		PackKeys(D.KeyPos,      T->KeyPos,      PosKeys);
+		PackKeys(D.KeyTime,     T->KeyTime,     TimeKeys);
+		PackKeys(D.KeyQuatTime, T->KeyQuatTime, TimeKeys);
+		PackKeys(D.KeyPosTime,  T->KeyPosTime,  TimeKeys);
+	}
+
+	// Keep key arrays allocated for the next decoded sequence
+	for (int i = 0; i < NumTracks; i++)
+	{
+		CAnimTrack* T = Tracks[i];
+		T->KeyQuat.Reset();
+		T->KeyPos.Reset();
+		T->KeyTime.Reset();
+		T->KeyQuatTime.Reset();
+		T->KeyPosTime.Reset();
+		FreeAnimTracks.Add(T);
+	}
+	Tracks.Empty();
+
+	unguard;
+}
+
+void CAnimSequence::LoadTracks() const
+{
+	CAnimSequence* Seq = const_cast<CAnimSequence*>(this);
+	if (TrackData)
+	{
+		// Already decoded, move to the list head
+		if (DecodeTracks && AnimCacheHead != this)
+		{
+			CAnimSequenceCache::Unlink(Seq);
+			CAnimSequenceCache::Link(Seq);
+		}
+		return;
+	}
+
+	guard(CAnimSequence::LoadTracks);
+
+	// Sequences without DecodeTracks have CAnimTrack's created by the converter
+	if (DecodeTracks)
+		DecodeTracks(Seq);
+	Seq->PackTracks();
+
+	if (DecodeTracks && TrackData)
+	{
+		AnimCacheSize += TrackDataSize;
+		CAnimSequenceCache::Link(Seq);
+		CAnimSequenceCache::Trim();
+	}
+
+	unguardf("%s", *Name);
+}
+
+void CAnimSequence::ReleaseTracks() const
+{
+	if (DecodeTracks)
+		const_cast<CAnimSequence*>(this)->FreeTracks();
+}
@@ -225,12 +225,16 @@ private:
 	  - UAnimSequence is always has at least one key for excluded bone (there is no empty arrays)
 */
 
-/*!!
-	Warning: very unoptimal data format. Each CAnimSequence has NumBones CAnimTrack's, each CAnimTrack has up to 5 arrays.
-	Ideally should put all the data into CAnimSequence as a single data block (like was done for UAnimSequence).
+/*
+	Animation data layout: converters fill CAnimTrack objects for each bone (CAnimSequence.Tracks), then
+	all keys of the sequence are moved into a single memory block, with separate contiguous arrays for
+	rotation, translation and time keys of all tracks. Tracks are accessed as CAnimTrackData views into
+	this block. CAnimTrack objects are reused for decoding of the next sequence with their key arrays
+	still allocated, so decoders should fill these arrays with Reset() instead of Empty().
 */
 
 
+// Track data used while converting animation
 struct CAnimTrack
 {
 	TStaticArray<CQuat, 1>	KeyQuat;
@@ -241,39 +245,154 @@ struct CAnimTrack
 	TStaticArray<float, 1>	KeyQuatTime;
 	TStaticArray<float, 1>	KeyPosTime;
 
+	inline bool HasKeys() const
+	{
+		return (KeyQuat.Num() + KeyPos.Num()) > 0;
+	}
+	void CopyFrom(const CAnimTrack &Src);
+};
+
+// Copy keys into CAnimTrack array reusing its memory
+template<typename T>
+FORCEINLINE void CopyTrackKeys(TArray<T>& Dst, const TArray<T>& Src)
+{
+	int Count = Src.Num();
+	Dst.Reset(Count);
+	if (Count)
+	{
+		Dst.AddUninitialized(Count);
+		memcpy(Dst.GetData(), Src.GetData(), Count * sizeof(T));
+	}
+}
+
+
+// Read-only array of keys placed in CAnimSequence key buffer
+template<typename T>
+struct TAnimKeyArray
+{
+	const T*				Data;
+	int						Count;
+
+	FORCEINLINE int Num() const
+	{
+		return Count;
+	}
+	FORCEINLINE const T& operator[](int index) const
+	{
+		return Data[index];
+	}
+};
+
+
+// Packed track, has the same fields as CAnimTrack
+struct CAnimTrackData
+{
+	TAnimKeyArray<CQuat>	KeyQuat;
+	TAnimKeyArray<CVec3>	KeyPos;
+	TAnimKeyArray<float>	KeyTime;
+	TAnimKeyArray<float>	KeyQuatTime;
+	TAnimKeyArray<float>	KeyPosTime;
+
 	// DstPos and DstQuat will not be changed when KeyPos and KeyQuat are empty
 	void GetBonePosition(float Frame, float NumFrames, bool Loop, CVec3 &DstPos, CQuat &DstQuat) const;
 	inline bool HasKeys() const
 	{
 		return (KeyQuat.Num() + KeyPos.Num()) > 0;
 	}
-	void CopyFrom(const CAnimTrack &Src);
 };
 
 
+/*
+	Lazy conversion: when DecodeTracks is set, Tracks are empty after loading and are filled from the
+	original compressed sequence on the first GetTracks() call. Decoded tracks are kept in a cache of
+	limited size, least recently used sequences are released and will be decoded again when needed.
+	Sequences without DecodeTracks have Tracks filled by the converter and never release them.
+*/
+
 class CAnimSequence
 {
 public:
 	FName					Name;					// sequence's name
 	int						NumFrames;
 	float					Rate;
-	TArray<CAnimTrack*>		Tracks;					// for each CAnimSet.TrackBoneNames
+	TArray<CAnimTrack*>		Tracks;					// for each CAnimSet.TrackBoneNames; packed by GetTracks()
 	bool					bAdditive;				// used just for on-screen information
 #if ANIM_DEBUG_INFO
 	FString					DebugInfo;
 #endif
+	// lazy conversion support
+	UObject*				OriginalAnim;			// object which has converted the sequence (UAnimSet, USkeleton)
+	UObject*				OriginalSequence;		// compressed source sequence
+	void					(*DecodeTracks)(CAnimSequence* Seq);
 
 	CAnimSequence()
-	: bAdditive(false)
+	:	bAdditive(false)
+	,	OriginalAnim(NULL)
+	,	OriginalSequence(NULL)
+	,	DecodeTracks(NULL)
+	,	TrackData(NULL)
+	,	TrackDataSize(0)
+	,	CachePrev(NULL)
+	,	CacheNext(NULL)
 	{}
 
-	~CAnimSequence()
+	~CAnimSequence();
+
+	// Returns packed track for each CAnimSet.TrackBoneNames. Returned pointer remains valid until
+	// GetTracks() is called for 2 other sequences, or until ReleaseTracks().
+	const CAnimTrackData* GetTracks() const
 	{
-		for (int i = 0; i < Tracks.Num(); i++)
-		{
-			delete Tracks[i];
-		}
+		LoadTracks();
+		return TrackData;
 	}
+	// Free decoded tracks when they could be decoded again, used to process sequences one by one
+	void ReleaseTracks() const;
+
+	// Add an empty track for DecodeTracks. Returned track could be previously used by another sequence.
+	CAnimTrack* AddTrack();
+
+protected:
+	friend struct CAnimSequenceCache;
+	void LoadTracks() const;
+	void PackTracks();
+	void FreeTracks();
+
+	CAnimTrackData*			TrackData;				// single memory block with track headers followed by keys
+	int						TrackDataSize;
+	CAnimSequence*			CachePrev;				// list of decoded sequences, most recently used one is at head
+	CAnimSequence*			CacheNext;
+};
+
+// Set memory limit for decoded animation tracks, 0 = no limit
+void SetAnimTrackCacheSize(int SizeMB);
+
+
+// Computes positions of all bones of a sequence at once. Frames are expected to grow between SamplePose()
+// calls: keys are found by moving per-track cursors instead of searching time arrays from scratch, and
+// rotations are interpolated in batches.
+class CAnimPoseSampler
+{
+public:
+	CAnimPoseSampler(const CAnimSequence& Seq, int NumTracks);
+
+	// DstPos and DstQuat have NumTracks items. Items are not changed for tracks without keys, the same
+	// way as with CAnimTrackData::GetBonePosition().
+	void SamplePose(float Frame, bool Loop, CVec3* DstPos, CQuat* DstQuat);
+
+	struct SlerpItem
+	{
+		const CQuat*		A;
+		const CQuat*		B;
+		float				Alpha;
+		CQuat*				Dst;
+	};
+
+protected:
+	const CAnimTrackData*	Tracks;
+	int						NumTracks;
+	float					NumFrames;
+	TArray<int>				Cursors;				// 2 per track: for translation and rotation time arrays
+	TArray<SlerpItem>		Slerps;
 };
 
 
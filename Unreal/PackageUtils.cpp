@@ -6,6 +6,8 @@
 
 #include "PackageUtils.h"
 
+#include "Parallel.h"
+
 /*-----------------------------------------------------------------------------
 	Package loader/unloader
 -----------------------------------------------------------------------------*/
@@ -92,34 +94,24 @@ void ReleaseAllObjects()
 	Package version scanner
 -----------------------------------------------------------------------------*/
 
-struct ScanPackageData
+// Number of packages processed in parallel between progress updates
+#define SCAN_BATCH_SIZE			64
+
+#define VERSION_HASH_SIZE		64
+
+struct ScanPackageResult
 {
-	ScanPackageData()
-	:	Progress(NULL)
-	,	Cancelled(false)
-	,	Index(0)
-	{}
-
-	TArray<FileInfo>*	PkgInfo;
-	IProgressCallback*	Progress;
-	bool				Cancelled;
-	int					Index;
+	int			Ver;
+	int			LicVer;
+	bool		IsValid;
 };
 
-static bool ScanPackage(const CGameFileInfo *file, ScanPackageData &data)
+// Read package version from file header. Could be called from any thread.
+static void ScanPackage(const CGameFileInfo *file, ScanPackageResult &Result)
 {
 	guard(ScanPackage);
 
-	if (data.Progress)
-	{
-		FStaticString<MAX_PACKAGE_PATH> RelativeName;
-		file->GetRelativeName(RelativeName);
-		if (!data.Progress->Progress(*RelativeName, data.Index++, GNumPackageFiles))
-		{
-			data.Cancelled = true;
-			return false;
-		}
-	}
+	Result.IsValid = false;
 
 	// read a few first bytes as integers
 	FArchive *Ar = file->CreateReader();
@@ -138,69 +130,116 @@ static bool ScanPackage(const CGameFileInfo *file, ScanPackageData &data)
 		//!! Use CreatePackageLoader() here to allow scanning of packages with custom header (Lineage etc);
 		//!! do that only when something "strange" within data noticed.
 		//!! Also, this function could react on custom package tags.
-		return true;
+		return;
 	}
 	uint32 Version = FileData[1];
 
-	FileInfo Info;
-
 #if UNREAL4
 	if ((Version & 0xFFFFF000) == 0xFFFFF000)
 	{
 		// next fields are: int VersionUE3, Version, LicenseeVersion
-		Info.Ver    = FileData[3];
-		Info.LicVer = FileData[4];
+		Result.Ver    = FileData[3];
+		Result.LicVer = FileData[4];
 	}
 	else
 #endif // UNREAL4
 	{
-		Info.Ver    = Version & 0xFFFF;
-		Info.LicVer = Version >> 16;
+		Result.Ver    = Version & 0xFFFF;
+		Result.LicVer = Version >> 16;
 	}
-
-	Info.Count  = 0;
-	FStaticString<MAX_PACKAGE_PATH> RelativeName;
-	file->GetRelativeName(RelativeName);
-	strcpy(Info.FileName, *RelativeName);
-//	printf("%s - %d/%d\n", *RelativeName, Info.Ver, Info.LicVer);
-	int Index = INDEX_NONE;
-	for (int i = 0; i < data.PkgInfo->Num(); i++)
-	{
-		FileInfo &Info2 = (*data.PkgInfo)[i];
-		if (Info2.Ver == Info.Ver && Info2.LicVer == Info.LicVer)
-		{
-			Index = i;
-			break;
-		}
-	}
-	if (Index == INDEX_NONE)
-		Index = data.PkgInfo->Add(Info);
-	// update info
-	FileInfo& fileInfo = (*data.PkgInfo)[Index];
-	fileInfo.Count++;
-	// combine filename
-	char *s = fileInfo.FileName;
-	char *d = Info.FileName;
-	while (*s == *d && *s != 0)
-	{
-		s++;
-		d++;
-	}
-	*s = 0;
-
-	return true;
+	Result.IsValid = true;
 
 	unguardf("%s", *file->GetRelativeName());
 }
 
-
 bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress)
 {
+	guard(ScanPackageVersions);
+
 	info.Empty();
-	ScanPackageData data;
-	data.PkgInfo = &info;
-	data.Progress = progress;
-	appEnumGameFiles(ScanPackage, data);
+
+	TArray<const CGameFileInfo*> Files;
+	Files.Empty(GNumPackageFiles);
+	appEnumGameFiles<TArray<const CGameFileInfo*> >(
+		[](const CGameFileInfo* file, TArray<const CGameFileInfo*>& param) -> bool
+		{
+			param.Add(file);
+			return true;
+		}, Files);
+
+	// Hash for finding FileInfo with the same version
+	int VersionHash[VERSION_HASH_SIZE];
+	for (int i = 0; i < VERSION_HASH_SIZE; i++)
+		VersionHash[i] = INDEX_NONE;
+	TArray<int> VersionHashNext;
+
+	ScanPackageResult Results[SCAN_BATCH_SIZE];
+	bool Cancelled = false;
+
+	for (int First = 0; First < Files.Num(); First += SCAN_BATCH_SIZE)
+	{
+		int Count = min(Files.Num() - First, SCAN_BATCH_SIZE);
+
+		if (progress)
+		{
+			FStaticString<MAX_PACKAGE_PATH> RelativeName;
+			Files[First]->GetRelativeName(RelativeName);
+			if (!progress->Progress(*RelativeName, First, Files.Num()))
+			{
+				Cancelled = true;
+				break;
+			}
+		}
+
+		// Read headers in parallel
+		ParallelFor(Count, [&Files, &Results, First](int Index)
+			{
+				ScanPackage(Files[First + Index], Results[Index]);
+			}, 1);
+
+		// Merge results in the file order, so result doesn't depend on threads timing
+		for (int i = 0; i < Count; i++)
+		{
+			const ScanPackageResult& Result = Results[i];
+			if (!Result.IsValid) continue;
+
+			FStaticString<MAX_PACKAGE_PATH> RelativeName;
+			Files[First + i]->GetRelativeName(RelativeName);
+//			printf("%s - %d/%d\n", *RelativeName, Result.Ver, Result.LicVer);
+
+			int Hash = (Result.Ver ^ (Result.LicVer * 31)) & (VERSION_HASH_SIZE - 1);
+			int Index;
+			for (Index = VersionHash[Hash]; Index != INDEX_NONE; Index = VersionHashNext[Index])
+			{
+				const FileInfo &Info2 = info[Index];
+				if (Info2.Ver == Result.Ver && Info2.LicVer == Result.LicVer)
+					break;
+			}
+			if (Index == INDEX_NONE)
+			{
+				Index = info.AddZeroed();
+				FileInfo& NewInfo = info[Index];
+				NewInfo.Ver    = Result.Ver;
+				NewInfo.LicVer = Result.LicVer;
+				appStrncpyz(NewInfo.FileName, *RelativeName, ARRAY_COUNT(NewInfo.FileName));
+				VersionHashNext.Add(VersionHash[Hash]);
+				VersionHash[Hash] = Index;
+			}
+			// update info
+			FileInfo& fileInfo = info[Index];
+			fileInfo.Count++;
+			// combine filename
+			char *s = fileInfo.FileName;
+			const char *d = *RelativeName;
+			while (*s == *d && *s != 0)
+			{
+				s++;
+				d++;
+			}
+			*s = 0;
+		}
+	}
+
 	info.Sort([](const FileInfo& p1, const FileInfo& p2) -> int
 		{
 			int dif = p1.Ver - p2.Ver;
@@ -208,7 +247,9 @@ bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress)
 			return p1.LicVer - p2.LicVer;
 		});
 
-	return !data.Cancelled;
+	return !Cancelled;
+
+	unguard;
 }
 
 
@@ -216,20 +257,24 @@ bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress)
 	Package content
 -----------------------------------------------------------------------------*/
 
-static void ScanPackageExports(UnPackage* package, CGameFileInfo* file)
+static void ScanPackageExports(const UnPackage* package, FPackageSummaryInfo& Info)
 {
+	Info.Ver    = package->ArVer;
+	Info.LicVer = package->ArLicenseeVer;
+	Info.NumSkeletalMeshes = Info.NumStaticMeshes = Info.NumAnimations = Info.NumTextures = 0;
+
 	for (int idx = 0; idx < package->Summary.ExportCount; idx++)
 	{
 		const char* ObjectClass = package->GetObjectName(package->GetExport(idx).ClassIndex);
 
 		if (!stricmp(ObjectClass, "SkeletalMesh") || !stricmp(ObjectClass, "DestructibleMesh"))
-			file->NumSkeletalMeshes++;
+			Info.NumSkeletalMeshes++;
 		else if (!stricmp(ObjectClass, "StaticMesh"))
-			file->NumStaticMeshes++;
+			Info.NumStaticMeshes++;
 		else if (!stricmp(ObjectClass, "Animation") || !stricmp(ObjectClass, "MeshAnimation") || !stricmp(ObjectClass, "AnimSequence")) // whole AnimSet count for UE2 and number of sequences for UE3+
-			file->NumAnimations++;
+			Info.NumAnimations++;
 		else if (!strnicmp(ObjectClass, "Texture", 7))
-			file->NumTextures++;
+			Info.NumTextures++;
 	}
 /*	for (int j = 0; j < package->Summary.NameCount; j++)
 	{
@@ -240,6 +285,26 @@ static void ScanPackageExports(UnPackage* package, CGameFileInfo* file)
 	} */
 }
 
+bool ReadPackageSummary(const CGameFileInfo* File, FPackageSummaryInfo& Info)
+{
+	guard(ReadPackageSummary);
+
+	// Use already loaded package when possible
+	if (File->Package)
+	{
+		ScanPackageExports(File->Package, Info);
+		return true;
+	}
+
+	UnPackage* package = UnPackage::LoadPackageHeader(File);
+	if (!package) return false;
+	ScanPackageExports(package, Info);
+	UnPackage::UnloadPackage(package);
+	return true;
+
+	unguardf("%s", *File->GetRelativeName());
+}
+
 bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress)
 {
 #if PROFILE
@@ -248,46 +313,66 @@ bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback
 	bool cancelled = false;
 	bool scanned = false; // says if anywhing was scanned or not, just for profiler message
 
-	// Preallocate PackageMap
-	UnPackage::ReservePackageMap(Packages.Num());
-
+	// Collect packages which should be scanned, remember their indices for progress display
+	TArray<CGameFileInfo*> Files;
+	TArray<int> FileIndices;
 	for (int i = 0; i < Packages.Num(); i++)
 	{
 		CGameFileInfo* file = const_cast<CGameFileInfo*>(Packages[i]);		// we'll modify this structure here
 		if (file->IsPackageScanned) continue;
+		file->IsPackageScanned = true;		// also prevents from adding the same file twice
+		Files.Add(file);
+		FileIndices.Add(i);
+	}
+
+	struct
+	{
+		FPackageSummaryInfo Info;
+		bool IsValid;
+	} Results[SCAN_BATCH_SIZE];
+
+	int First = 0;
+	for ( ; First < Files.Num(); /* empty */)
+	{
+		// Load the first package alone: it could set up global state (e.g. select engine version
+		// for unversioned UE4 packages), which is later used by all other packages
+		int Count = (First == 0) ? 1 : min(Files.Num() - First, SCAN_BATCH_SIZE);
 
 		// Update progress dialog
 		FStaticString<MAX_PACKAGE_PATH> RelativeName;
-		file->GetRelativeName(RelativeName);
-		if (Progress && !Progress->Progress(*RelativeName, i, Packages.Num()))
+		Files[First]->GetRelativeName(RelativeName);
+		if (Progress && !Progress->Progress(*RelativeName, FileIndices[First], Packages.Num()))
 		{
 			cancelled = true;
 			break;
 		}
 
-		file->IsPackageScanned = true;
+		// Read package headers in parallel, packages are not kept in memory
+		ParallelFor(Count, [&Files, &Results, First](int Index)
+			{
+				Results[Index].IsValid = ReadPackageSummary(Files[First + Index], Results[Index].Info);
+			}, 1);
 
-		if (file->Package)
+		// Store results in the main thread
+		for (int i = 0; i < Count; i++)
 		{
-			// package already loaded
-			ScanPackageExports(file->Package, file);
-		}
-		else
-		{
-			UnPackage* package = UnPackage::LoadPackage(file, /*silent=*/ true);	// should always return non-NULL
-			if (!package) continue;		// should not happen
-			ScanPackageExports(package, file);
-		#if 0
-			// this code is disabled: it works, however we're going to use ScanContent not just to get objects counts,
-			// but also for collecting object references
-
-			// now unload package to not waste memory
-			UnPackage::UnloadPackage(package);
-			assert(file->Package == NULL);
-		#endif
+			if (!Results[i].IsValid) continue;
+			CGameFileInfo* file = Files[First + i];
+			const FPackageSummaryInfo& Info = Results[i].Info;
+			file->NumSkeletalMeshes = Info.NumSkeletalMeshes;
+			file->NumStaticMeshes   = Info.NumStaticMeshes;
+			file->NumAnimations     = Info.NumAnimations;
+			file->NumTextures       = Info.NumTextures;
 		}
+		First += Count;
 		scanned = true;
 	}
+
+	// Packages which weren't processed because of cancellation should be scanned next time
+	for ( ; First < Files.Num(); First++)
+	{
+		Files[First]->IsPackageScanned = false;
+	}
 #if 0
 	void PrintStringHashDistribution();
 	PrintStringHashDistribution();
@@ -295,6 +380,11 @@ bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback
 #if PROFILE
 	if (scanned)
 		appPrintProfiler("Scanned packages");
+#endif
+#if UNREAL4
+	// Store scan results to the game file cache
+	if (scanned)
+		appSaveGameFileCache(true);
 #endif
 	return !cancelled;
 }
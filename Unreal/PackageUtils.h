@@ -37,6 +37,20 @@ struct FileInfo
 
 bool ScanPackageVersions(TArray<FileInfo>& info, IProgressCallback* progress = NULL);
 
+// Compact package content information, filled without loading objects and without keeping package in memory
+struct FPackageSummaryInfo
+{
+	int		Ver;
+	int		LicVer;
+	uint16	NumSkeletalMeshes;
+	uint16	NumStaticMeshes;
+	uint16	NumAnimations;
+	uint16	NumTextures;
+};
+
+// Read package summary and export table, and count objects of interest. Could be called from any thread.
+bool ReadPackageSummary(const CGameFileInfo* File, FPackageSummaryInfo& Info);
+
 bool ScanContent(const TArray<const CGameFileInfo*>& Packages, IProgressCallback* Progress = NULL);
 
 
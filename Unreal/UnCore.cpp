@@ -1,6 +1,10 @@
 #include "Core.h"
 #include "UnCore.h"
 
+#if THREADING
+#include "Parallel.h"
+#endif
+
 
 int  GForceGame           = GAME_UNKNOWN;
 int  GForcePackageVersion = 0;
@@ -11,11 +15,14 @@ byte GForcePlatform       = PLATFORM_UNKNOWN;
 
 int GNumSerialize = 0;
 int GSerializeBytes = 0;
+int GTextureCacheHits = 0;
+int GTextureCacheMisses = 0;
 static int ProfileStartTime = -1;
 
 void appResetProfiler()
 {
 	GNumAllocs = GNumSerialize = GSerializeBytes = 0;
+	GTextureCacheHits = GTextureCacheMisses = 0;
 	ProfileStartTime = appMilliseconds();
 }
 
@@ -24,11 +31,13 @@ void appPrintProfiler(const char* label)
 {
 	if (ProfileStartTime == -1) return;
 	float timeDelta = (appMilliseconds() - ProfileStartTime) / 1000.0f;
-	if (timeDelta < 0.001f && !GNumAllocs && !GSerializeBytes && !GNumSerialize)
+	if (timeDelta < 0.001f && !GNumAllocs && !GSerializeBytes && !GNumSerialize && !GTextureCacheHits && !GTextureCacheMisses)
 		return;		// nothing to print (perhaps already printed?)
 	appPrintf("%s in %.1f sec, %d allocs, %.2f MBytes serialized in %d calls.\n",
 		label ? label : "Loaded",
 		timeDelta, GNumAllocs, GSerializeBytes / (1024.0f * 1024.0f), GNumSerialize);
+	if (GTextureCacheHits || GTextureCacheMisses)
+		appPrintf("Texture cache: %d hits, %d misses.\n", GTextureCacheHits, GTextureCacheMisses);
 	appResetProfiler();
 }
 
@@ -491,6 +500,11 @@ struct CStringPoolEntry
 static CStringPoolEntry* StringHashTable[STRING_HASH_SIZE];
 static CMemoryChain* StringPool;
 
+#if THREADING
+// Packages could be loaded from multiple threads when scanning game content
+static CMutex StringPoolMutex;
+#endif
+
 const char* appStrdupPool(const char* str)
 {
 	int len = strlen(str);
@@ -502,6 +516,10 @@ const char* appStrdupPool(const char* str)
 	}
 	hash &= (STRING_HASH_SIZE - 1);
 
+#if THREADING
+	CMutex::ScopedLock Lock(StringPoolMutex);
+#endif
+
 #if 0
 	if (true)
 	{
@@ -65,6 +65,8 @@ class UnPackage;
 #if PROFILE
 extern int GNumSerialize;
 extern int GSerializeBytes;
+extern int GTextureCacheHits;
+extern int GTextureCacheMisses;
 
 void appResetProfiler();
 void appPrintProfiler(const char* label = NULL);
@@ -86,6 +88,14 @@ void appSetRootDirectory(const char *dir, bool recurse = true);
 void appSetRootDirectory2(const char *filename);
 const char *appGetRootDirectory();
 
+#if UNREAL4
+// Enable persistent cache of pak file directories and package scan results. Should be called before
+// appSetRootDirectory(). Cache is saved when game directory was changed, or when 'force' is true.
+// With 'readOnly', cache is used but never saved (for processes sharing the cache with another one).
+void appSetGameFileCache(const char* filename, bool readOnly = false);
+void appSaveGameFileCache(bool force = false);
+#endif
+
 // forwards
 class FString;
 class FVirtualFileSystem;
@@ -611,6 +621,23 @@ public:
 	virtual void Serialize(void *data, int size) = 0;
 	void ByteOrderSerialize(void *data, int size);
 
+	// Positional read: read data at the specified position without changing archive position.
+	// When SupportsReadAt() returns true, this function doesn't touch archive state, so the same
+	// archive could be used by multiple threads at once (e.g. pak file shared by many FPakFile).
+	virtual bool SupportsReadAt() const
+	{
+		return false;
+	}
+
+	virtual void ReadAt(int64 Pos, void *data, int size)
+	{
+		// Generic implementation, not thread-safe
+		int64 SavePos = Tell64();
+		Seek64(Pos);
+		Serialize(data, size);
+		Seek64(SavePos);
+	}
+
 	// "Stopper" is used to check for overrun serialization.
 	// Note: there's no 64-bit "stopper" - large files are used only as containers for smaller
 	// files, so stopper validation is performed on upper level, with 32-bit values.
@@ -848,6 +875,8 @@ public:
 	virtual ~FFileReader();
 
 	virtual void Serialize(void *data, int size);
+	virtual bool SupportsReadAt() const;
+	virtual void ReadAt(int64 Pos, void *data, int size);
 	virtual bool Open();
 	virtual void Seek(int Pos);
 	virtual void Seek64(int64 Pos);
@@ -861,6 +890,51 @@ protected:
 	int64		FileSize;
 	int			BufferBytesLeft;
 	int			LocalReadPos;
+	bool		bFilePointerChanged;	// set by ReadAt() when OS file pointer was moved, FILE should be seeked before reading
+};
+
+
+// Read-only archive which maps the whole file into memory. Reading doesn't involve system calls or
+// intermediate buffers, and data could be accessed directly with GetData(). Close() releases the
+// mapping, Open() restores it.
+class FMappedFileReader : public FArchive
+{
+	DECLARE_ARCHIVE(FMappedFileReader, FArchive);
+public:
+	FMappedFileReader(const char *Filename, unsigned InOptions = 0);
+	virtual ~FMappedFileReader();
+
+	virtual void Serialize(void *data, int size);
+	virtual bool SupportsReadAt() const;
+	virtual void ReadAt(int64 Pos, void *data, int size);
+	virtual bool IsOpen() const;
+	virtual bool Open();
+	virtual void Close();
+	virtual void Seek(int Pos);
+	virtual void Seek64(int64 Pos);
+	virtual int Tell() const;
+	virtual int64 Tell64() const;
+	virtual int GetFileSize() const;
+	virtual int64 GetFileSize64() const;
+	virtual bool IsEof() const;
+
+	// Pointer to the mapped file data, NULL when file is closed
+	const byte* GetData() const
+	{
+		return Data;
+	}
+
+	const char* GetFileName() const
+	{
+		return FullName;
+	}
+
+protected:
+	const byte*	Data;
+	int64		DataSize;
+	int64		ArPos64;
+	unsigned	Options;
+	const char*	FullName;		// allocated with appStrdup
 };
 
 
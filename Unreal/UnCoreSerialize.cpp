@@ -585,6 +585,7 @@ FFileReader::FFileReader(const char *Filename, unsigned InOptions)
 ,	FileSize(-1)
 ,	BufferBytesLeft(0)
 ,	LocalReadPos(0)
+,	bFilePointerChanged(false)
 {
 	guard(FFileReader::FFileReader);
 	IsLoading = true;
@@ -639,11 +640,17 @@ void FFileReader::Serialize(void *data, int size)
 		else
 		{
 			// Buffer is empty
+			if (bFilePointerChanged)
+			{
+				// ReadAt() has moved OS file pointer, so force seek to restore it
+				if (SeekPos < 0) SeekPos = FilePos;
+			}
 			if (SeekPos >= 0)
 			{
 				// Seek to desired position
-				if (SeekPos != FilePos)
+				if (SeekPos != FilePos || bFilePointerChanged)
 				{
+					bFilePointerChanged = false;
 					if (fseeko64(f, SeekPos, SEEK_SET) != 0)
 						appError("Error seeking to position 0x%llX", SeekPos);
 					FilePos = SeekPos;
@@ -694,6 +701,30 @@ void FFileReader::Serialize(void *data, int size)
 	unguardf("File=%s", ShortName);
 }
 
+bool FFileReader::SupportsReadAt() const
+{
+	return true;
+}
+
+void FFileReader::ReadAt(int64 Pos, void *data, int size)
+{
+	PROFILE_IF(size >= 1024);
+	guard(FFileReader::ReadAt);
+
+	assert(data && IsOpen());
+	if (!appReadFileAt(f, Pos, data, size))
+		appError("Unable to read %d bytes at pos=0x%llX", size, Pos);
+#if _WIN32
+	bFilePointerChanged = true;
+#endif
+#if PROFILE
+	GNumSerialize++;
+	GSerializeBytes += size;
+#endif
+
+	unguardf("File=%s", ShortName);
+}
+
 bool FFileReader::Open()
 {
 	return OpenFile();
@@ -765,6 +796,151 @@ bool FFileReader::IsEof() const
 	return (BufferBytesLeft == 0) && (FilePos == GetFileSize64());
 }
 
+FMappedFileReader::FMappedFileReader(const char *Filename, unsigned InOptions)
+:	Data(NULL)
+,	DataSize(0)
+,	ArPos64(0)
+,	Options(InOptions)
+{
+	guard(FMappedFileReader::FMappedFileReader);
+	IsLoading = true;
+	FullName = appStrdup(Filename);
+	Open();
+	unguardf("%s", Filename);
+}
+
+FMappedFileReader::~FMappedFileReader()
+{
+	Close();
+	appFree(const_cast<char*>(FullName));
+}
+
+void FMappedFileReader::Serialize(void *data, int size)
+{
+	PROFILE_IF(size >= 1024);
+	guard(FMappedFileReader::Serialize);
+
+	assert(data && Data);
+
+	if (ArStopper > 0 && ArPos64 + size > ArStopper)
+		appError("Serializing behind stopper (%llX+%X > %X)", ArPos64, size, ArStopper);
+	if (ArPos64 + size > DataSize)
+		appError("Unable to read %d bytes at pos=0x%llX", size, ArPos64);
+
+	const byte* Src = Data + ArPos64;
+	switch (size)
+	{
+	case 1:
+		*(byte*)data = *Src;
+		break;
+	case 2:
+		*(uint16*)data = *(uint16*)Src;
+		break;
+	case 4:
+		*(uint32*)data = *(uint32*)Src;
+		break;
+	default:
+		memcpy(data, Src, size);
+	}
+	ArPos64 += size;
+#if PROFILE
+	GNumSerialize++;
+	GSerializeBytes += size;
+#endif
+
+	unguardf("File=%s", FullName);
+}
+
+bool FMappedFileReader::SupportsReadAt() const
+{
+	return true;
+}
+
+void FMappedFileReader::ReadAt(int64 Pos, void *data, int size)
+{
+	PROFILE_IF(size >= 1024);
+	guard(FMappedFileReader::ReadAt);
+
+	assert(data && Data);
+	if (Pos < 0 || Pos + size > DataSize)
+		appError("Unable to read %d bytes at pos=0x%llX", size, Pos);
+	memcpy(data, Data + Pos, size);
+#if PROFILE
+	GNumSerialize++;
+	GSerializeBytes += size;
+#endif
+
+	unguardf("File=%s", FullName);
+}
+
+bool FMappedFileReader::IsOpen() const
+{
+	return Data != NULL;
+}
+
+bool FMappedFileReader::Open()
+{
+	guard(FMappedFileReader::Open);
+
+	if (Data) return true;
+
+	Data = (const byte*)appMapFile(FullName, DataSize);
+	if (Data) return true;			// success
+	if (!(Options & FAO_NoOpenError))
+	{
+		appError("Can't map file %s", FullName);
+	}
+	return false;
+
+	unguard;
+}
+
+void FMappedFileReader::Close()
+{
+	if (Data)
+	{
+		appUnmapFile(Data, DataSize);
+		Data = NULL;
+	}
+}
+
+void FMappedFileReader::Seek(int Pos)
+{
+	Seek64(Pos);
+}
+
+void FMappedFileReader::Seek64(int64 Pos)
+{
+	ArPos64 = Pos;
+}
+
+int FMappedFileReader::Tell() const
+{
+	assert((ArPos64 >> 32) == 0);
+	return (int)ArPos64;
+}
+
+int64 FMappedFileReader::Tell64() const
+{
+	return ArPos64;
+}
+
+int FMappedFileReader::GetFileSize() const
+{
+	if (DataSize >= (1LL << 31)) appError("GetFileSize returns 0x%llX", DataSize); // 2Gb size restriction
+	return (int)DataSize;
+}
+
+int64 FMappedFileReader::GetFileSize64() const
+{
+	return DataSize;
+}
+
+bool FMappedFileReader::IsEof() const
+{
+	return ArPos64 >= DataSize;
+}
+
 static TArray<FFileWriter*> GFileWriters;
 
 #if THREADING
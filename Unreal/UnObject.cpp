@@ -19,6 +19,7 @@
 -----------------------------------------------------------------------------*/
 
 bool (*GBeforeLoadObjectCallback)(UObject*) = NULL;
+bool GLogObjectLoading = true;
 
 UObject::UObject()
 :	PackageIndex(INDEX_NONE)
@@ -146,6 +147,56 @@ void UObject::BeginLoad()
 }
 
 
+// Item of the load queue, used for sorting objects by their position in package file
+struct CLoadQueueItem
+{
+	UObject*	Obj;
+	int			PackageOrder;
+	int32		SerialOffset;
+	int			QueueIndex;
+};
+
+static int CompareLoadQueueItems(const CLoadQueueItem& A, const CLoadQueueItem& B)
+{
+	if (A.PackageOrder != B.PackageOrder) return A.PackageOrder - B.PackageOrder;
+	if (A.SerialOffset != B.SerialOffset) return (A.SerialOffset < B.SerialOffset) ? -1 : 1;
+	return A.QueueIndex - B.QueueIndex;
+}
+
+// Sort objects, so ones from the same package will be grouped together (in order of package
+// appearance in queue), and objects inside of package will be ordered by file offset.
+static void SortLoadBatch(UObject** Objects, int Count)
+{
+	guard(SortLoadBatch);
+
+	TArray<CLoadQueueItem> Items;
+	Items.AddUninitialized(Count);
+	TArray<UnPackage*> Packages;
+	UnPackage* LastPackage = NULL;
+	int LastPackageOrder = -1;
+	for (int i = 0; i < Count; i++)
+	{
+		UObject* Obj = Objects[i];
+		if (Obj->Package != LastPackage)
+		{
+			LastPackage = Obj->Package;
+			LastPackageOrder = Packages.FindItem(LastPackage);
+			if (LastPackageOrder < 0)
+				LastPackageOrder = Packages.Add(LastPackage);
+		}
+		CLoadQueueItem& Item = Items[i];
+		Item.Obj = Obj;
+		Item.PackageOrder = LastPackageOrder;
+		Item.SerialOffset = LastPackage->GetExport(Obj->PackageIndex).SerialOffset;
+		Item.QueueIndex = i;
+	}
+	Items.Sort(CompareLoadQueueItems);
+	for (int i = 0; i < Count; i++)
+		Objects[i] = Items[i].Obj;
+
+	unguard;
+}
+
 void UObject::EndLoad()
 {
 	assert(GObjBeginLoadCount > 0);
@@ -158,36 +209,43 @@ void UObject::EndLoad()
 	guard(UObject::EndLoad);
 
 	// process GObjLoaded array
-	// NOTE: while loading one array element, array may grow!
-	TArray<UObject*> LoadedObjects;
-	while (GObjLoaded.Num())
+	// NOTE: while loading one array element, array may grow! Objects are processed in batches:
+	// all objects queued while serializing the previous batch are sorted by file position and
+	// then loaded. Processed objects are not removed from the array until loading is complete.
+	int LoadIndex = 0;
+	while (LoadIndex < GObjLoaded.Num())
 	{
-		UObject *Obj = GObjLoaded[0];
-		GObjLoaded.RemoveAt(0);
-		UnPackage *Package = Obj->Package;
+		int BatchEnd = GObjLoaded.Num();
+		if (BatchEnd - LoadIndex > 1)
+			SortLoadBatch(&GObjLoaded[LoadIndex], BatchEnd - LoadIndex);
+
+		for ( ; LoadIndex < BatchEnd; LoadIndex++)
+		{
+			UObject *Obj = GObjLoaded[LoadIndex];
+			UnPackage *Package = Obj->Package;
 
-		guard(LoadObject);
-		PROFILE_LABEL(Obj->GetClassName());
+			guard(LoadObject);
+			PROFILE_LABEL(Obj->GetClassName());
 
-		Package->SetupReader(Obj->PackageIndex);
-		appPrintf("Loading %s %s from package %s\n", Obj->GetClassName(), Obj->Name, *Package->GetFilename());
-		// setup NotifyInfo to describe object
-		appSetNotifyHeader("Loading object %s'%s.%s'", Obj->GetClassName(), Package->Name, Obj->Name);
+			Package->SetupReader(Obj->PackageIndex);
+			if (GLogObjectLoading)
+				appPrintf("Loading %s %s from package %s\n", Obj->GetClassName(), Obj->Name, *Package->GetFilename());
+			// setup NotifyInfo to describe object
+			appSetNotifyHeader("Loading object %s'%s.%s'", Obj->GetClassName(), Package->Name, Obj->Name);
 #if PROFILE_LOADING
-		appResetProfiler();
+			appResetProfiler();
 #endif
-		GLoadingObj = Obj;
-		Obj->Serialize(*Package);
-		GLoadingObj = NULL;
+			GLoadingObj = Obj;
+			Obj->Serialize(*Package);
+			GLoadingObj = NULL;
 #if PROFILE_LOADING
-		appPrintProfiler();
+			appPrintProfiler();
 #endif
-		// check for unread bytes
-		if (!Package->IsStopper())
-			appError("%s::Serialize(%s): %d unread bytes",
-				Obj->GetClassName(), Obj->Name,
-				Package->GetStopper() - Package->Tell());
-		LoadedObjects.Add(Obj);
+			// check for unread bytes
+			if (!Package->IsStopper())
+				appError("%s::Serialize(%s): %d unread bytes",
+					Obj->GetClassName(), Obj->Name,
+					Package->GetStopper() - Package->Tell());
 
 #if UNREAL4
 	#define UNVERS_STR		(Package->Game >= GAME_UE4_BASE && Package->Summary.IsUnversioned) ? " (unversioned)" : ""
@@ -197,12 +255,14 @@ void UObject::EndLoad()
 	#define EDITOR_STR		""
 #endif
 
-		unguardf("%s'%s.%s', pos=%X, ver=%d/%d%s%s, game=%s", Obj->GetClassName(), Package->Name, Obj->Name, Package->Tell(),
-			Package->ArVer, Package->ArLicenseeVer, UNVERS_STR, EDITOR_STR, GetGameTag(Package->Game));
+			unguardf("%s'%s.%s', pos=%X, ver=%d/%d%s%s, game=%s", Obj->GetClassName(), Package->Name, Obj->Name, Package->Tell(),
+				Package->ArVer, Package->ArLicenseeVer, UNVERS_STR, EDITOR_STR, GetGameTag(Package->Game));
+		}
 	}
 	// postload objects
-	for (UObject* Obj : LoadedObjects)
+	for (int i = 0, NumLoaded = GObjLoaded.Num(); i < NumLoaded; i++)
 	{
+		UObject* Obj = GObjLoaded[i];
 		guard(PostLoad);
 		Obj->PostLoad();
 		unguardf("%s", Obj->Name);
@@ -103,4 +103,7 @@ void RegisterCoreClasses();
 // false, serialization function will not be called.
 extern bool (*GBeforeLoadObjectCallback)(UObject*);
 
+// When set to false, UObject::EndLoad() will not print names of loaded objects.
+extern bool GLogObjectLoading;
+
 #endif // __UNOBJECT_H__
@@ -8,6 +8,14 @@
 
 #include "GameDatabase.h"		// for GetGameTag()
 
+#if THREADING
+#include "Parallel.h"
+
+// Package headers could be loaded from multiple threads (see ScanContent), protect shared data
+static CMutex PackageMapMutex;
+static CMutex UnversionedPackageMutex;
+#endif
+
 
 //#define DEBUG_PACKAGE			1
 //#define PROFILE_PACKAGE_TABLES	1
@@ -529,24 +537,31 @@ void FPackageFileSummary::Serialize4(FArchive &Ar)
 	if (FileVersion == 0 && LicenseeVersion == 0)
 		IsUnversioned = true;
 
-	if (IsUnversioned && GForceGame == GAME_UNKNOWN)
+	if (IsUnversioned)
 	{
-		int ver = -LegacyVersion - 1;
-		int verMin = legacyVerToEngineVer[ver];
-		int verMax = legacyVerToEngineVer[ver+1] - 1;
-		int selectedVersion;
-		if (verMax < verMin)
-		{
-			// if LegacyVersion exactly matches single engine version, don't show any UI
-			selectedVersion = verMin;
-		}
-		else
+#if THREADING
+		// Engine version is selected once for all packages, possibly with displaying UI
+		CMutex::ScopedLock Lock(UnversionedPackageMutex);
+#endif
+		if (GForceGame == GAME_UNKNOWN)
 		{
-			// display UI if it is supported
-			selectedVersion = UE4UnversionedPackage(verMin, verMax);
-			assert(selectedVersion >= 0 && selectedVersion <= LATEST_SUPPORTED_UE4_VERSION);
+			int ver = -LegacyVersion - 1;
+			int verMin = legacyVerToEngineVer[ver];
+			int verMax = legacyVerToEngineVer[ver+1] - 1;
+			int selectedVersion;
+			if (verMax < verMin)
+			{
+				// if LegacyVersion exactly matches single engine version, don't show any UI
+				selectedVersion = verMin;
+			}
+			else
+			{
+				// display UI if it is supported
+				selectedVersion = UE4UnversionedPackage(verMin, verMax);
+				assert(selectedVersion >= 0 && selectedVersion <= LATEST_SUPPORTED_UE4_VERSION);
+			}
+			GForceGame = GAME_UE4(selectedVersion);
 		}
-		GForceGame = GAME_UE4(selectedVersion);
 	}
 
 	// detect game
@@ -1293,8 +1308,9 @@ void FObjectImport::Serialize(FArchive& Ar)
 	Package loading (creation) / unloading
 -----------------------------------------------------------------------------*/
 
-UnPackage::UnPackage(const char *filename, const CGameFileInfo* fileInfo, bool silent)
+UnPackage::UnPackage(const char *filename, const CGameFileInfo* fileInfo, bool silent, bool headerOnly)
 :	Loader(NULL)
+,	LocalNamePool(headerOnly ? new CMemoryChain() : NULL)
 {
 	guard(UnPackage::UnPackage);
 
@@ -1382,6 +1398,23 @@ UnPackage::UnPackage(const char *filename, const CGameFileInfo* fileInfo, bool s
 	LoadImportTable();
 	LoadExportTable();
 
+	// get package name
+	char buf[MAX_PACKAGE_PATH];
+	const char *s = strrchr(filename, '/');
+	if (!s) s = strrchr(filename, '\\');			// WARNING: not processing mixed '/' and '\'
+	if (s) s++; else s = filename;
+	appStrncpyz(buf, s, ARRAY_COUNT(buf));
+	char *s2 = strchr(buf, '.');
+	if (s2) *s2 = 0;
+	Name = AllocName(buf);
+
+	if (headerOnly)
+	{
+		// Everything else is needed only for loading objects, don't register package in PackageMap
+		CloseReader();
+		return;
+	}
+
 #if UNREAL3 && !USE_COMPACT_PACKAGE_STRUCTS			// we can serialize dependencies when needed
 	if (Game == GAME_DCUniverse || Game == GAME_Bioshock3) goto no_depends;		// has non-standard checks
 	if (Summary.DependsOffset)						// some games are patrially upgraded: ArVer >= 415, but no depends table
@@ -1438,15 +1471,12 @@ no_depends: ;
 #endif // UNREAL4
 
 	// add self to package map
-	char buf[MAX_PACKAGE_PATH];
-	const char *s = strrchr(filename, '/');
-	if (!s) s = strrchr(filename, '\\');			// WARNING: not processing mixed '/' and '\'
-	if (s) s++; else s = filename;
-	appStrncpyz(buf, s, ARRAY_COUNT(buf));
-	char *s2 = strchr(buf, '.');
-	if (s2) *s2 = 0;
-	Name = appStrdupPool(buf);
-	PackageMap.Add(this);
+	{
+#if THREADING
+		CMutex::ScopedLock Lock(PackageMapMutex);
+#endif
+		PackageMap.Add(this);
+	}
 
 	// Release package file handle
 	CloseReader();
@@ -1459,6 +1489,18 @@ no_depends: ;
 }
 
 
+const char* UnPackage::AllocName(const char* str)
+{
+	if (!LocalNamePool)
+		return appStrdupPool(str);
+	// Package is loaded with LoadPackageHeader(), keep names together with the package
+	int len = strlen(str) + 1;
+	char* buf = (char*)LocalNamePool->Alloc(len, 1);
+	memcpy(buf, str, len);
+	return buf;
+}
+
+
 void UnPackage::LoadNameTable()
 {
 	guard(UnPackage::LoadNameTable);
@@ -1489,7 +1531,7 @@ void UnPackage::LoadNameTable()
 				if (!c) break;
 			}
 			assert(len < ARRAY_COUNT(buf));
-			NameTable[i] = appStrdupPool(buf);
+			NameTable[i] = AllocName(buf);
 			// skip object flags
 			int tmp;
 			*this << tmp;
@@ -1504,7 +1546,7 @@ void UnPackage::LoadNameTable()
 			*this << len;
 			assert(len < ARRAY_COUNT(buf));
 			Serialize(buf, len+1);
-			NameTable[i] = appStrdupPool(buf);
+			NameTable[i] = AllocName(buf);
 			// skip object flags
 			int tmp;
 			*this << tmp;
@@ -1523,7 +1565,7 @@ void UnPackage::LoadNameTable()
 				int flags;
 				*this << len;
 				Serialize(buf, len+1);
-				NameTable[i] = appStrdupPool(buf);
+				NameTable[i] = AllocName(buf);
 				*this << flags;
 				goto done;
 			}
@@ -1537,7 +1579,7 @@ void UnPackage::LoadNameTable()
 				assert(len < ARRAY_COUNT(buf));
 				Serialize(buf, len);
 				buf[len] = 0;
-				NameTable[i] = appStrdupPool(buf);
+				NameTable[i] = AllocName(buf);
 				goto done;
 			}
 #endif // LEAD
@@ -1563,7 +1605,7 @@ void UnPackage::LoadNameTable()
 					*d = c2 & 0xFF;
 					shift = (c - 5) & 15;
 				}
-				NameTable[i] = appStrdupPool(buf);
+				NameTable[i] = AllocName(buf);
 				int unk;
 				*this << AR_INDEX(unk);
 				unguard;
@@ -1580,7 +1622,7 @@ void UnPackage::LoadNameTable()
 				assert(len < ARRAY_COUNT(buf));
 				Serialize(buf, len);
 				buf[len] = 0;
-				NameTable[i] = appStrdupPool(buf);
+				NameTable[i] = AllocName(buf);
 				goto qword_flags;
 			}
 #endif // DCU_ONLINE
@@ -1592,7 +1634,7 @@ void UnPackage::LoadNameTable()
 				*this << len;
 				Serialize(buf, len);
 				buf[len] = 0;
-				NameTable[i] = appStrdupPool(buf);
+				NameTable[i] = AllocName(buf);
 				goto done;
 			}
 #endif // R6VEGAS
@@ -1605,7 +1647,7 @@ void UnPackage::LoadNameTable()
 				assert(len < ARRAY_COUNT(buf));
 				Serialize(buf, len);
 				buf[len] = 0;
-				NameTable[i] = appStrdupPool(buf);
+				NameTable[i] = AllocName(buf);
 				goto qword_flags;
 			}
 #endif // TRANSFORMERS
@@ -1665,7 +1707,7 @@ void UnPackage::LoadNameTable()
 			NameTable[i] = new char[name.Num()];
 			strcpy(NameTable[i], *name);
 	#else
-			NameTable[i] = appStrdupPool(*nameStr);
+			NameTable[i] = AllocName(*nameStr);
 	#endif
 
 	#if UNREAL4
@@ -1812,18 +1854,24 @@ UnPackage::~UnPackage()
 	guard(UnPackage::~UnPackage);
 
 	// Remove self from package table (it will be there even if package is not "valid")
-	int i = PackageMap.FindItem(this);
-	if (i != INDEX_NONE)
 	{
-		// Could be INDEX_NONE in a case of bad package
-		PackageMap.RemoveAt(i);
+#if THREADING
+		CMutex::ScopedLock Lock(PackageMapMutex);
+#endif
+		int i = PackageMap.FindItem(this);
+		if (i != INDEX_NONE)
+		{
+			// Could be INDEX_NONE in a case of bad package
+			PackageMap.RemoveAt(i);
+		}
 	}
-	// unlink package from CGameFileInfo
-	if (FileInfo)
+	// unlink package from CGameFileInfo (package loaded with LoadPackageHeader() is not linked)
+	if (FileInfo && !LocalNamePool)
 	{
 		assert(FileInfo->Package == this || FileInfo->Package == NULL);
 		const_cast<CGameFileInfo*>(FileInfo)->Package = NULL;
 	}
+	if (LocalNamePool) delete LocalNamePool;
 
 	if (!IsValid())
 	{
@@ -1844,6 +1892,24 @@ UnPackage::~UnPackage()
 	unguard;
 }
 
+/*static*/ UnPackage* UnPackage::LoadPackageHeader(const CGameFileInfo* File)
+{
+	guard(UnPackage::LoadPackageHeader);
+
+	if (!File->IsPackage)
+		return NULL;
+
+	UnPackage* package = new UnPackage(*File->GetRelativeName(), File, true, true);
+	if (!package->IsValid())
+	{
+		delete package;
+		return NULL;
+	}
+	return package;
+
+	unguardf("%s", *File->GetRelativeName());
+}
+
 /*static*/ void UnPackage::UnloadPackage(UnPackage* package)
 {
 	if (package)
@@ -1950,7 +2016,9 @@ FArchive& UnPackage::operator<<(FName &N)
 		}
 		else
 		{
-			N.Str = appStrdupPool(va("%s%d", GetName(N_Index), N_ExtraIndex-1));	// without "_" char
+			char buf[MAX_FNAME_LEN];
+			appSprintf(ARRAY_ARG(buf), "%s%d", GetName(N_Index), N_ExtraIndex-1);	// without "_" char
+			N.Str = AllocName(buf);
 		}
 		return *this;
 	}
@@ -2003,7 +2071,10 @@ FArchive& UnPackage::operator<<(FName &N)
 	}
 	else
 	{
-		N.Str = appStrdupPool(va("%s_%d", GetName(N_Index), N_ExtraIndex-1));
+		// Don't use va() here, it is not thread-safe
+		char buf[MAX_FNAME_LEN];
+		appSprintf(ARRAY_ARG(buf), "%s_%d", GetName(N_Index), N_ExtraIndex-1);
+		N.Str = AllocName(buf);
 	}
 #else
 	// no modern engines compiled
@@ -2058,18 +2129,52 @@ FArchive& UnPackage::operator<<(UObject *&Obj)
 	Loading particular import or export package entry
 -----------------------------------------------------------------------------*/
 
+uint32 UnPackage::GetExportNameHash(const char* Name)
+{
+	// Ignore character case in the same way as FastNameComparer does
+	uint32 Hash = 2166136261u;
+	for (const char* s = Name; *s; s++)
+		Hash = (Hash ^ (*s & 0xDF)) * 16777619u;
+	return Hash;
+}
+
+void UnPackage::BuildExportHash()
+{
+	guard(UnPackage::BuildExportHash);
+
+	int HashSize = 16;
+	while (HashSize < Summary.ExportCount)
+		HashSize <<= 1;
+	ExportHashHeads.Init(-1, HashSize);
+	ExportHashNext.Init(-1, Summary.ExportCount);
+	// Fill hash chains in reverse order, so each chain has exports sorted by index
+	for (int i = Summary.ExportCount - 1; i >= 0; i--)
+	{
+		int h = GetExportNameHash(ExportTable[i].ObjectName) & (HashSize - 1);
+		ExportHashNext[i] = ExportHashHeads[h];
+		ExportHashHeads[h] = i;
+	}
+
+	unguard;
+}
+
 int UnPackage::FindExport(const char *name, const char *className, int firstIndex) const
 {
 	guard(UnPackage::FindExport);
 
-	// Do the first pass with comparing string pointers instead of using stricmp. We're using
-	// global name pool for all name tables, so this should work in most cases.
+	if (ExportHashHeads.Num() == 0)
+		const_cast<UnPackage*>(this)->BuildExportHash();
+
+	// Compare string pointers first, and use stricmp-like comparison only when they are different. We're
+	// using global name pool for all name tables, so pointer comparison should work in most cases.
 	FastNameComparer cmp(name);
-	for (int i = firstIndex; i < Summary.ExportCount; i++)
+	int h = GetExportNameHash(name) & (ExportHashHeads.Num() - 1);
+	for (int i = ExportHashHeads[h]; i >= 0; i = ExportHashNext[i])
 	{
+		if (i < firstIndex) continue;
 		const FObjectExport &Exp = ExportTable[i];
 		// compare object name
-		if (cmp(Exp.ObjectName))
+		if (Exp.ObjectName.Str == name || cmp(Exp.ObjectName))
 		{
 			// if class name specified - compare it too
 			const char *foundClassName = GetObjectName(Exp.ClassIndex);
@@ -2129,7 +2234,8 @@ bool UnPackage::CompareObjectPaths(int PackageIndex, UnPackage *RefPackage, int
 		else
 			RefPackageName  = RefPackage->Name;
 //		appPrintf("%20s -- %20s\n", PackageName, RefPackageName);
-		if (stricmp(RefPackageName, PackageName) != 0) return false;
+		// names are pooled, so pointer comparison will work for most of names
+		if (RefPackageName != PackageName && stricmp(RefPackageName, PackageName) != 0) return false;
 	}
 
 	return true;
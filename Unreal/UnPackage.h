@@ -249,7 +249,7 @@ public:
 #endif
 
 protected:
-	UnPackage(const char *filename, const CGameFileInfo* fileInfo = NULL, bool silent = false);
+	UnPackage(const char *filename, const CGameFileInfo* fileInfo = NULL, bool silent = false, bool headerOnly = false);
 	~UnPackage();
 
 public:
@@ -269,6 +269,11 @@ public:
 	static UnPackage* LoadPackage(const CGameFileInfo* File, bool silent = false);
 	// We've protected UnPackage's destructor, however it is possible to use UnloadPackage to destroy package.
 	static void UnloadPackage(UnPackage* package);
+	// Load package summary, name, import and export tables into a temporary object, which is not registered
+	// in PackageMap and doesn't add names to the global name pool. Objects can't be loaded from such package.
+	// Returns NULL for invalid package, otherwise result should be released with UnloadPackage(). This
+	// function could be called from any thread.
+	static UnPackage* LoadPackageHeader(const CGameFileInfo* File);
 
 	FORCEINLINE static void ReservePackageMap(int count)
 	{
@@ -349,6 +354,8 @@ public:
 		unguardf("Index=%d", PackageIndex);
 	}
 
+	// Find export by name (case-insensitive) and class name (pooled string, compared by pointer)
+	// starting from 'firstIndex'. Uses hash index of export table, which is built on first call.
 	int FindExport(const char *name, const char *className = NULL, int firstIndex = 0) const;
 	int FindExportForImport(const char *ObjectName, const char *ClassName, UnPackage *ImporterPackage, int ImporterIndex);
 	bool CompareObjectPaths(int PackageIndex, UnPackage *RefPackage, int RefPackageIndex) const;
@@ -416,10 +423,21 @@ public:
 	}
 
 private:
+	CMemoryChain*			LocalNamePool;		// storage for names of the package loaded with LoadPackageHeader()
+
+	// Allocate name string in the global or local name pool
+	const char* AllocName(const char* str);
+
 	void LoadNameTable();
 	void LoadImportTable();
 	void LoadExportTable();
 
+	// Hash index of ExportTable by object name, see FindExport()
+	TArray<int32>			ExportHashHeads;	// first export in hash chain, -1 if none
+	TArray<int32>			ExportHashNext;		// next export with the same hash value, in ascending order
+	void BuildExportHash();
+	static uint32 GetExportNameHash(const char* Name);
+
 	static TArray<UnPackage*> PackageMap;
 };
 
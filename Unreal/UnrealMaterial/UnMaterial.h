@@ -211,11 +211,16 @@ struct CTextureData
 	int						OriginalFormatEnum;		// ETextureFormat or EPixelFormat
 	bool					isNormalmap;
 	const UPalette*			Palette;				// for TPF_P8
+	// Mip selection, should be set before GetTextureData() call. Mips which are not selected
+	// aren't placed into Mips array, and their bulk data is not loaded.
+	int						MipBias;				// number of largest mip levels to skip
+	int						MaxMipSize;				// skip mips with larger dimensions, 0 = no limit
 
 protected:
 	const char*				ObjectName;
 	const char*				ObjectClass;
 	int						ObjectGame;
+	int32					ObjectCacheId;			// id of the object in the texture decode cache, 0 when not cached
 
 public:
 	CTextureData()
@@ -235,18 +240,19 @@ public:
 
 	unsigned GetFourCC() const;
 
-	void SetObject(const UObject* Obj)
-	{
-		ObjectClass = Obj->GetClassName();
-		ObjectName = Obj->Name;
-		ObjectGame = Obj->Package ? Obj->GetPackageArchive()->Game : GAME_UNKNOWN;
-	}
+	void SetObject(const UUnrealMaterial* Obj);
 
 	const char* GetObjectName() const
 	{
 		return ObjectName;
 	}
 
+	// Check if mip level of the original texture doesn't match MipBias and MaxMipSize
+	bool ShouldSkipMip(int MipLevel, int USize, int VSize) const
+	{
+		return MipLevel < MipBias || (MaxMipSize > 0 && max(USize, VSize) > MaxMipSize);
+	}
+
 	// Determine if CTextureData could be used without alive UObject (i.e. it's safe to use it after object released)
 	bool OwnsAllData() const
 	{
@@ -257,7 +263,11 @@ public:
 		return true;
 	}
 
-	byte* Decompress(int MipLevel = 0, int Slice = -1);		// may return NULL in a case of error
+	// Size of the image produced by Decompress()
+	int GetDecompressedSize(int MipLevel = 0) const;
+	// May return NULL in a case of error. When Buffer is provided, image is decompressed into it,
+	// otherwise the memory is allocated. Decompressed images are shared via the texture decode cache.
+	byte* Decompress(int MipLevel = 0, int Slice = -1, byte* Buffer = NULL);
 
 #if SUPPORT_XBOX360
 	bool DecodeXBox360(int MipLevel);
@@ -268,8 +278,35 @@ public:
 #if SUPPORT_SWITCH
 	bool DecodeNSW(int MipLevel);
 #endif
+
+protected:
+	void DecompressImage(const CMipMap& Mip, const byte* Data, byte* dst, int size);
+};
+
+// Convert float[NumPixels*4] image, as produced by Decompress() for float formats, to RGBE pixels
+void ConvertFloatToRGBE(const float* Src, byte* Dst, int NumPixels);
+
+// Texture decode cache, see UnTextureCache.cpp
+
+struct CTextureCacheKey
+{
+	int32					ObjectId;
+	int32					MipLevel;
+	int32					Slice;
+	int32					Format;
+	int32					USize;
+	int32					VSize;
+	int32					DataSize;
 };
 
+int32 AllocateTextureCacheId();
+// Set memory limit for cached images, 0 will disable caching
+void SetTextureCacheSize(int SizeMB);
+// Copy cached image to Dst and return true, or return false if the image is not cached
+bool FindCachedTexture(const CTextureCacheKey& Key, byte* Dst, int Size);
+void AddCachedTexture(const CTextureCacheKey& Key, const byte* Data, int Size);
+void ReleaseCachedTextures(int32 ObjectId);
+
 // There's no such class in Unreal Engine, we use it as common base for UE1/UE2/UE3
 class UUnrealMaterial : public UObject
 {
@@ -290,6 +327,25 @@ public:
 	virtual void ReleaseTextureData() const
 	{}
 
+	UUnrealMaterial()
+	:	TextureCacheId(0)
+#if RENDERING
+	,	DrawTimestamp(0)
+	,	LockCount(0)
+	,	NormalUnpackExpr(NULL)
+#endif
+	{}
+	~UUnrealMaterial();
+
+	// Id of decoded images of this object in the texture decode cache, assigned on first use. Object
+	// pointer is not used for that because it could be reused by another object after release.
+	int32 GetTextureCacheId() const
+	{
+		if (!TextureCacheId)
+			TextureCacheId = AllocateTextureCacheId();
+		return TextureCacheId;
+	}
+
 	void GetMetadata(FArchive& Ar) const
 	{
 		// Use object's name as default metadata, override when needed
@@ -300,13 +356,11 @@ public:
 		Ar.Serialize(ObjName, Len);
 	}
 
-#if RENDERING
-	UUnrealMaterial()
-	:	DrawTimestamp(0)
-	,	LockCount(0)
-	,	NormalUnpackExpr(NULL)
-	{}
+protected:
+	mutable int32			TextureCacheId;
 
+public:
+#if RENDERING
 	void SetMaterial();								// main function to use from outside
 
 	//!! WARNING: UTextureCube will not work correctly - referenced textures are not encountered
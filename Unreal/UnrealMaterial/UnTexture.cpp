@@ -1,13 +1,15 @@
-#include "Wrappers/TextureNVTT.h"
-
 #include "Core.h"
 #include "UnCore.h"
 #include "UnObject.h"
 #include "UnMaterial.h"
 #include "UnMaterial2.h"		// for UPalette
+#include "UnTextureBCn.h"
+#include "UnTexturePixel.h"
 
 #include "Wrappers/TexturePNG.h"
 
+#include "Parallel.h"
+
 #if SUPPORT_IPHONE
 #	include <PVRTDecompress.h>
 #endif
@@ -26,25 +28,13 @@
 
 //#define DEBUG_PLATFORM_TEX		1
 
+#define DECODE_STRIPE_PIXELS	65536		// approximate number of pixels decoded by a single ParallelFor item
+#define UNTILE_STRIPE_BLOCKS	16384		// approximate number of blocks untiled by a single ParallelFor item
+
 /*-----------------------------------------------------------------------------
 	Texture decompression
 -----------------------------------------------------------------------------*/
 
-// replaces random 'alpha=0' color with black
-static void PostProcessAlpha(byte *pic, int width, int height)
-{
-	guard(PostProcessAlpha);
-
-	for (int pixelCount = width * height; pixelCount > 0; pixelCount--, pic += 4)
-	{
-		if (pic[3] != 0)	// not completely transparent
-			continue;
-		pic[0] = pic[1] = pic[2] = 0;
-	}
-
-	unguard;
-}
-
 // Some references:
 // https://msdn.microsoft.com/en-us/library/windows/desktop/hh308955.aspx
 // https://msdn.microsoft.com/en-us/library/bb694531.aspx
@@ -90,6 +80,94 @@ const CPixelFormatInfo PixelFormatInfo[] =
 	{ 0,						1,			1,			0,			0,			0,		0,		"PNG_RGBA"	},	// TPF_PNG_RGBA
 };
 
+static const struct
+{
+	ETexturePixelFormat Format;
+	void (*Decode)(const byte* Data, byte* Dst, int USize, int VSize);
+} BlockFormatDecoders[] =
+{
+	{ TPF_DXT1,			DecodeDXT1		},
+	{ TPF_DXT3,			DecodeDXT3		},
+	{ TPF_DXT5,			DecodeDXT5		},
+	{ TPF_DXT5N,		DecodeDXT5N		},		// restores normal map from 2 channels
+	{ TPF_BC4,			DecodeBC4		},
+	{ TPF_BC5,			DecodeBC5		},		// restores normal map from 2 channels
+	{ TPF_RGB8,			DecodeRGB8		},
+	{ TPF_BGRA8,		DecodeBGRA8		},
+	{ TPF_RGBA4,		DecodeRGBA4		},
+	{ TPF_G8,			DecodeG8		},
+	{ TPF_V8U8,			DecodeV8U8		},
+	{ TPF_V8U8_2,		DecodeV8U8_2	},
+	{ TPF_FLOAT_RGBA,	DecodeFloatRGBA	},		// float[w*h*4]
+};
+
+
+// Decode block-compressed image in parallel. Block rows are independent in all supported formats
+// (except PVRTC, which interpolates between neighbour blocks), so the image is split into horizontal
+// stripes, and each stripe is decoded as a separate image. Decode callback receives the stripe's data
+// and destination pointers, stripe height in pixels, and index of the first block row in the stripe.
+template<typename F>
+static void DecodeBlockRows(ETexturePixelFormat Format, const byte* Data, byte* Dst, int USize, int VSize, F&& Decode)
+{
+	const CPixelFormatInfo& Info = PixelFormatInfo[Format];
+	int PixelSize = Info.Float ? 16 : 4;
+	int BlockRowDataSize = (USize + Info.BlockSizeX - 1) / Info.BlockSizeX * Info.BytesPerBlock;
+	int NumBlockRows = (VSize + Info.BlockSizeY - 1) / Info.BlockSizeY;
+	int RowsPerStripe = max(DECODE_STRIPE_PIXELS / (USize * Info.BlockSizeY), 1);
+	int NumStripes = (NumBlockRows + RowsPerStripe - 1) / RowsPerStripe;
+
+	if (NumStripes <= 1)
+	{
+		// Small image, don't waste time on threading
+		Decode(Data, Dst, VSize, 0);
+		return;
+	}
+
+	ParallelFor(NumStripes, [&](int Stripe)
+		{
+			int FirstRow = Stripe * RowsPerStripe;
+			int FirstLine = FirstRow * Info.BlockSizeY;
+			int NumLines = min(RowsPerStripe * Info.BlockSizeY, VSize - FirstLine);
+			Decode(Data + FirstRow * BlockRowDataSize, Dst + FirstLine * USize * PixelSize, NumLines, FirstRow);
+		}, 1);
+}
+
+#if SUPPORT_XBOX360 || SUPPORT_PS4 || SUPPORT_SWITCH
+
+// Run untiling callback for every row of blocks, in parallel for large images. Should be used only when
+// tiling is a permutation of blocks: every destination block is written once, so row order doesn't matter.
+template<typename F>
+static void UntileBlockRows(int NumRows, int BlocksPerRow, F&& Untile)
+{
+	int RowsPerStripe = max(UNTILE_STRIPE_BLOCKS / max(BlocksPerRow, 1), 1);
+	if (NumRows <= RowsPerStripe)
+	{
+		// Small image, don't waste time on threading
+		for (int y = 0; y < NumRows; y++)
+			Untile(y);
+		return;
+	}
+
+	ParallelFor(NumRows, [&Untile](int y)
+		{
+			Untile(y);
+		}, RowsPerStripe);
+}
+
+#endif // SUPPORT_XBOX360 || SUPPORT_PS4 || SUPPORT_SWITCH
+
+static void DecodeDetexTexture(uint32 DetexFormat, uint32 DetexPixelFormat, const byte* Data, byte* Dst, int USize, int VSize)
+{
+	detexTexture tex;
+	tex.format = DetexFormat;
+	tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
+	tex.width = USize;
+	tex.height = VSize;
+	tex.width_in_blocks = (USize + 3) / 4;
+	tex.height_in_blocks = (VSize + 3) / 4;
+	detexDecompressTextureLinear(&tex, Dst, DetexPixelFormat);
+}
+
 
 unsigned CTextureData::GetFourCC() const
 {
@@ -97,7 +175,24 @@ unsigned CTextureData::GetFourCC() const
 }
 
 
-byte* CTextureData::Decompress(int MipLevel, int Slice)
+int CTextureData::GetDecompressedSize(int MipLevel) const
+{
+	if (!Mips.IsValidIndex(MipLevel))
+		return 0;
+	const CMipMap& Mip = Mips[MipLevel];
+	int pixelSize = PixelFormatInfo[Format].Float ? 16 : 4;
+	return Mip.USize * Mip.VSize * pixelSize;
+}
+
+void CTextureData::SetObject(const UUnrealMaterial* Obj)
+{
+	ObjectClass = Obj->GetClassName();
+	ObjectName = Obj->Name;
+	ObjectGame = Obj->Package ? Obj->GetPackageArchive()->Game : GAME_UNKNOWN;
+	ObjectCacheId = Obj->GetTextureCacheId();
+}
+
+byte* CTextureData::Decompress(int MipLevel, int Slice, byte* Buffer)
 {
 	guard(CTextureData::Decompress);
 
@@ -107,8 +202,6 @@ byte* CTextureData::Decompress(int MipLevel, int Slice)
 	const CMipMap& Mip = Mips[MipLevel];
 
 	// Get mip map data
-	int USize = Mip.USize;
-	int VSize = Mip.VSize;
 	const byte *Data = Mip.CompressedData;
 
 	if (Slice >= 0)
@@ -117,9 +210,41 @@ byte* CTextureData::Decompress(int MipLevel, int Slice)
 		Data += Mip.DataSize / 6 * Slice;
 	}
 
-	int pixelSize = PixelFormatInfo[Format].Float ? 16 : 4;
-	int size = USize * VSize * pixelSize;
-	byte* dst = (byte*)appMallocNoInit(size);
+	int size = GetDecompressedSize(MipLevel);
+	byte* dst = Buffer ? Buffer : (byte*)appMallocNoInit(size);
+
+	// Try to get the image from the decode cache. Mip size and format are a part of the key, so the
+	// cached image is not used when texture data was changed (e.g. different mip was selected for export).
+	CTextureCacheKey CacheKey;
+	if (ObjectCacheId)
+	{
+		CacheKey.ObjectId = ObjectCacheId;
+		CacheKey.MipLevel = MipLevel;
+		CacheKey.Slice    = Slice;
+		CacheKey.Format   = Format;
+		CacheKey.USize    = Mip.USize;
+		CacheKey.VSize    = Mip.VSize;
+		CacheKey.DataSize = Mip.DataSize;
+		if (FindCachedTexture(CacheKey, dst, size))
+			return dst;
+	}
+
+	DecompressImage(Mip, Data, dst, size);
+
+	if (ObjectCacheId)
+		AddCachedTexture(CacheKey, dst, size);
+
+	return dst;
+
+	unguard;
+}
+
+void CTextureData::DecompressImage(const CMipMap& Mip, const byte* Data, byte* dst, int size)
+{
+	guard(CTextureData::DecompressImage);
+
+	int USize = Mip.USize;
+	int VSize = Mip.VSize;
 
 #if 0
 	{
@@ -137,7 +262,7 @@ byte* CTextureData::Decompress(int MipLevel, int Slice)
 			else if (y0 == 0)		d[2] = 255;	// blue - tangent axis
 			else if (x0 + y0 < 7)	d[1] = 128;	// dark green
 		}
-		return dst;
+		return;
 	}
 #endif
 
@@ -151,125 +276,26 @@ byte* CTextureData::Decompress(int MipLevel, int Slice)
 			{
 				appNotify("DecompressTexture: TPF_P8 with NULL palette");
 				memset(dst, 0xFF, size);
-				return dst;
-			}
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				const FColor &c = Palette->Colors[Data[i]];
-				*d++ = c.R;
-				*d++ = c.G;
-				*d++ = c.B;
-				*d++ = c.A;
-			}
-		}
-		return dst;
-	case TPF_RGB8:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				// BGRA -> RGBA
-				*d++ = s[2];
-				*d++ = s[1];
-				*d++ = s[0];
-				*d++ = 255;
-				s += 3;
+				return;
 			}
+			// Convert palette to RGBA8 pixels once, so the image is decoded with a single lookup per pixel
+			uint32 Colors[256];
+			memset(Colors, 0, sizeof(Colors));
+			memcpy(Colors, Palette->Colors.GetData(), min(Palette->Colors.Num(), 256) * sizeof(FColor));
+			DecodeBlockRows(Format, Data, dst, USize, VSize, [&Colors, USize](const byte* Src, byte* Dst, int NumLines, int)
+				{
+					DecodeP8(Src, Dst, USize * NumLines, Colors);
+				});
 		}
-		return dst;
+		return;
 	case TPF_RGBA8:
 		{
 			memcpy(dst, Data, USize * VSize * 4);
 		}
-		return dst;
-	case TPF_FLOAT_RGBA:
-		{
-			const uint16 *s = (uint16*)Data;
-			float *d = (float*)dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				*d++ = half2float(*s++);
-				*d++ = half2float(*s++);
-				*d++ = half2float(*s++);
-				*d++ = half2float(*s++);
-			}
-		}
-		return dst;
-	case TPF_BGRA8:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				// BGRA -> RGBA
-				*d++ = s[2];
-				*d++ = s[1];
-				*d++ = s[0];
-				*d++ = s[3];
-				s += 4;
-			}
-		}
-		return dst;
-	case TPF_RGBA4:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				byte b1 = s[0];
-				byte b2 = s[1];
-				// BGRA -> RGBA
-				*d++ = b2 & 0xF0;
-				*d++ = (b2 & 0xF) << 4;
-				*d++ = b1 & 0xF0;
-				*d++ = (b1 & 0xF) << 4;
-				s += 2;
-			}
-		}
-		return dst;
-	case TPF_G8:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				byte b = *s++;
-				*d++ = b;
-				*d++ = b;
-				*d++ = b;
-				*d++ = 255;
-			}
-		}
-		return dst;
-	case TPF_V8U8:
-	case TPF_V8U8_2:
-		{
-			const byte *s = Data;
-			byte *d = dst;
-			byte offset = (Format == TPF_V8U8) ? 128 : 0;
-			for (int i = 0; i < USize * VSize; i++)
-			{
-				byte u = *s++ + offset;		// byte + byte -> byte, overflow is normal here
-				byte v = *s++ + offset;
-				d[0] = u;
-				d[1] = v;
-				float uf = (u - offset) / 255.0f * 2 - 1;
-				float vf = (v - offset) / 255.0f * 2 - 1;
-				float t  = 1.0f - uf * uf - vf * vf;
-				if (t >= 0)
-					d[2] = 255 - 255 * appFloor(sqrt(t));	//!! TODO: check for correct function here - should be (t+1.0)*127.5, at least for 'offset==0'
-				else
-					d[2] = 255;
-				d[3] = 255;
-				d += 4;
-			}
-		}
-		return dst;
+		return;
 	case TPF_A1:
 		appNotify("TPF_A1 unsupported");	//!! easy to do, but need samples - I've got some PF_A1 textures with no mipmaps inside
-		return dst;
+		return;
 
 #if SUPPORT_IPHONE
 	case TPF_PVRTC2:
@@ -277,59 +303,35 @@ byte* CTextureData::Decompress(int MipLevel, int Slice)
 		PROFILE_DDS(appResetProfiler());
 		PVRTDecompressPVRTC(Data, Format == TPF_PVRTC2, USize, VSize, dst);
 		PROFILE_DDS(appPrintProfiler());
-		return dst;
+		return;
 #endif // SUPPORT_IPHONE
 
 #if SUPPORT_ANDROID
 	case TPF_ETC1:
-#if 1
 		PROFILE_DDS(appResetProfiler());
-		PVRTDecompressETC(Data, USize, VSize, dst, 0);
-		PROFILE_DDS(appPrintProfiler());
+		DecodeBlockRows(Format, Data, dst, USize, VSize, [USize](const byte* Src, byte* Dst, int NumLines, int)
+			{
+#if 1
+				PVRTDecompressETC(Src, USize, NumLines, Dst, 0);
 #else
-		{
-			// NOTE: this code works well too
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_ETC1;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
-			PROFILE_DDS(appPrintProfiler());
-		}
+				// NOTE: this code works well too
+				DecodeDetexTexture(DETEX_TEXTURE_FORMAT_ETC1, DETEX_PIXEL_FORMAT_RGBA8, Src, Dst, USize, NumLines);
 #endif
-		return dst;
+			});
+		PROFILE_DDS(appPrintProfiler());
+		return;
 	case TPF_ETC2_RGB:
-		{
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_ETC2;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
-			PROFILE_DDS(appPrintProfiler());
-		}
-		return dst;
 	case TPF_ETC2_RGBA:
 		{
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_ETC2_EAC;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
+			uint32 DetexFormat = (Format == TPF_ETC2_RGB) ? DETEX_TEXTURE_FORMAT_ETC2 : DETEX_TEXTURE_FORMAT_ETC2_EAC;
 			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
+			DecodeBlockRows(Format, Data, dst, USize, VSize, [DetexFormat, USize](const byte* Src, byte* Dst, int NumLines, int)
+				{
+					DecodeDetexTexture(DetexFormat, DETEX_PIXEL_FORMAT_RGBA8, Src, Dst, USize, NumLines);
+				});
 			PROFILE_DDS(appPrintProfiler());
 		}
-		return dst;
+		return;
 	case TPF_ASTC_4x4:
 	case TPF_ASTC_6x6:
 	case TPF_ASTC_8x8:
@@ -345,130 +347,109 @@ byte* CTextureData::Decompress(int MipLevel, int Slice)
 			int blockDim = PixelFormatInfo[Format].BlockSizeX;
 			assert(PixelFormatInfo[Format].BlockSizeY == blockDim);
 			int xBlocks = (USize + blockDim - 1) / blockDim;
-			int yBlocks = (VSize + blockDim - 1) / blockDim;
 			const int xdim = blockDim, ydim = blockDim, zdim = 1, z = 0;
 			const astc_decode_mode decode_mode = DECODE_LDR;
 			static const swizzlepattern swz_decode = { 0, 1, 2, 3 };
-			imageblock pb;
+
+			// astc codec creates these tables on demand, and it is not thread-safe, so build them here
+			get_block_size_descriptor(xdim, ydim, zdim);
+			get_partition_table(xdim, ydim, zdim, 1);
 
 			astc_codec_image* img = allocate_image(8 /*bitness*/, USize, VSize, 1 /*zsize*/, 0);
 			initialize_image(img);
 
-			for (int y = 0; y < yBlocks; y++)
-			{
-				for (int x = 0; x < xBlocks; x++)
-				{
-					int offset = ((y * xBlocks) + x) * 16;
-					const byte* bp = Data + offset;
-					physical_compressed_block pcb = *(physical_compressed_block *) bp;
-					symbolic_compressed_block scb;
-					physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
-					decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
-					write_imageblock(img, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
-				}
-			}
-
-			memcpy(dst, img->imagedata8[0][0], size);
-
-			if (isNormalmap)
-			{
-				// UE4 drops blue channel for normal maps before encoding, restore it
-				byte *d = dst;
-				for (int i = 0; i < USize * VSize; i++)
+			PROFILE_DDS(appResetProfiler());
+			DecodeBlockRows(Format, Data, dst, USize, VSize, [&](const byte* Src, byte* Dst, int NumLines, int FirstRow)
 				{
-					byte u = d[0];
-					byte v = d[1];
-					assert(d[2] == 0);
-					float uf = u / 255.0f * 2 - 1;
-					float vf = v / 255.0f * 2 - 1;
-					float t  = 1.0f - uf * uf - vf * vf;
-					if (t >= 0)
-						d[2] = appFloor((t + 1.0f) * 127.5f);
-					else
-						d[2] = 255;
-					d += 4;
-				}
-			}
+					imageblock pb;
+					int yBlocks = (NumLines + ydim - 1) / ydim;
+					for (int y = FirstRow; y < FirstRow + yBlocks; y++)
+					{
+						for (int x = 0; x < xBlocks; x++)
+						{
+							const byte* bp = Src + (((y - FirstRow) * xBlocks) + x) * 16;
+							physical_compressed_block pcb = *(physical_compressed_block *) bp;
+							symbolic_compressed_block scb;
+							physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
+							decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
+							write_imageblock(img, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
+						}
+					}
+
+					memcpy(Dst, img->imagedata8[0][FirstRow * ydim], USize * NumLines * 4);
+
+					if (isNormalmap)
+					{
+						// UE4 drops blue channel for normal maps before encoding, restore it
+						byte *d = Dst;
+						for (int i = 0; i < USize * NumLines; i++)
+						{
+							byte u = d[0];
+							byte v = d[1];
+							assert(d[2] == 0);
+							float uf = u / 255.0f * 2 - 1;
+							float vf = v / 255.0f * 2 - 1;
+							float t  = 1.0f - uf * uf - vf * vf;
+							if (t >= 0)
+								d[2] = appFloor((t + 1.0f) * 127.5f);
+							else
+								d[2] = 255;
+							d += 4;
+						}
+					}
+				});
+			PROFILE_DDS(appPrintProfiler());
 
 			destroy_image(img);
 		}
-		return dst;
+		return;
 #endif // SUPPORT_ANDROID
 	case TPF_BC6H:
-		{
-			// decompress HDR image as float[w*h*4]
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_BPTC_FLOAT;
-			tex.data = const_cast<byte*>(Data);
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
-			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_FLOAT_RGBX32);
-			PROFILE_DDS(appPrintProfiler());
-		}
-		return dst;
 	case TPF_BC7:
 		{
-			detexTexture tex;
-			tex.format = DETEX_TEXTURE_FORMAT_BPTC;
-			tex.data = const_cast<byte*>(Data);	// will be used as 'const' anyway
-			tex.width = USize;
-			tex.height = VSize;
-			tex.width_in_blocks = USize / 4;
-			tex.height_in_blocks = VSize / 4;
+			// BC6H is HDR format, decompress it as float[w*h*4]
+			uint32 DetexFormat = (Format == TPF_BC6H) ? DETEX_TEXTURE_FORMAT_BPTC_FLOAT : DETEX_TEXTURE_FORMAT_BPTC;
+			uint32 DetexPixelFormat = (Format == TPF_BC6H) ? DETEX_PIXEL_FORMAT_FLOAT_RGBX32 : DETEX_PIXEL_FORMAT_RGBA8;
 			PROFILE_DDS(appResetProfiler());
-			detexDecompressTextureLinear(&tex, dst, DETEX_PIXEL_FORMAT_RGBA8);
+			DecodeBlockRows(Format, Data, dst, USize, VSize, [DetexFormat, DetexPixelFormat, USize](const byte* Src, byte* Dst, int NumLines, int)
+				{
+					DecodeDetexTexture(DetexFormat, DetexPixelFormat, Src, Dst, USize, NumLines);
+				});
 			PROFILE_DDS(appPrintProfiler());
 		}
-		return dst;
+		return;
 	case TPF_PNG_BGRA:
 	case TPF_PNG_RGBA:
 		if (UncompressPNG(Mip.CompressedData, Mip.DataSize, Mip.USize, Mip.VSize, dst, Format == TPF_PNG_BGRA))
 		{
-			return dst;
+			return;
 		}
 		break;
+	default:
+		// Other formats are decoded by BlockFormatDecoders or FourCC code below
+		break;
 	}
 
 	static_assert(ARRAY_COUNT(PixelFormatInfo) == TPF_MAX, "Wrong PixelFormatInfo array size");
-	unsigned fourCC = PixelFormatInfo[Format].FourCC;
-	if (!fourCC)
-	{
-		appNotify("Unable to unpack texture %s: unsupported texture format %s\n", ObjectName, PixelFormatInfo[Format].Name);
-		memset(dst, 0xFF, size);
-		return dst;
-	}
 
-	PROFILE_DDS(appResetProfiler());
-
-	nv::DDSHeader header;
-	nv::Image image;
-	header.setFourCC(fourCC & 0xFF, (fourCC >> 8) & 0xFF, (fourCC >> 16) & 0xFF, (fourCC >> 24) & 0xFF);
-	header.setWidth(USize);
-	header.setHeight(VSize);
-	header.setNormalFlag(Format == TPF_DXT5N || Format == TPF_BC5);	// flag to restore normalmap from 2 colors
-	DecodeDDS(Data, USize, VSize, header, image);
-
-	byte *s = (byte*)image.pixels();
-	byte *d = dst;
-
-	for (int i = 0; i < USize * VSize; i++, s += 4, d += 4)
+	// DXT/BCn and simple uncompressed formats
+	for (const auto& Decoder : BlockFormatDecoders)
 	{
-		// BGRA -> RGBA
-		d[0] = s[2];
-		d[1] = s[1];
-		d[2] = s[0];
-		d[3] = s[3];
+		if (Decoder.Format == Format)
+		{
+			PROFILE_DDS(appResetProfiler());
+			DecodeBlockRows(Format, Data, dst, USize, VSize, [&Decoder, USize](const byte* Src, byte* Dst, int NumLines, int)
+				{
+					Decoder.Decode(Src, Dst, USize, NumLines);
+				});
+			PROFILE_DDS(appPrintProfiler());
+			return;
+		}
 	}
 
-	PROFILE_DDS(appPrintProfiler());
-
-	if (Format == TPF_DXT1)
-		PostProcessAlpha(dst, USize, VSize);	//??
-
-	return dst;
+	appNotify("Unable to unpack texture %s: unsupported texture format %s\n", ObjectName, PixelFormatInfo[Format].Name);
+	memset(dst, 0xFF, size);
+	return;
 	unguardf("fmt=%s(%d)", OriginalFormatName, OriginalFormatEnum);
 }
 
@@ -514,6 +495,32 @@ static unsigned GetXbox360TiledOffset(int x, int y, int width, int logBpb)
 			) >> logBpb;
 }
 
+// Tiling is the same for all 32x32 tiles of blocks, only the tile's base address depends on its position
+// and on image width. So swizzle pattern of a single tile is precomputed for each block size, and block
+// address is computed as GetXbox360TiledOffset(tileX, tileY) + Xbox360TileOffsets[y & 31][x & 31].
+static uint16 Xbox360TileOffsets[5][32 * 32];		// indexed with log2(bytesPerBlock)
+
+static bool BuildXbox360TileOffsets()
+{
+	for (int logBpb = 0; logBpb < 5; logBpb++)
+	{
+		for (int y = 0; y < 32; y++)
+		{
+			for (int x = 0; x < 32; x++)
+				Xbox360TileOffsets[logBpb][y * 32 + x] = GetXbox360TiledOffset(x, y, 32, logBpb);
+		}
+	}
+	return true;
+}
+
+static const uint16* GetXbox360TileOffsets(int logBpb)
+{
+	static bool Initialized = BuildXbox360TileOffsets();		// thread-safe initialization
+	(void)Initialized;
+	assert(logBpb >= 0 && logBpb < 5);
+	return Xbox360TileOffsets[logBpb];
+}
+
 // Untile decompressed texture. The function also removes U alignment when originalWidth < tiledWidth
 // Note: this function is no longer used, and now it is outdated. UntileCompressedXbox360Texture is now used and up-to-date.
 static void UntileXbox360Texture(const unsigned *src, unsigned *dst, int tiledWidth, int originalWidth, int height, int blockSizeX, int blockSizeY, int bytesPerBlock)
@@ -594,22 +601,33 @@ static void UntileCompressedXbox360Texture(const byte *src, byte *dst, int tiled
 	}
 
 	int numImageBlocks = tiledBlockWidth * tiledBlockHeight;	// used for verification
+	const uint16* TileOffsets = GetXbox360TileOffsets(logBpp);
 
 	// Iterate over image blocks
-	for (int dy = 0; dy < originalBlockHeight; dy++)
-	{
-		for (int dx = 0; dx < originalBlockWidth; dx++)
+	UntileBlockRows(originalBlockHeight, originalBlockWidth, [=](int dy)
 		{
-			unsigned swzAddr = GetXbox360TiledOffset(dx + sxOffset, dy, tiledBlockWidth, logBpp);	// do once for whole block
-			assert(swzAddr < numImageBlocks);
-			int sy = swzAddr / tiledBlockWidth;
-			int sx = swzAddr % tiledBlockWidth;
-
-			byte       *pDst = dst + (dy * originalBlockWidth + dx) * bytesPerBlock;
-			const byte *pSrc = src + (sy * tiledBlockWidth    + sx) * bytesPerBlock;
-			memcpy(pDst, pSrc, bytesPerBlock);
-		}
-	}
+			const uint16* RowOffsets = TileOffsets + (dy & 31) * 32;
+			byte* pDst = dst + dy * originalBlockWidth * bytesPerBlock;
+			int dx = 0;
+			while (dx < originalBlockWidth)
+			{
+				// Process blocks of a single tile
+				int tileX = (dx + sxOffset) & ~31;
+				int tileEnd = min(tileX + 32 - sxOffset, originalBlockWidth);
+				unsigned tileAddr = GetXbox360TiledOffset(tileX, dy & ~31, tiledBlockWidth, logBpp);
+				while (dx < tileEnd)
+				{
+					unsigned swzAddr = tileAddr + RowOffsets[(dx + sxOffset) & 31];
+					// Copy sequential blocks at once
+					int count = 1;
+					while (dx + count < tileEnd && tileAddr + RowOffsets[(dx + count + sxOffset) & 31] == swzAddr + count)
+						count++;
+					assert(swzAddr + count <= numImageBlocks);
+					memcpy(pDst + dx * bytesPerBlock, src + swzAddr * bytesPerBlock, count * bytesPerBlock);
+					dx += count;
+				}
+			}
+		});
 	unguard;
 }
 
@@ -746,6 +764,56 @@ static unsigned GetPS4TiledOffset(int x, int y, int width)
 	return mx + my * width;
 }
 
+// Tiling moves blocks only within bands of 8 block rows, and all bands have the same layout. So offsets are
+// precomputed for the first band, and these tables are cached for reuse with other textures of the same width.
+
+#define PS4_SWIZZLE_CACHE_SIZE		32		// max number of different image widths with cached tables
+
+struct CPS4SwizzleTable
+{
+	int				Width;
+	TArray<int>		Offsets;				// Width * 8 entries
+};
+
+static CPS4SwizzleTable PS4SwizzleTables[PS4_SWIZZLE_CACHE_SIZE];
+static int NumPS4SwizzleTables = 0;
+
+#if THREADING
+static CMutex PS4SwizzleMutex;
+#endif
+
+static void BuildPS4SwizzleTable(int width, TArray<int>& Offsets)
+{
+	Offsets.SetNumUninitialized(width * 8);
+	for (int y = 0; y < 8; y++)
+	{
+		for (int x = 0; x < width; x++)
+			Offsets[y * width + x] = GetPS4TiledOffset(x, y, width);
+	}
+}
+
+// Returns cached table, or builds the table in LocalTable when the cache is full
+static const int* GetPS4SwizzleTable(int width, TArray<int>& LocalTable)
+{
+#if THREADING
+	CMutex::ScopedLock Lock(PS4SwizzleMutex);
+#endif
+	for (int i = 0; i < NumPS4SwizzleTables; i++)
+	{
+		if (PS4SwizzleTables[i].Width == width)
+			return PS4SwizzleTables[i].Offsets.GetData();
+	}
+	if (NumPS4SwizzleTables >= PS4_SWIZZLE_CACHE_SIZE)
+	{
+		BuildPS4SwizzleTable(width, LocalTable);
+		return LocalTable.GetData();
+	}
+	CPS4SwizzleTable& Table = PS4SwizzleTables[NumPS4SwizzleTables++];
+	Table.Width = width;
+	BuildPS4SwizzleTable(width, Table.Offsets);
+	return Table.Offsets.GetData();
+}
+
 static void UntileCompressedPS4Texture(const byte *src, byte *dst, int width, int height, int blockSizeX, int blockSizeY, int bytesPerBlock)
 {
 	guard(UntileCompressedPS4Texture);
@@ -757,25 +825,47 @@ static void UntileCompressedPS4Texture(const byte *src, byte *dst, int width, in
 	int blockWidth2 = max(blockWidth, 8);
 	int blockHeight2 = max(blockHeight, 8);
 
-	// Iterate over image blocks
-	for (int sy = 0; sy < blockHeight2; sy++)
-	{
-		for (int sx = 0; sx < blockWidth2; sx++)
+	TArray<int> LocalTable;
+	const int* Offsets = GetPS4SwizzleTable(blockWidth2, LocalTable);
+
+	auto UntileRow = [=](int sy)
 		{
-			unsigned swzAddr = GetPS4TiledOffset(sx, sy, blockWidth2);	// do once for whole block
-			int dy = swzAddr / blockWidth2;
-			int dx = swzAddr % blockWidth2;
-			if (dx >= blockWidth || dy >= blockHeight)
+			const int* RowOffsets = Offsets + (sy & 7) * blockWidth2;
+			int bandAddr = (sy & ~7) * blockWidth2;
+			const byte* pSrc = src + sy * blockWidth2 * bytesPerBlock;
+			int sx = 0;
+			while (sx < blockWidth2)
 			{
-				// We're sampling over source image coordinates which could be
-				// larger than target image, so perform clamping
-				continue;
+				int swzAddr = bandAddr + RowOffsets[sx];
+				int dy = swzAddr / blockWidth2;
+				int dx = swzAddr % blockWidth2;
+				if (dx >= blockWidth || dy >= blockHeight)
+				{
+					// We're sampling over source image coordinates which could be
+					// larger than target image, so perform clamping
+					sx++;
+					continue;
+				}
+				// Copy sequential blocks at once
+				int count = 1;
+				while (sx + count < blockWidth2 && dx + count < blockWidth && RowOffsets[sx + count] == RowOffsets[sx] + count)
+					count++;
+				memcpy(dst + (dy * blockWidth + dx) * bytesPerBlock, pSrc + sx * bytesPerBlock, count * bytesPerBlock);
+				sx += count;
 			}
+		};
 
-			byte       *pDst = dst + (dy * blockWidth + dx) * bytesPerBlock;
-			const byte *pSrc = src + (sy * blockWidth2 + sx) * bytesPerBlock;
-			memcpy(pDst, pSrc, bytesPerBlock);
-		}
+	// Iterate over image blocks
+	if (blockWidth2 & 7)
+	{
+		// Tiling is not a permutation for such width, some source blocks are written to the same place,
+		// so keep the original processing order
+		for (int sy = 0; sy < blockHeight2; sy++)
+			UntileRow(sy);
+	}
+	else
+	{
+		UntileBlockRows(blockHeight2, blockWidth2, UntileRow);
 	}
 
 	unguard;
@@ -874,38 +964,59 @@ static bool UntileCompressedNSWTexture(const byte *src, int dataSize, byte *dst,
 //	appPrintf("mip: %d x %d (%d/%d x %d/%d) data: comp: %X, real: %X\n",
 //		blockWidth, blockHeight, width, blockSizeX, height, blockSizeY,
 //		blockWidth * blockHeight * bytesPerBlock, dataSize);
-	// Iterate over image blocks
+
+	// Swizzled address is a sum of values which depend only on X or only on Y coordinate,
+	// so compute these parts once for every column and every row of blocks
+	TArray<unsigned> xOffsets, yOffsets;
+	xOffsets.SetNumUninitialized(blockWidth);
+	yOffsets.SetNumUninitialized(blockHeight);
+	unsigned maxXOffset = 0;
+	for (int dx = 0; dx < blockWidth; dx++)
+	{
+		int x_coord_in_block = dx * bytesPerBlock;
+		unsigned gobOffset = (x_coord_in_block / bytes_per_gob_x) * bytes_per_gob_y;
+		unsigned offset =
+			(((x_coord_in_block & 0x3f) >> 5) << 8) + //?? 0011.1111 >> 5 -> 0001, i.e. mask 1 bit and shift it to appropriate position
+			(((x_coord_in_block & 0x1f) >> 4) << 5) +
+			(  x_coord_in_block &  0xf            );
+		xOffsets[dx] = gobOffset * 512 + offset; // should be gob_bytes, but this won't work for (bytes_per_gob_y != 8), so we'll use a constant here
+		maxXOffset = max(maxXOffset, xOffsets[dx]);
+	}
 	for (int dy = 0; dy < blockHeight; dy++)
 	{
-		for (int dx = 0; dx < blockWidth; dx++)
-		{
-			int x_coord_in_block = dx * bytesPerBlock;
-			int y_coord_in_block = dy;
-			unsigned gobOffset =
-				(x_coord_in_block / bytes_per_gob_x) * bytes_per_gob_y +
-				y_coord_in_block / (bytes_per_gob_y * 8) * bytes_per_gob_y * gobs_per_block_x +
-				(y_coord_in_block % (bytes_per_gob_y * 8) >> 3);
-			gobOffset = gobOffset * 512; // should be gob_bytes, but this won't work for (bytes_per_gob_y != 8), so we'll use a constant here
-
-			unsigned offset =
-				(((x_coord_in_block & 0x3f) >> 5) << 8) + //?? 0011.1111 >> 5 -> 0001, i.e. mask 1 bit and shift it to appropriate position
-				(((y_coord_in_block &    7) >> 1) << 6) +
-				(((x_coord_in_block & 0x1f) >> 4) << 5) +
-				( (y_coord_in_block &    1)       << 4) +
-				(  x_coord_in_block &  0xf            );
-
-			unsigned swzAddr = gobOffset + offset;
-//			if (swzAddr >= dataSize) appPrintf("x=%d/%d, y=%d/%d, sy=%d, swzAddr=%d+%d->%d >= %d\n",
-//				dx, blockWidth, dy, blockHeight, bytes_per_gob_y, gobOffset, offset, swzAddr, dataSize);
-			if (swzAddr >= dataSize)
-				return false; // failed, something's wrong with parameters or decoder
-
-			byte       *pDst = dst + (dy * blockWidth + dx) * bytesPerBlock;
-			const byte *pSrc = src + swzAddr;
-			memcpy(pDst, pSrc, bytesPerBlock);
-		}
+		int y_coord_in_block = dy;
+		unsigned gobOffset =
+			y_coord_in_block / (bytes_per_gob_y * 8) * bytes_per_gob_y * gobs_per_block_x +
+			(y_coord_in_block % (bytes_per_gob_y * 8) >> 3);
+		unsigned offset =
+			(((y_coord_in_block &    7) >> 1) << 6) +
+			( (y_coord_in_block &    1)       << 4);
+		yOffsets[dy] = gobOffset * 512 + offset;
+//		if (yOffsets[dy] + maxXOffset >= dataSize) appPrintf("y=%d/%d, sy=%d, swzAddr=%d+%d->%d >= %d\n",
+//			dy, blockHeight, bytes_per_gob_y, yOffsets[dy], maxXOffset, yOffsets[dy] + maxXOffset, dataSize);
+		if (blockWidth > 0 && yOffsets[dy] + maxXOffset >= dataSize)
+			return false; // failed, something's wrong with parameters or decoder
 	}
 
+	// Iterate over image blocks
+	const unsigned* xOffs = xOffsets.GetData();
+	const unsigned* yOffs = yOffsets.GetData();
+	UntileBlockRows(blockHeight, blockWidth, [=](int dy)
+		{
+			byte       *pDst = dst + dy * blockWidth * bytesPerBlock;
+			const byte *pSrc = src + yOffs[dy];
+			int dx = 0;
+			while (dx < blockWidth)
+			{
+				// Copy sequential blocks at once (usually 16 bytes of GOB row)
+				int count = 1;
+				while (dx + count < blockWidth && xOffs[dx + count] == xOffs[dx] + count * bytesPerBlock)
+					count++;
+				memcpy(pDst + dx * bytesPerBlock, pSrc + xOffs[dx], count * bytesPerBlock);
+				dx += count;
+			}
+		});
+
 	return true;
 	unguard;
 }
@@ -574,7 +574,17 @@ bool UTexture::GetTextureData(CTextureData &TexData) const
 	if (TexData.Mips.Num() == 0)
 	{
 		// texture was not taken from external source
+		int FirstMip = 0;
 		for (int n = 0; n < Mips.Num(); n++)
+		{
+			// find the first selected mipmap with data, or the smallest one when all are too large
+			if (!Mips[n].DataArray.Num())
+				continue;
+			FirstMip = n;
+			if (!TexData.ShouldSkipMip(n, Mips[n].USize, Mips[n].VSize))
+				break;
+		}
+		for (int n = FirstMip; n < Mips.Num(); n++)
 		{
 			// find 1st mipmap with non-null data array
 			// reference: DemoPlayerSkins.utx/DemoSkeleton have null-sized 1st 2 mips
@@ -999,7 +999,22 @@ bool UTexture2D::GetTextureData(CTextureData &TexData) const
 		bool dataLoaded = false;
 		int OrigUSize = (*MipsArray)[0].SizeX;
 		int OrigVSize = (*MipsArray)[0].SizeY;
-		for (int mipLevel = 0; mipLevel < MipsArray->Num(); mipLevel++)
+		int FirstMip = 0;
+		if (TexData.MipBias || TexData.MaxMipSize)
+		{
+			// Find the first selected mip which has data, so bulk data of larger mips won't be loaded.
+			// When all mips are too large, use the smallest one.
+			for (int mipLevel = 0; mipLevel < MipsArray->Num(); mipLevel++)
+			{
+				const FByteBulkData &Bulk = (*MipsArray)[mipLevel].Data;
+				if (!Bulk.BulkData && ((Bulk.BulkDataFlags & BULKDATA_Unused) || !(Bulk.BulkDataFlags & BULKDATA_StoreInSeparateFile)))
+					continue;
+				FirstMip = mipLevel;
+				if (!TexData.ShouldSkipMip(mipLevel, max(1, OrigUSize >> mipLevel), max(1, OrigVSize >> mipLevel)))
+					break;
+			}
+		}
+		for (int mipLevel = FirstMip; mipLevel < MipsArray->Num(); mipLevel++)
 		{
 			// find 1st mipmap with non-null data array
 			const FTexture2DMipMap &Mip = (*MipsArray)[mipLevel];
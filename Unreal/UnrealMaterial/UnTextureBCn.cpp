@@ -0,0 +1,298 @@
+#include "Core.h"
+#include "UnCore.h"
+#include "UnObject.h"
+#include "UnMaterial.h"
+#include "UnTextureBCn.h"
+#include "MathSSE2.h"
+
+#include <math.h>
+
+/*-----------------------------------------------------------------------------
+	DXT/BCn texture decoders
+
+	Decoders produce exactly the same result as NVTT's DirectDrawSurface did
+	(including normal map reconstruction for DXT5N and BC5), but write RGBA8
+	pixels directly into the destination buffer with a single pass over the
+	image. Pixels are processed as uint32 values with R in the lowest byte.
+-----------------------------------------------------------------------------*/
+
+#define RGBA32(r,g,b,a)			( (r) | ((g) << 8) | ((b) << 16) | ((a) << 24) )
+
+// Build 4-color palette of DXT1 color block. The same palette is used for DXT3 and DXT5 color part,
+// and 3-color mode is allowed for these formats too (it matches NVTT behavior).
+static FORCEINLINE void DecodeColorPalette(const byte* Block, uint32* Palette)
+{
+	uint32 c0 = Block[0] | (Block[1] << 8);
+	uint32 c1 = Block[2] | (Block[3] << 8);
+
+	// Expand 5:6:5 to 8:8:8
+	uint32 r0 = (c0 >> 11) & 0x1F, g0 = (c0 >> 5) & 0x3F, b0 = c0 & 0x1F;
+	uint32 r1 = (c1 >> 11) & 0x1F, g1 = (c1 >> 5) & 0x3F, b1 = c1 & 0x1F;
+	r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+	r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+#if USE_SSE2
+	// Both colors in a single register as 16-bit values: [ c0 | c1 ]
+	__m128i c = _mm_setr_epi16(r0, g0, b0, 255, r1, g1, b1, 255);
+	__m128i swapped = _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));	// [ c1 | c0 ]
+	__m128i mid;
+	if (c0 > c1)
+	{
+		// 4-color block: [ (2*c0+c1)/3 | (c0+2*c1)/3 ], division by 3 is done with multiplication
+		// (exact for values up to 765)
+		mid = _mm_add_epi16(_mm_add_epi16(c, c), swapped);
+		mid = _mm_mulhi_epu16(mid, _mm_set1_epi16(21846));
+	}
+	else
+	{
+		// 3-color block: [ (c0+c1)/2 | transparent black ]
+		mid = _mm_srli_epi16(_mm_add_epi16(c, swapped), 1);
+		mid = _mm_move_epi64(mid);
+	}
+	_mm_storeu_si128((__m128i*)Palette, _mm_packus_epi16(c, mid));
+#else
+	Palette[0] = RGBA32(r0, g0, b0, 255);
+	Palette[1] = RGBA32(r1, g1, b1, 255);
+	if (c0 > c1)
+	{
+		Palette[2] = RGBA32((2*r0 + r1) / 3, (2*g0 + g1) / 3, (2*b0 + b1) / 3, 255);
+		Palette[3] = RGBA32((r0 + 2*r1) / 3, (g0 + 2*g1) / 3, (b0 + 2*b1) / 3, 255);
+	}
+	else
+	{
+		Palette[2] = RGBA32((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+		Palette[3] = 0;
+	}
+#endif // USE_SSE2
+}
+
+static FORCEINLINE void DecodeColorBlock(const byte* Block, uint32* Pixels)
+{
+	uint32 Palette[4];
+	DecodeColorPalette(Block, Palette);
+	uint32 Indices = Block[4] | (Block[5] << 8) | (Block[6] << 16) | (Block[7] << 24);
+	for (int i = 0; i < 16; i++, Indices >>= 2)
+	{
+		Pixels[i] = Palette[Indices & 3];
+	}
+}
+
+// Decode 8-byte DXT5 alpha block (BC4 and BC5 channels use the same encoding)
+static FORCEINLINE void DecodeAlphaBlock(const byte* Block, byte* Values)
+{
+	uint32 a0 = Block[0];
+	uint32 a1 = Block[1];
+
+	byte Palette[8];
+#if USE_SSE2
+	// Division by 7 and 5 is done with multiplication, it is exact for the used value range
+	__m128i v;
+	if (a0 > a1)
+	{
+		// 8-alpha block: (k*a0 + (7-k)*a1) / 7
+		__m128i w0 = _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1);
+		__m128i w1 = _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6);
+		v = _mm_add_epi16(_mm_mullo_epi16(w0, _mm_set1_epi16(a0)), _mm_mullo_epi16(w1, _mm_set1_epi16(a1)));
+		v = _mm_mulhi_epu16(v, _mm_set1_epi16(9363));
+	}
+	else
+	{
+		// 6-alpha block: (k*a0 + (5-k)*a1) / 5, plus 0 and 255
+		__m128i w0 = _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0);
+		__m128i w1 = _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0);
+		v = _mm_add_epi16(_mm_mullo_epi16(w0, _mm_set1_epi16(a0)), _mm_mullo_epi16(w1, _mm_set1_epi16(a1)));
+		v = _mm_mulhi_epu16(v, _mm_set1_epi16(13108));
+		v = _mm_or_si128(v, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+	}
+	_mm_storel_epi64((__m128i*)Palette, _mm_packus_epi16(v, v));
+#else
+	Palette[0] = a0;
+	Palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int k = 1; k < 7; k++)
+			Palette[k+1] = ((7-k) * a0 + k * a1) / 7;
+	}
+	else
+	{
+		for (int k = 1; k < 5; k++)
+			Palette[k+1] = ((5-k) * a0 + k * a1) / 5;
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+#endif // USE_SSE2
+
+	// 16 3-bit indices
+	uint64 Indices = 0;
+	for (int i = 7; i >= 2; i--)
+		Indices = (Indices << 8) | Block[i];
+	for (int i = 0; i < 16; i++, Indices >>= 3)
+	{
+		Values[i] = Palette[Indices & 7];
+	}
+}
+
+// Table used for restoring Z component of normal map, indexed with X + Y * 256
+static byte NormalZTable[256 * 256];
+
+static bool BuildNormalZTable()
+{
+	for (int y = 0; y < 256; y++)
+	{
+		for (int x = 0; x < 256; x++)
+		{
+			// Exactly the same computations as NVTT's buildNormal() does
+			float nx = 2 * (x / 255.0f) - 1;
+			float ny = 2 * (y / 255.0f) - 1;
+			float nz = 0.0f;
+			if (1 - nx*nx - ny*ny > 0) nz = sqrtf(1 - nx*nx - ny*ny);
+			int z = int(255.0f * (nz + 1) / 2.0f);
+			NormalZTable[y * 256 + x] = (byte)bound(z, 0, 255);
+		}
+	}
+	return true;
+}
+
+static const byte* GetNormalZTable()
+{
+	static bool Initialized = BuildNormalZTable();		// thread-safe initialization
+	(void)Initialized;
+	return NormalZTable;
+}
+
+static void DecodeBlockDXT1(const byte* Block, uint32* Pixels, const byte* /*NormalZ*/)
+{
+	DecodeColorBlock(Block, Pixels);
+}
+
+static void DecodeBlockDXT3(const byte* Block, uint32* Pixels, const byte* /*NormalZ*/)
+{
+	DecodeColorBlock(Block + 8, Pixels);
+	for (int i = 0; i < 16; i += 2)
+	{
+		uint32 a = Block[i >> 1];
+		Pixels[i]   = (Pixels[i]   & 0x00FFFFFF) | (((a & 0x0F) * 0x11) << 24);
+		Pixels[i+1] = (Pixels[i+1] & 0x00FFFFFF) | (((a >> 4) * 0x11) << 24);
+	}
+}
+
+static void DecodeBlockDXT5(const byte* Block, uint32* Pixels, const byte* /*NormalZ*/)
+{
+	byte Alpha[16];
+	DecodeColorBlock(Block + 8, Pixels);
+	DecodeAlphaBlock(Block, Alpha);
+	for (int i = 0; i < 16; i++)
+	{
+		Pixels[i] = (Pixels[i] & 0x00FFFFFF) | (Alpha[i] << 24);
+	}
+}
+
+static void DecodeBlockDXT5N(const byte* Block, uint32* Pixels, const byte* NormalZ)
+{
+	// Normal map with X in alpha and Y in green channel
+	byte Alpha[16];
+	DecodeColorBlock(Block + 8, Pixels);
+	DecodeAlphaBlock(Block, Alpha);
+	for (int i = 0; i < 16; i++)
+	{
+		uint32 x = Alpha[i];
+		uint32 y = (Pixels[i] >> 8) & 0xFF;
+		Pixels[i] = RGBA32(x, y, NormalZ[x + y * 256], 255);
+	}
+}
+
+static void DecodeBlockBC4(const byte* Block, uint32* Pixels, const byte* /*NormalZ*/)
+{
+	byte Values[16];
+	DecodeAlphaBlock(Block, Values);
+	for (int i = 0; i < 16; i++)
+	{
+		uint32 v = Values[i];
+		Pixels[i] = RGBA32(v, v, v, 255);
+	}
+}
+
+static void DecodeBlockBC5(const byte* Block, uint32* Pixels, const byte* NormalZ)
+{
+	// Normal map with X and Y channels
+	byte X[16], Y[16];
+	DecodeAlphaBlock(Block, X);
+	DecodeAlphaBlock(Block + 8, Y);
+	for (int i = 0; i < 16; i++)
+	{
+		uint32 x = X[i];
+		uint32 y = Y[i];
+		Pixels[i] = RGBA32(x, y, NormalZ[x + y * 256], 255);
+	}
+}
+
+typedef void (*BlockDecodeFunc)(const byte* Block, uint32* Pixels, const byte* NormalZ);
+
+template<BlockDecodeFunc DecodeBlock, int BlockSize, bool IsNormalmap>
+static void DecodeBlockImage(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	const byte* NormalZ = IsNormalmap ? GetNormalZTable() : NULL;
+
+	int NumBlocksX = (USize + 3) / 4;
+	int NumBlocksY = (VSize + 3) / 4;
+	uint32 Pixels[16];
+
+	for (int BlockY = 0; BlockY < NumBlocksY; BlockY++)
+	{
+		int NumRows = min(4, VSize - BlockY * 4);
+		uint32* DstRow = (uint32*)Dst + BlockY * 4 * USize;
+		for (int BlockX = 0; BlockX < NumBlocksX; BlockX++, Data += BlockSize, DstRow += 4)
+		{
+			DecodeBlock(Data, Pixels, NormalZ);
+			int NumColumns = min(4, USize - BlockX * 4);
+			if (NumColumns == 4)
+			{
+				// The most common case: copy whole block rows
+				for (int y = 0; y < NumRows; y++)
+				{
+#if USE_SSE2
+					_mm_storeu_si128((__m128i*)(DstRow + y * USize), _mm_loadu_si128((const __m128i*)(Pixels + y * 4)));
+#else
+					memcpy(DstRow + y * USize, Pixels + y * 4, 16);
+#endif
+				}
+			}
+			else
+			{
+				// Partial block at the right edge of the image
+				for (int y = 0; y < NumRows; y++)
+					memcpy(DstRow + y * USize, Pixels + y * 4, NumColumns * 4);
+			}
+		}
+	}
+}
+
+void DecodeDXT1(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeBlockImage<DecodeBlockDXT1, 8, false>(Data, Dst, USize, VSize);
+}
+
+void DecodeDXT3(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeBlockImage<DecodeBlockDXT3, 16, false>(Data, Dst, USize, VSize);
+}
+
+void DecodeDXT5(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeBlockImage<DecodeBlockDXT5, 16, false>(Data, Dst, USize, VSize);
+}
+
+void DecodeDXT5N(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeBlockImage<DecodeBlockDXT5N, 16, true>(Data, Dst, USize, VSize);
+}
+
+void DecodeBC4(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeBlockImage<DecodeBlockBC4, 8, false>(Data, Dst, USize, VSize);
+}
+
+void DecodeBC5(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeBlockImage<DecodeBlockBC5, 16, true>(Data, Dst, USize, VSize);
+}
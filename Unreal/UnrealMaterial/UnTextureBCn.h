@@ -0,0 +1,12 @@
+#ifndef __UNTEXTUREBCN_H__
+#define __UNTEXTUREBCN_H__
+
+// DXT/BCn decoders, implemented in UnTextureBCn.cpp. Dst receives RGBA8 image of USize x VSize pixels.
+void DecodeDXT1(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeDXT3(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeDXT5(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeDXT5N(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeBC4(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeBC5(const byte* Data, byte* Dst, int USize, int VSize);
+
+#endif // __UNTEXTUREBCN_H__
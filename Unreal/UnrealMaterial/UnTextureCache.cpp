@@ -0,0 +1,200 @@
+#include "Core.h"
+#include "UnCore.h"
+#include "UnObject.h"
+#include "UnMaterial.h"
+
+#include "Parallel.h"
+
+/*-----------------------------------------------------------------------------
+	Texture decode cache
+
+	Keeps decoded mipmaps, so the same texture shown in the viewer and exported
+	(or exported with a material, and then with a mesh) is decoded only once.
+	Cached images are identified by a texture object and mip level. Objects get
+	unique ids instead of using object pointers, because memory of a released
+	object could be reused by another texture. Least recently used images are
+	dropped when the cache exceeds its size limit.
+-----------------------------------------------------------------------------*/
+
+#define TEXTURE_CACHE_DEFAULT_SIZE	256		// megabytes
+#define TEXTURE_CACHE_HASH_SIZE		1024	// should be power of 2
+
+struct CTextureCacheEntry
+{
+	CTextureCacheKey	Key;
+	byte*				Data;
+	int					Size;
+	// LRU list, most recently used entry is at head
+	CTextureCacheEntry*	Prev;
+	CTextureCacheEntry*	Next;
+	CTextureCacheEntry*	HashNext;
+};
+
+static CTextureCacheEntry* TextureCacheHash[TEXTURE_CACHE_HASH_SIZE];
+static CTextureCacheEntry* TextureCacheHead = NULL;
+static CTextureCacheEntry* TextureCacheTail = NULL;
+static int64 TextureCacheSize = 0;								// memory used by cached images
+static int64 TextureCacheLimit = (int64)TEXTURE_CACHE_DEFAULT_SIZE << 20;
+static volatile int32 LastTextureCacheId = 0;
+
+#if THREADING
+static CMutex TextureCacheMutex;
+#endif
+
+static FORCEINLINE bool operator==(const CTextureCacheKey& A, const CTextureCacheKey& B)
+{
+	return memcmp(&A, &B, sizeof(CTextureCacheKey)) == 0;
+}
+
+// All images of the same object are placed into a single hash chain, for faster ReleaseCachedTextures()
+static FORCEINLINE int GetTextureCacheHash(int32 ObjectId)
+{
+	return ObjectId & (TEXTURE_CACHE_HASH_SIZE - 1);
+}
+
+static void UnlinkLRU(CTextureCacheEntry* E)
+{
+	if (E->Prev) E->Prev->Next = E->Next; else TextureCacheHead = E->Next;
+	if (E->Next) E->Next->Prev = E->Prev; else TextureCacheTail = E->Prev;
+	E->Prev = E->Next = NULL;
+}
+
+static void LinkLRU(CTextureCacheEntry* E)
+{
+	E->Prev = NULL;
+	E->Next = TextureCacheHead;
+	if (TextureCacheHead) TextureCacheHead->Prev = E; else TextureCacheTail = E;
+	TextureCacheHead = E;
+}
+
+static void RemoveEntry(CTextureCacheEntry* E)
+{
+	CTextureCacheEntry** Link = &TextureCacheHash[GetTextureCacheHash(E->Key.ObjectId)];
+	while (*Link != E)
+		Link = &(*Link)->HashNext;
+	*Link = E->HashNext;
+	UnlinkLRU(E);
+	TextureCacheSize -= E->Size;
+	appFree(E->Data);
+	delete E;
+}
+
+static CTextureCacheEntry* FindEntry(const CTextureCacheKey& Key)
+{
+	for (CTextureCacheEntry* E = TextureCacheHash[GetTextureCacheHash(Key.ObjectId)]; E; E = E->HashNext)
+	{
+		if (E->Key == Key)
+			return E;
+	}
+	return NULL;
+}
+
+// Drop least recently used images until there's enough space for 'Size' bytes
+static void TrimTextureCache(int64 Size)
+{
+	while (TextureCacheTail && TextureCacheSize + Size > TextureCacheLimit)
+		RemoveEntry(TextureCacheTail);
+}
+
+int32 AllocateTextureCacheId()
+{
+	return InterlockedIncrement(&LastTextureCacheId);
+}
+
+void SetTextureCacheSize(int SizeMB)
+{
+	guard(SetTextureCacheSize);
+#if THREADING
+	CMutex::ScopedLock Lock(TextureCacheMutex);
+#endif
+	TextureCacheLimit = (int64)max(SizeMB, 0) << 20;
+	TrimTextureCache(0);
+	unguard;
+}
+
+bool FindCachedTexture(const CTextureCacheKey& Key, byte* Dst, int Size)
+{
+	guard(FindCachedTexture);
+
+	if (!TextureCacheLimit) return false;
+
+#if THREADING
+	CMutex::ScopedLock Lock(TextureCacheMutex);
+#endif
+	CTextureCacheEntry* E = FindEntry(Key);
+	if (!E || E->Size != Size)
+	{
+#if PROFILE
+		GTextureCacheMisses++;
+#endif
+		return false;
+	}
+	// Move to the LRU list head
+	UnlinkLRU(E);
+	LinkLRU(E);
+	// Copy under the lock, so the entry can't be dropped by another thread meanwhile
+	memcpy(Dst, E->Data, Size);
+#if PROFILE
+	GTextureCacheHits++;
+#endif
+	return true;
+
+	unguard;
+}
+
+void AddCachedTexture(const CTextureCacheKey& Key, const byte* Data, int Size)
+{
+	guard(AddCachedTexture);
+
+	// Don't let a single large image to flush everything from the cache
+	if (Size <= 0 || Size > TextureCacheLimit / 4) return;
+
+	// Copy data before locking the cache
+	byte* Copy = (byte*)appMallocNoInit(Size);
+	memcpy(Copy, Data, Size);
+
+#if THREADING
+	CMutex::ScopedLock Lock(TextureCacheMutex);
+#endif
+	if (CTextureCacheEntry* Old = FindEntry(Key))
+	{
+		// Another thread has decoded the same image
+		RemoveEntry(Old);
+	}
+	TrimTextureCache(Size);
+
+	CTextureCacheEntry* E = new CTextureCacheEntry;
+	E->Key = Key;
+	E->Data = Copy;
+	E->Size = Size;
+	int h = GetTextureCacheHash(Key.ObjectId);
+	E->HashNext = TextureCacheHash[h];
+	TextureCacheHash[h] = E;
+	LinkLRU(E);
+	TextureCacheSize += Size;
+
+	unguard;
+}
+
+void ReleaseCachedTextures(int32 ObjectId)
+{
+	guard(ReleaseCachedTextures);
+#if THREADING
+	CMutex::ScopedLock Lock(TextureCacheMutex);
+#endif
+	CTextureCacheEntry* Next;
+	for (CTextureCacheEntry* E = TextureCacheHash[GetTextureCacheHash(ObjectId)]; E; E = Next)
+	{
+		Next = E->HashNext;
+		if (E->Key.ObjectId == ObjectId)
+			RemoveEntry(E);
+	}
+	unguard;
+}
+
+
+UUnrealMaterial::~UUnrealMaterial()
+{
+	if (TextureCacheId)
+		ReleaseCachedTextures(TextureCacheId);
+}
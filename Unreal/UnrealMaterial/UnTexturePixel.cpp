@@ -0,0 +1,291 @@
+#include "Core.h"
+#include "UnCore.h"
+#include "UnObject.h"
+#include "UnMaterial.h"
+#include "UnTexturePixel.h"
+#include "MathSSE2.h"
+
+#include <math.h>
+
+/*-----------------------------------------------------------------------------
+	Uncompressed pixel format conversion
+
+	Converters produce exactly the same result as the per-channel loops which
+	were used by CTextureData::Decompress() before, including half2float()
+	behavior for denormals and infinities. Destination is RGBA8 (or RGBA32F
+	for float formats), pixels are processed as uint32 values with R in the
+	lowest byte. All functions have the same signature as block decoders in
+	UnTextureBCn.cpp, so they could be decoded in parallel stripes.
+-----------------------------------------------------------------------------*/
+
+#define RGBA32(r,g,b,a)			( (r) | ((g) << 8) | ((b) << 16) | ((a) << 24) )
+
+// Converts half to float bits: the same as half2float(), but without branches
+static FORCEINLINE uint32 HalfToFloatBits(uint32 h)
+{
+	return ((h & 0x8000) << 16) | (((h & 0x7FFF) << 13) + (112 << 23));
+}
+
+void DecodeFloatRGBA(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	const uint16* s = (const uint16*)Data;
+	uint32* d = (uint32*)Dst;
+	int Count = USize * VSize * 4;				// number of channels
+	int i = 0;
+
+#if USE_SSE2
+	const __m128i SignMask = _mm_set1_epi32(0x8000);
+	const __m128i ValueMask = _mm_set1_epi32(0x7FFF);
+	const __m128i ExpBias = _mm_set1_epi32(112 << 23);
+	const __m128i Zero = _mm_setzero_si128();
+	for ( ; i + 8 <= Count; i += 8)
+	{
+		__m128i h = _mm_loadu_si128((const __m128i*)(s + i));
+		__m128i h0 = _mm_unpacklo_epi16(h, Zero);
+		__m128i h1 = _mm_unpackhi_epi16(h, Zero);
+		h0 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(h0, SignMask), 16), _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(h0, ValueMask), 13), ExpBias));
+		h1 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(h1, SignMask), 16), _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(h1, ValueMask), 13), ExpBias));
+		_mm_storeu_si128((__m128i*)(d + i), h0);
+		_mm_storeu_si128((__m128i*)(d + i + 4), h1);
+	}
+#endif // USE_SSE2
+
+	for ( ; i < Count; i++)
+		d[i] = HalfToFloatBits(s[i]);
+}
+
+void DecodeBGRA8(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	const uint32* s = (const uint32*)Data;
+	uint32* d = (uint32*)Dst;
+	int Count = USize * VSize;
+	int i = 0;
+
+#if USE_SSE2
+	const __m128i MaskAG = _mm_set1_epi32(0xFF00FF00);
+	const __m128i MaskB = _mm_set1_epi32(0x000000FF);
+	for ( ; i + 4 <= Count; i += 4)
+	{
+		__m128i p = _mm_loadu_si128((const __m128i*)(s + i));
+		__m128i r = _mm_or_si128(_mm_and_si128(p, MaskAG),
+			_mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), MaskB), _mm_slli_epi32(_mm_and_si128(p, MaskB), 16)));
+		_mm_storeu_si128((__m128i*)(d + i), r);
+	}
+#endif // USE_SSE2
+
+	for ( ; i < Count; i++)
+	{
+		uint32 p = s[i];
+		d[i] = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+	}
+}
+
+void DecodeRGB8(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	// Source data has BGR byte order
+	const byte* s = Data;
+	uint32* d = (uint32*)Dst;
+	int Count = USize * VSize;
+	for (int i = 0; i < Count; i++, s += 3)
+		d[i] = RGBA32(s[2], s[1], s[0], 255u);
+}
+
+void DecodeG8(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	uint32* d = (uint32*)Dst;
+	int Count = USize * VSize;
+	int i = 0;
+
+#if USE_SSE2
+	const __m128i Alpha = _mm_set1_epi8((char)0xFF);
+	for ( ; i + 16 <= Count; i += 16)
+	{
+		__m128i g = _mm_loadu_si128((const __m128i*)(Data + i));
+		__m128i gg0 = _mm_unpacklo_epi8(g, g);			// G G
+		__m128i gg1 = _mm_unpackhi_epi8(g, g);
+		__m128i ga0 = _mm_unpacklo_epi8(g, Alpha);		// G A
+		__m128i ga1 = _mm_unpackhi_epi8(g, Alpha);
+		_mm_storeu_si128((__m128i*)(d + i),      _mm_unpacklo_epi16(gg0, ga0));
+		_mm_storeu_si128((__m128i*)(d + i + 4),  _mm_unpackhi_epi16(gg0, ga0));
+		_mm_storeu_si128((__m128i*)(d + i + 8),  _mm_unpacklo_epi16(gg1, ga1));
+		_mm_storeu_si128((__m128i*)(d + i + 12), _mm_unpackhi_epi16(gg1, ga1));
+	}
+#endif // USE_SSE2
+
+	for ( ; i < Count; i++)
+	{
+		uint32 g = Data[i];
+		d[i] = g * 0x010101 | 0xFF000000;
+	}
+}
+
+// Each byte of RGBA4 pixel holds 2 channels, so the whole pixel is combined from 2 table lookups
+static uint16 RGBA4Table[256];
+
+static bool BuildRGBA4Table()
+{
+	for (int b = 0; b < 256; b++)
+		RGBA4Table[b] = (b & 0xF0) | ((b & 0x0F) << 12);
+	return true;
+}
+
+void DecodeRGBA4(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	static bool Initialized = BuildRGBA4Table();		// thread-safe initialization
+	(void)Initialized;
+
+	const byte* s = Data;
+	uint32* d = (uint32*)Dst;
+	int Count = USize * VSize;
+	for (int i = 0; i < Count; i++, s += 2)
+	{
+		// BGRA -> RGBA
+		d[i] = RGBA4Table[s[1]] | (RGBA4Table[s[0]] << 16);
+	}
+}
+
+// Lookup tables with reconstructed blue channel for V8U8 formats, indexed with both source bytes.
+// The first table is for TPF_V8U8 (signed values), the second one is for TPF_V8U8_2.
+static byte V8U8Table[2][256 * 256];
+
+static bool BuildV8U8Table()
+{
+	for (int Index = 0; Index < 2; Index++)
+	{
+		byte offset = (Index == 0) ? 128 : 0;
+		for (int i = 0; i < 256 * 256; i++)
+		{
+			// Exactly the same computations as old Decompress() code did
+			byte u = (i & 0xFF) + offset;
+			byte v = (i >> 8) + offset;
+			float uf = (u - offset) / 255.0f * 2 - 1;
+			float vf = (v - offset) / 255.0f * 2 - 1;
+			float t  = 1.0f - uf * uf - vf * vf;
+			if (t >= 0)
+				V8U8Table[Index][i] = 255 - 255 * appFloor(sqrt(t));	//!! TODO: check for correct function here - should be (t+1.0)*127.5, at least for 'offset==0'
+			else
+				V8U8Table[Index][i] = 255;
+		}
+	}
+	return true;
+}
+
+template<int Offset>
+static void DecodeV8U8Image(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	static bool Initialized = BuildV8U8Table();		// thread-safe initialization
+	(void)Initialized;
+
+	const byte* Table = V8U8Table[Offset ? 0 : 1];
+	const uint16* s = (const uint16*)Data;
+	uint32* d = (uint32*)Dst;
+	int Count = USize * VSize;
+	for (int i = 0; i < Count; i++)
+	{
+		uint32 uv = s[i];
+		d[i] = (uv ^ (Offset * 0x0101)) | (Table[uv] << 16) | 0xFF000000;	// adding 128 to a byte is the same as flipping its high bit
+	}
+}
+
+void DecodeV8U8(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeV8U8Image<128>(Data, Dst, USize, VSize);
+}
+
+void DecodeV8U8_2(const byte* Data, byte* Dst, int USize, int VSize)
+{
+	DecodeV8U8Image<0>(Data, Dst, USize, VSize);
+}
+
+void DecodeP8(const byte* Data, byte* Dst, int NumPixels, const uint32* Palette)
+{
+	uint32* d = (uint32*)Dst;
+	int i = 0;
+	// Unrolled to let the CPU overlap palette loads
+	for ( ; i + 4 <= NumPixels; i += 4)
+	{
+		uint32 c0 = Palette[Data[i]];
+		uint32 c1 = Palette[Data[i+1]];
+		uint32 c2 = Palette[Data[i+2]];
+		uint32 c3 = Palette[Data[i+3]];
+		d[i] = c0; d[i+1] = c1; d[i+2] = c2; d[i+3] = c3;
+	}
+	for ( ; i < NumPixels; i++)
+		d[i] = Palette[Data[i]];
+}
+
+/*-----------------------------------------------------------------------------
+	RGBE conversion (Radiance HDR)
+-----------------------------------------------------------------------------*/
+
+// Float value 1e-32f is rounded up, so comparison with it gives the same result as with double 1e-32
+#define RGBE_MIN_VALUE			1e-32f
+
+static FORCEINLINE void FloatToRGBE(const float* s, byte* rgbe)
+{
+	float v = s[0];
+	if (s[1] > v) v = s[1];
+	if (s[2] > v) v = s[2];
+	if (v < RGBE_MIN_VALUE)
+	{
+		rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+	}
+	else
+	{
+		// frexp(v) * 256 / v is exactly 2^(8-e), and with v = m * 2^e (0.5 <= m < 1) the exponent
+		// is e = E - 126, where E is biased exponent of v; so build the scale value from bits directly
+		union { float f; uint32 i; } bits, scale;
+		bits.f = v;
+		int E = (bits.i >> 23) & 0xFF;
+		scale.i = (261 - E) << 23;
+		rgbe[0] = byte(int(s[0] * scale.f));
+		rgbe[1] = byte(int(s[1] * scale.f));
+		rgbe[2] = byte(int(s[2] * scale.f));
+		rgbe[3] = byte(E + 2);
+	}
+}
+
+void ConvertFloatToRGBE(const float* Src, byte* Dst, int NumPixels)
+{
+	int i = 0;
+
+#if USE_SSE2
+	const __m128 MinValue = _mm_set1_ps(RGBE_MIN_VALUE);
+	const __m128i ExpMask = _mm_set1_epi32(0xFF);
+	const __m128i Exp261 = _mm_set1_epi32(261);
+	const __m128i Exp2 = _mm_set1_epi32(2);
+	for ( ; i + 4 <= NumPixels; i += 4)
+	{
+		// Load 4 pixels and transpose them to R, G, B vectors
+		__m128 p0 = _mm_loadu_ps(Src + i * 4);
+		__m128 p1 = _mm_loadu_ps(Src + i * 4 + 4);
+		__m128 p2 = _mm_loadu_ps(Src + i * 4 + 8);
+		__m128 p3 = _mm_loadu_ps(Src + i * 4 + 12);
+		__m128 A = _mm_unpacklo_ps(p0, p1);				// r0 r1 g0 g1
+		__m128 B = _mm_unpacklo_ps(p2, p3);				// r2 r3 g2 g3
+		__m128 C = _mm_unpackhi_ps(p0, p1);				// b0 b1 a0 a1
+		__m128 D = _mm_unpackhi_ps(p2, p3);				// b2 b3 a2 a3
+		__m128 R = _mm_movelh_ps(A, B);
+		__m128 G = _mm_movehl_ps(B, A);
+		__m128 Bl = _mm_movelh_ps(C, D);
+
+		// The same order of comparisons as in scalar code (matters only for NaNs)
+		__m128 V = R;
+		V = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(G, V), G), _mm_andnot_ps(_mm_cmpgt_ps(G, V), V));
+		V = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(Bl, V), Bl), _mm_andnot_ps(_mm_cmpgt_ps(Bl, V), V));
+		__m128i NonZero = _mm_castps_si128(_mm_cmpnlt_ps(V, MinValue));
+
+		__m128i E = _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(V), 23), ExpMask);
+		__m128 Scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(Exp261, E), 23));
+		__m128i r = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(R, Scale)), ExpMask);
+		__m128i g = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(G, Scale)), ExpMask);
+		__m128i b = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(Bl, Scale)), ExpMask);
+		__m128i e = _mm_and_si128(_mm_add_epi32(E, Exp2), ExpMask);
+		__m128i rgbe = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(e, 24)));
+		_mm_storeu_si128((__m128i*)(Dst + i * 4), _mm_and_si128(rgbe, NonZero));
+	}
+#endif // USE_SSE2
+
+	for ( ; i < NumPixels; i++)
+		FloatToRGBE(Src + i * 4, Dst + i * 4);
+}
@@ -0,0 +1,16 @@
+#ifndef __UNTEXTUREPIXEL_H__
+#define __UNTEXTUREPIXEL_H__
+
+// Uncompressed format converters, implemented in UnTexturePixel.cpp. Dst receives RGBA8 image of USize x VSize
+// pixels, DecodeFloatRGBA() produces float[USize * VSize * 4] image instead.
+void DecodeRGB8(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeBGRA8(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeRGBA4(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeG8(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeV8U8(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeV8U8_2(const byte* Data, byte* Dst, int USize, int VSize);
+void DecodeFloatRGBA(const byte* Data, byte* Dst, int USize, int VSize);
+// Convert NumPixels 8-bit palette indices to RGBA8 with a palette of 256 RGBA8 colors
+void DecodeP8(const byte* Data, byte* Dst, int NumPixels, const uint32* Palette);
+
+#endif // __UNTEXTUREPIXEL_H__
@@ -305,79 +305,157 @@ void USkeleton::PostLoad()
 #define DBG(...)
 #endif
 
-// position
-#define TP(Enum, VecType)						\
-				case Enum:						\
-					{							\
-						VecType v;				\
-						Reader << v;			\
-						A->KeyPos.Add(CVT(v));	\
-					}							\
-					break;
-// position ranged
-#define TPR(Enum, VecType)						\
-				case Enum:						\
-					{							\
-						VecType v;				\
-						Reader << v;			\
-						FVector v2 = v.ToVector(Mins, Ranges); \
-						A->KeyPos.Add(CVT(v2));	\
-					}							\
-					break;
-// rotation
-#define TR(Enum, QuatType)						\
-				case Enum:						\
-					{							\
-						QuatType q;				\
-						Reader << q;			\
-						A->KeyQuat.Add(CVT(q));	\
-					}							\
-					break;
-// rotation ranged
-#define TRR(Enum, QuatType)						\
-				case Enum:						\
-					{							\
-						QuatType q;				\
-						Reader << q;			\
-						FQuat q2 = q.ToQuat(Mins, Ranges); \
-						A->KeyQuat.Add(CVT(q2));\
-					}							\
-					break;
-
-static void ReadTimeArray(FArchive &Ar, int NumKeys, TArray<float> &Times, int NumFrames)
+// Get pointer to Size bytes of key data at the current Reader position, and skip these bytes. Keys are
+// decoded directly from the compressed stream, data is copied only when byte swapping is required.
+static const byte* GetKeyData(FMemReader& Reader, const TArray<uint8>& Stream, int Size, int ItemSize, TArray<byte>& SwapBuffer)
+{
+	int Pos = Reader.Tell();
+	if (Pos + Size > Stream.Num())
+		appError("Serializing behind end of buffer");
+	Reader.Seek(Pos + Size);
+	const byte* Data = Stream.GetData() + Pos;
+	if (!Reader.ReverseBytes || ItemSize == 1)
+		return Data;
+	SwapBuffer.Empty(Size);
+	SwapBuffer.AddUninitialized(Size);
+	memcpy(SwapBuffer.GetData(), Data, Size);
+	appReverseBytes(SwapBuffer.GetData(), Size / ItemSize, ItemSize);
+	return SwapBuffer.GetData();
+}
+
+static FORCEINLINE int CountKeyComponents(int ComponentMask)
+{
+	return (ComponentMask & 1) + ((ComponentMask >> 1) & 1) + ((ComponentMask >> 2) & 1);
+}
+
+// Decode NumKeys translation keys with batch decoders. bPerTrack selects AKF_PerTrackCompression
+// data layout, ComponentMask is used only for it.
+static void ReadTranslationKeys(FMemReader& Reader, const TArray<uint8>& Stream, AnimationCompressionFormat KeyFormat,
+	int ComponentMask, bool bPerTrack, int NumKeys, const FVector& Mins, const FVector& Ranges, TArray<CVec3>& Dst)
+{
+	guard(ReadTranslationKeys);
+
+	Dst.Reset(NumKeys);
+	if (!NumKeys) return;
+	Dst.AddUninitialized(NumKeys);
+	CVec3* D = Dst.GetData();
+
+	if (!bPerTrack) ComponentMask = 7;
+	TArray<byte> SwapBuffer;
+
+	switch (KeyFormat)
+	{
+	case ACF_None:
+	case ACF_Float96NoW:
+		{
+			// ACF_Float96NoW has a special case for ((ComponentMask & 7) == 0): all components are stored
+			int NumComponents = (ComponentMask & 7) ? CountKeyComponents(ComponentMask) : 3;
+			const byte* Data = GetKeyData(Reader, Stream, NumKeys * NumComponents * sizeof(float), sizeof(float), SwapBuffer);
+			DecodeVectorFloat96Keys(Data, NumKeys, ComponentMask, D);
+		}
+		break;
+	case ACF_IntervalFixed32NoW:
+		DecodeVectorIntervalFixed32Keys(GetKeyData(Reader, Stream, NumKeys * 4, 4, SwapBuffer), NumKeys, Mins, Ranges, D);
+		break;
+	case ACF_Fixed48NoW:
+		if (bPerTrack)
+		{
+			const byte* Data = GetKeyData(Reader, Stream, NumKeys * CountKeyComponents(ComponentMask) * 2, 2, SwapBuffer);
+			DecodeVectorFixed48PerTrackKeys(Data, NumKeys, ComponentMask, D);
+		}
+		else
+		{
+			DecodeVectorFixed48Keys(GetKeyData(Reader, Stream, NumKeys * 6, 2, SwapBuffer), NumKeys, D);
+		}
+		break;
+	case ACF_Identity:
+		memset(D, 0, NumKeys * sizeof(CVec3));
+		break;
+	default:
+		appError("Unknown translation compression method: %d (%s)", KeyFormat, EnumToName(KeyFormat));
+	}
+
+	unguard;
+}
+
+// Decode NumKeys rotation keys, see ReadTranslationKeys() for details
+static void ReadRotationKeys(FMemReader& Reader, const TArray<uint8>& Stream, AnimationCompressionFormat KeyFormat,
+	int ComponentMask, bool bPerTrack, int NumKeys, const FVector& Mins, const FVector& Ranges, TArray<CQuat>& Dst)
+{
+	guard(ReadRotationKeys);
+
+	Dst.Reset(NumKeys);
+	if (!NumKeys) return;
+	Dst.AddUninitialized(NumKeys);
+	CQuat* D = Dst.GetData();
+
+	if (!bPerTrack) ComponentMask = 7;
+	TArray<byte> SwapBuffer;
+
+	switch (KeyFormat)
+	{
+	case ACF_None:
+		if (!bPerTrack)
+		{
+			// uncompressed quaternions
+			memcpy(D, GetKeyData(Reader, Stream, NumKeys * sizeof(CQuat), sizeof(float), SwapBuffer), NumKeys * sizeof(CQuat));
+			break;
+		}
+		// per-track compression uses ACF_Float96NoW for ACF_None
+	case ACF_Float96NoW:
+		DecodeQuatFloat96NoWKeys(GetKeyData(Reader, Stream, NumKeys * 12, sizeof(float), SwapBuffer), NumKeys, D);
+		break;
+	case ACF_Fixed48NoW:
+		{
+			const byte* Data = GetKeyData(Reader, Stream, NumKeys * CountKeyComponents(ComponentMask) * 2, 2, SwapBuffer);
+			DecodeQuatFixed48NoWKeys(Data, NumKeys, ComponentMask, D);
+		}
+		break;
+	case ACF_Fixed32NoW:
+		DecodeQuatFixed32NoWKeys(GetKeyData(Reader, Stream, NumKeys * 4, 4, SwapBuffer), NumKeys, D);
+		break;
+	case ACF_IntervalFixed32NoW:
+		DecodeQuatIntervalFixed32NoWKeys(GetKeyData(Reader, Stream, NumKeys * 4, 4, SwapBuffer), NumKeys, Mins, Ranges, D);
+		break;
+	case ACF_Float32NoW:
+		DecodeQuatFloat32NoWKeys(GetKeyData(Reader, Stream, NumKeys * 4, 4, SwapBuffer), NumKeys, D);
+		break;
+	case ACF_Identity:
+		for (int k = 0; k < NumKeys; k++)
+			D[k].Set(0, 0, 0, 1);
+		break;
+	default:
+		appError("Unknown rotation compression method: %d (%s)", KeyFormat, EnumToName(KeyFormat));
+	}
+
+	unguard;
+}
+
+static void ReadTimeArray(FMemReader &Reader, const TArray<uint8>& Stream, int NumKeys, TArray<float> &Times, int NumFrames)
 {
 	guard(ReadTimeArray);
 
-	Times.Empty(NumKeys);
+	Times.Reset(NumKeys);
 	if (NumKeys <= 1) return;
 
-//	appPrintf("  pos=%4X keys (max=%X)[ ", Ar.Tell(), NumFrames);
+	Times.AddUninitialized(NumKeys);
+	float* Dst = Times.GetData();
+	TArray<byte> SwapBuffer;
 	if (NumFrames < 256)
 	{
+		const uint8* Data = GetKeyData(Reader, Stream, NumKeys, 1, SwapBuffer);
 		for (int k = 0; k < NumKeys; k++)
-		{
-			uint8 v;
-			Ar << v;
-			Times.Add(v);
-//			if (k < 4 || k > NumKeys - 5) appPrintf(" %02X ", v);
-//			else if (k == 4) appPrintf("...");
-		}
+			Dst[k] = Data[k];
 	}
 	else
 	{
+		const uint16* Data = (const uint16*)GetKeyData(Reader, Stream, NumKeys * 2, 2, SwapBuffer);
 		for (int k = 0; k < NumKeys; k++)
-		{
-			uint16 v;
-			Ar << v;
-			Times.Add(v);
-//			if (k < 4 || k > NumKeys - 5) appPrintf(" %04X ", v);
-//			else if (k == 4) appPrintf("...");
-		}
+			Dst[k] = Data[k];
 	}
-//	appPrintf(" ]\n");
 
 	// align to 4 bytes
-	Ar.Seek(Align(Ar.Tell(), 4));
+	Reader.Seek(Align(Reader.Tell(), 4));
 
 	unguard;
 }
@@ -416,6 +494,12 @@ void AdjustSequenceBySkeleton(USkeleton* Skel, CAnimSequence* Anim)
 	unguard;
 }
 
+static void DecodeSequenceTracks(CAnimSequence* Dst)
+{
+	USkeleton* Skel = static_cast<USkeleton*>(Dst->OriginalAnim);
+	Skel->DecodeAnimTracks(static_cast<UAnimSequence4*>(Dst->OriginalSequence), Dst);
+}
+
 void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 {
 	guard(USkeleton::ConvertAnims);
@@ -518,6 +602,21 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 	Dst->Rate      = Seq->NumFrames / Seq->SequenceLength * Seq->RateScale;
 	Dst->bAdditive = Seq->AdditiveAnimType != AAT_None;
 
+	// bone tracks are decoded on demand
+	Dst->OriginalAnim = this;
+	Dst->OriginalSequence = Seq;
+	Dst->DecodeTracks = DecodeSequenceTracks;
+
+	unguardf("Skel=%s Anim=%s", Name, Seq->Name);
+}
+
+void USkeleton::DecodeAnimTracks(UAnimSequence4* Seq, CAnimSequence* Dst)
+{
+	guard(USkeleton::DecodeAnimTracks);
+
+	int NumTracks = Seq->GetNumTracks();
+	int offsetsPerBone = (Seq->KeyEncodingFormat == AKF_PerTrackCompression) ? 2 : 4;
+
 	// bone tracks ...
 	Dst->Tracks.Empty(NumTracks);
 
@@ -528,8 +627,7 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 
 	for (int BoneIndex = 0; BoneIndex < ReferenceSkeleton.RefBoneInfo.Num(); BoneIndex++)
 	{
-		CAnimTrack *A = new CAnimTrack;
-		Dst->Tracks.Add(A);
+		CAnimTrack *A = Dst->AddTrack();
 
 		int TrackIndex = Seq->FindTrackForBoneIndex(BoneIndex);
 
@@ -543,15 +641,13 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 			continue;
 		}
 
-		int k;
-
 		if (!Seq->CompressedTrackOffsets.Num())	//?? or if RawAnimData.Num() != 0
 		{
 			// using RawAnimData array
 			assert(Seq->RawAnimationData.Num() == NumTracks);
-			CopyArray(A->KeyPos,  CVT(Seq->RawAnimationData[TrackIndex].PosKeys));
-			CopyArray(A->KeyQuat, CVT(Seq->RawAnimationData[TrackIndex].RotKeys));
-			CopyArray(A->KeyTime, Seq->RawAnimationData[TrackIndex].KeyTimes);	// may be empty
+			CopyTrackKeys(A->KeyPos,  CVT(Seq->RawAnimationData[TrackIndex].PosKeys));
+			CopyTrackKeys(A->KeyQuat, CVT(Seq->RawAnimationData[TrackIndex].RotKeys));
+			CopyTrackKeys(A->KeyTime, Seq->RawAnimationData[TrackIndex].KeyTimes);	// may be empty
 			for (int k = 0; k < A->KeyTime.Num(); k++)
 				A->KeyTime[k] *= Dst->Rate;
 			continue;
@@ -606,7 +702,6 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 				Reader.Seek(TransOffset);
 				Reader << PackedInfo;
 				DECODE_PER_TRACK_INFO(PackedInfo);
-				A->KeyPos.Empty(NumKeys);
 				DBG("    [%d] trans: fmt=%d (%s), %d keys, mask %d\n", TrackIndex,
 					KeyFormat, EnumToName(KeyFormat), NumKeys, ComponentMask
 				);
@@ -619,61 +714,11 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 					if (ComponentMask & 2) Reader << Mins.Y << Ranges.Y;
 					if (ComponentMask & 4) Reader << Mins.Z << Ranges.Z;
 				}
-				for (k = 0; k < NumKeys; k++)
-				{
-					switch (KeyFormat)
-					{
-					case ACF_None:
-					case ACF_Float96NoW:
-						{
-							FVector v;
-							if (ComponentMask & 7)
-							{
-								v.Set(0, 0, 0);
-								if (ComponentMask & 1) Reader << v.X;
-								if (ComponentMask & 2) Reader << v.Y;
-								if (ComponentMask & 4) Reader << v.Z;
-							}
-							else
-							{
-								// ACF_Float96NoW has a special case for ((ComponentMask & 7) == 0)
-								Reader << v;
-							}
-							A->KeyPos.Add(CVT(v));
-						}
-						break;
-					TPR(ACF_IntervalFixed32NoW, FVectorIntervalFixed32)
-					case ACF_Fixed48NoW:
-						{
-							uint16 X, Y, Z;
-							CVec3 v;
-							v.Set(0, 0, 0);
-							if (ComponentMask & 1)
-							{
-								Reader << X; v[0] = DecodeFixed48_PerTrackComponent<7>(X);
-							}
-							if (ComponentMask & 2)
-							{
-								Reader << Y; v[1] = DecodeFixed48_PerTrackComponent<7>(Y);
-							}
-							if (ComponentMask & 4)
-							{
-								Reader << Z; v[2] = DecodeFixed48_PerTrackComponent<7>(Z);
-							}
-							A->KeyPos.Add(v);
-						}
-						break;
-					case ACF_Identity:
-						A->KeyPos.Add(nullVec);
-						break;
-					default:
-						appError("Unknown translation compression method: %d (%s)", KeyFormat, EnumToName(KeyFormat));
-					}
-				}
+				ReadTranslationKeys(Reader, Seq->CompressedByteStream, KeyFormat, ComponentMask, true, NumKeys, Mins, Ranges, A->KeyPos);
 				// align to 4 bytes
 				Reader.Seek(Align(Reader.Tell(), 4));
 				if (HasTimeTracks)
-					ReadTimeArray(Reader, NumKeys, A->KeyPosTime, Seq->NumFrames);
+					ReadTimeArray(Reader, Seq->CompressedByteStream, NumKeys, A->KeyPosTime, Seq->NumFrames);
 			}
 			unguard;
 
@@ -689,7 +734,6 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 				Reader.Seek(RotOffset);
 				Reader << PackedInfo;
 				DECODE_PER_TRACK_INFO(PackedInfo);
-				A->KeyQuat.Empty(NumKeys);
 				DBG("    [%d] rot  : fmt=%d (%s), %d keys, mask %d\n", TrackIndex,
 					KeyFormat, EnumToName(KeyFormat), NumKeys, ComponentMask
 				);
@@ -702,44 +746,11 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 					if (ComponentMask & 2) Reader << Mins.Y << Ranges.Y;
 					if (ComponentMask & 4) Reader << Mins.Z << Ranges.Z;
 				}
-				for (k = 0; k < NumKeys; k++)
-				{
-					switch (KeyFormat)
-					{
-					case ACF_None:
-					case ACF_Float96NoW:
-						{
-							FQuatFloat96NoW q;
-							Reader << q;
-							FQuat q2 = q;				// convert
-							A->KeyQuat.Add(CVT(q2));
-						}
-						break;
-					case ACF_Fixed48NoW:
-						{
-							FQuatFixed48NoW q;
-							q.X = q.Y = q.Z = 32767;	// corresponds to 0
-							if (ComponentMask & 1) Reader << q.X;
-							if (ComponentMask & 2) Reader << q.Y;
-							if (ComponentMask & 4) Reader << q.Z;
-							FQuat q2 = q;				// convert
-							A->KeyQuat.Add(CVT(q2));
-						}
-						break;
-					TR (ACF_Fixed32NoW, FQuatFixed32NoW)
-					TRR(ACF_IntervalFixed32NoW, FQuatIntervalFixed32NoW)
-					TR (ACF_Float32NoW, FQuatFloat32NoW)
-					case ACF_Identity:
-						A->KeyQuat.Add(nullQuat);
-						break;
-					default:
-						appError("Unknown rotation compression method: %d (%s)", KeyFormat, EnumToName(KeyFormat));
-					}
-				}
+				ReadRotationKeys(Reader, Seq->CompressedByteStream, KeyFormat, ComponentMask, true, NumKeys, Mins, Ranges, A->KeyQuat);
 				// align to 4 bytes
 				Reader.Seek(Align(Reader.Tell(), 4));
 				if (HasTimeTracks)
-					ReadTimeArray(Reader, NumKeys, A->KeyQuatTime, Seq->NumFrames);
+					ReadTimeArray(Reader, Seq->CompressedByteStream, NumKeys, A->KeyQuatTime, Seq->NumFrames);
 			}
 			unguard;
 
@@ -760,8 +771,8 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 		int RotKeys     = Seq->CompressedTrackOffsets[offsetIndex+3];
 //		appPrintf("[%d:%d:%d] :  %d[%d]  %d[%d]  %d[%d]\n", j, Seq->RotationCompressionFormat, Seq->TranslationCompressionFormat, TransOffset, TransKeys, RotOffset, RotKeys, ScaleOffset, ScaleKeys);
 
-		A->KeyPos.Empty(TransKeys);
-		A->KeyQuat.Empty(RotKeys);
+		A->KeyPos.Reset(TransKeys);
+		A->KeyQuat.Reset(RotKeys);
 
 		// read translation keys
 		if (TransKeys)
@@ -776,26 +787,11 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 				Reader << Mins << Ranges;
 			}
 
-			for (k = 0; k < TransKeys; k++)
-			{
-				switch (TranslationCompressionFormat)
-				{
-				TP (ACF_None,               FVector)
-				TP (ACF_Float96NoW,         FVector)
-				TPR(ACF_IntervalFixed32NoW, FVectorIntervalFixed32)
-				TP (ACF_Fixed48NoW,         FVectorFixed48)
-				case ACF_Identity:
-					A->KeyPos.Add(nullVec);
-					break;
-				default:
-					appError("Unknown translation compression method: %d (%s)", TranslationCompressionFormat, EnumToName(TranslationCompressionFormat));
-				}
-			}
-
+			ReadTranslationKeys(Reader, Seq->CompressedByteStream, TranslationCompressionFormat, 7, false, TransKeys, Mins, Ranges, A->KeyPos);
 			// align to 4 bytes
 			Reader.Seek(Align(Reader.Tell(), 4));
 			if (HasTimeTracks)
-				ReadTimeArray(Reader, TransKeys, A->KeyPosTime, Seq->NumFrames);
+				ReadTimeArray(Reader, Seq->CompressedByteStream, TransKeys, A->KeyPosTime, Seq->NumFrames);
 		}
 		else
 		{
@@ -820,29 +816,13 @@ void USkeleton::ConvertAnims(UAnimSequence4* Seq)
 			Reader << Mins << Ranges;
 		}
 
-		for (k = 0; k < RotKeys; k++)
-		{
-			switch (RotationCompressionFormat)
-			{
-			TR (ACF_None, FQuat)
-			TR (ACF_Float96NoW, FQuatFloat96NoW)
-			TR (ACF_Fixed48NoW, FQuatFixed48NoW)
-			TR (ACF_Fixed32NoW, FQuatFixed32NoW)
-			TRR(ACF_IntervalFixed32NoW, FQuatIntervalFixed32NoW)
-			TR (ACF_Float32NoW, FQuatFloat32NoW)
-			case ACF_Identity:
-				A->KeyQuat.Add(nullQuat);
-				break;
-			default:
-				appError("Unknown rotation compression method: %d (%s)", RotationCompressionFormat, EnumToName(RotationCompressionFormat));
-			}
-		}
+		ReadRotationKeys(Reader, Seq->CompressedByteStream, RotationCompressionFormat, 7, false, RotKeys, Mins, Ranges, A->KeyQuat);
 
 		if (HasTimeTracks)
 		{
 			// align to 4 bytes
 			Reader.Seek(Align(Reader.Tell(), 4));
-			ReadTimeArray(Reader, RotKeys, A->KeyQuatTime, Seq->NumFrames);
+			ReadTimeArray(Reader, Seq->CompressedByteStream, RotKeys, A->KeyQuatTime, Seq->NumFrames);
 		}
 
 #if DEBUG_DECOMPRESS
@@ -1372,10 +1352,17 @@ void UAnimSequence4::PostLoad()
 	if (!Skeleton) return;		// missing package etc
 	Skeleton->ConvertAnims(this);
 
-	// Release original animation data to save memory
-	RawAnimationData.Empty();
-	CompressedByteStream.Empty();
-	CompressedTrackOffsets.Empty();
+	// CAnimSequence decodes its tracks from original animation data on demand. Keep only the data which
+	// DecodeAnimTracks() will use: compressed data when present, raw data otherwise.
+	if (CompressedTrackOffsets.Num())
+	{
+		RawAnimationData.Empty();
+	}
+	else
+	{
+		CompressedByteStream.Empty();
+		CompressedTrackOffsets.Empty();
+	}
 
 	unguard;
 }
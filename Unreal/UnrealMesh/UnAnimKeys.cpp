@@ -0,0 +1,334 @@
+#include "Core.h"
+#include "UnCore.h"
+#include "UnMesh.h"
+#include "UnMeshTypes.h"
+#include "TypeConvert.h"
+#include "MathSSE2.h"
+
+/*-----------------------------------------------------------------------------
+	Batch decoders of compressed animation keys
+
+	Decoders produce exactly the same values as conversion operators of the
+	compressed key types from UnMeshTypes.h, which were used for decoding of
+	each key separately. SSE2 code processes 4 keys at a time as separate X,
+	Y and Z vectors; the last incomplete group of keys is decoded from a zero
+	padded copy of the data.
+-----------------------------------------------------------------------------*/
+
+#if USE_SSE2
+
+// Shuffle 4 keys stored as X,Y,Z triplets into separate X, Y and Z vectors
+static FORCEINLINE void LoadVec3x4(const float* Src, __m128& X, __m128& Y, __m128& Z)
+{
+	__m128 a = _mm_loadu_ps(Src);				// x0 y0 z0 x1
+	__m128 b = _mm_loadu_ps(Src + 4);			// y1 z1 x2 y2
+	__m128 c = _mm_loadu_ps(Src + 8);			// z2 x3 y3 z3
+	X = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+	Y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+	Z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), c, _MM_SHUFFLE(3,0,2,0));
+}
+
+// Reverse operation for LoadVec3x4()
+static FORCEINLINE void StoreVec3x4(float* Dst, __m128 X, __m128 Y, __m128 Z)
+{
+	__m128 a = _mm_shuffle_ps(_mm_shuffle_ps(X, Y, _MM_SHUFFLE(0,0,0,0)), _mm_shuffle_ps(Z, X, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0));
+	__m128 b = _mm_shuffle_ps(_mm_shuffle_ps(Y, Z, _MM_SHUFFLE(1,1,1,1)), _mm_shuffle_ps(X, Y, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0));
+	__m128 c = _mm_shuffle_ps(_mm_shuffle_ps(Z, X, _MM_SHUFFLE(3,3,2,2)), _mm_shuffle_ps(Y, Z, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0));
+	_mm_storeu_ps(Dst, a);
+	_mm_storeu_ps(Dst + 4, b);
+	_mm_storeu_ps(Dst + 8, c);
+}
+
+// The same as RESTORE_QUAT_W(), and store 4 quaternions. Note: _mm_max_ps() returns 0 for NaN and -0
+// values, what matches (wSq > 0) check.
+static FORCEINLINE void StoreQuatNoW4(CQuat* Dst, __m128 X, __m128 Y, __m128 Z)
+{
+	__m128 wSq = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_add_ps(_mm_mul_ps(X, X), _mm_mul_ps(Y, Y)), _mm_mul_ps(Z, Z)));
+	__m128 W = _mm_sqrt_ps(_mm_max_ps(wSq, _mm_setzero_ps()));
+	_MM_TRANSPOSE4_PS(X, Y, Z, W);
+	float* d = &Dst->x;
+	_mm_storeu_ps(d,      X);
+	_mm_storeu_ps(d + 4,  Y);
+	_mm_storeu_ps(d + 8,  Z);
+	_mm_storeu_ps(d + 12, W);
+}
+
+// Unpack 11:11:10 bit fields, X is in the highest bits
+static FORCEINLINE void Unpack32NoW(const byte* Data, __m128& X, __m128& Y, __m128& Z)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)Data);
+	X = _mm_cvtepi32_ps(_mm_srli_epi32(v, 21));
+	Y = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10), _mm_set1_epi32(0x7FF)));
+	Z = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0x3FF)));
+}
+
+// Decode groups of 4 keys with Decode4(Data, Dst), the last incomplete group is decoded from a temporary buffer
+template<int KeySize, typename T, typename F>
+static FORCEINLINE void DecodeKeys4(const byte* Data, int NumKeys, T* Dst, F Decode4)
+{
+	int k = 0;
+	for ( ; k + 4 <= NumKeys; k += 4)
+		Decode4(Data + k * KeySize, Dst + k);
+	if (k < NumKeys)
+	{
+		byte Tmp[KeySize * 4];
+		T TmpDst[4];
+		memset(Tmp, 0, sizeof(Tmp));
+		memcpy(Tmp, Data + k * KeySize, (NumKeys - k) * KeySize);
+		Decode4(Tmp, TmpDst);
+		memcpy(Dst + k, TmpDst, (NumKeys - k) * sizeof(T));
+	}
+}
+
+#endif // USE_SSE2
+
+// Read components of 16-bit key. Missing components are set to Default.
+static FORCEINLINE const byte* Read16BitComponents(const byte* Data, int ComponentMask, int Default, int& X, int& Y, int& Z)
+{
+	const uint16* s = (const uint16*)Data;
+	X = (ComponentMask & 1) ? *s++ : Default;
+	Y = (ComponentMask & 2) ? *s++ : Default;
+	Z = (ComponentMask & 4) ? *s++ : Default;
+	return (const byte*)s;
+}
+
+
+/*-----------------------------------------------------------------------------
+	Translation keys
+-----------------------------------------------------------------------------*/
+
+void DecodeVectorFloat96Keys(const byte* Data, int NumKeys, int ComponentMask, CVec3* Dst)
+{
+	if ((ComponentMask & 7) == 0 || (ComponentMask & 7) == 7)
+	{
+		// all components are stored
+		memcpy(Dst, Data, NumKeys * sizeof(CVec3));
+		return;
+	}
+	const float* s = (const float*)Data;
+	for (int k = 0; k < NumKeys; k++)
+	{
+		CVec3& v = Dst[k];
+		v[0] = (ComponentMask & 1) ? *s++ : 0.0f;
+		v[1] = (ComponentMask & 2) ? *s++ : 0.0f;
+		v[2] = (ComponentMask & 4) ? *s++ : 0.0f;
+	}
+}
+
+void DecodeVectorFixed48Keys(const byte* Data, int NumKeys, CVec3* Dst)
+{
+#if USE_SSE2
+	static const float scale = 128.0f / 32767.0f;	// the same as in FVectorFixed48
+	DecodeKeys4<6>(Data, NumKeys, Dst, [](const byte* Src, CVec3* Out)
+		{
+			const uint16* s = (const uint16*)Src;
+			const __m128i Offset = _mm_set1_epi32(32767);
+			const __m128 Scale = _mm_set1_ps(scale);
+			__m128 X = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_setr_epi32(s[0], s[3], s[6], s[9]),  Offset)), Scale);
+			__m128 Y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_setr_epi32(s[1], s[4], s[7], s[10]), Offset)), Scale);
+			__m128 Z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_setr_epi32(s[2], s[5], s[8], s[11]), Offset)), Scale);
+			StoreVec3x4(Out->v, X, Y, Z);
+		});
+#else
+	for (int k = 0; k < NumKeys; k++, Data += 6)
+	{
+		FVectorFixed48 v;
+		memcpy(&v, Data, 6);
+		FVector v2 = v;
+		Dst[k] = CVT(v2);
+	}
+#endif // USE_SSE2
+}
+
+void DecodeVectorFixed48PerTrackKeys(const byte* Data, int NumKeys, int ComponentMask, CVec3* Dst)
+{
+	// Rarely used format, no need for SIMD code
+	for (int k = 0; k < NumKeys; k++)
+	{
+		int X, Y, Z;
+		Data = Read16BitComponents(Data, ComponentMask, -1, X, Y, Z);
+		CVec3& v = Dst[k];
+		v[0] = (X >= 0) ? DecodeFixed48_PerTrackComponent<7>(X) : 0.0f;
+		v[1] = (Y >= 0) ? DecodeFixed48_PerTrackComponent<7>(Y) : 0.0f;
+		v[2] = (Z >= 0) ? DecodeFixed48_PerTrackComponent<7>(Z) : 0.0f;
+	}
+}
+
+void DecodeVectorIntervalFixed32Keys(const byte* Data, int NumKeys, const FVector& Mins, const FVector& Ranges, CVec3* Dst)
+{
+#if USE_SSE2
+	DecodeKeys4<4>(Data, NumKeys, Dst, [&Mins, &Ranges](const byte* Src, CVec3* Out)
+		{
+			// Fields order is different from quaternion: X is in the lowest 10 bits
+			__m128i v = _mm_loadu_si128((const __m128i*)Src);
+			__m128 X = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0x3FF)));
+			__m128 Y = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10), _mm_set1_epi32(0x7FF)));
+			__m128 Z = _mm_cvtepi32_ps(_mm_srli_epi32(v, 21));
+			const __m128 One = _mm_set1_ps(1.0f);
+			X = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_div_ps(X, _mm_set1_ps(511.0f)),  One), _mm_set1_ps(Ranges.X)), _mm_set1_ps(Mins.X));
+			Y = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_div_ps(Y, _mm_set1_ps(1023.0f)), One), _mm_set1_ps(Ranges.Y)), _mm_set1_ps(Mins.Y));
+			Z = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_div_ps(Z, _mm_set1_ps(1023.0f)), One), _mm_set1_ps(Ranges.Z)), _mm_set1_ps(Mins.Z));
+			StoreVec3x4(Out->v, X, Y, Z);
+		});
+#else
+	for (int k = 0; k < NumKeys; k++, Data += 4)
+	{
+		FVectorIntervalFixed32 v;
+		memcpy(&v, Data, 4);
+		FVector v2 = v.ToVector(Mins, Ranges);
+		Dst[k] = CVT(v2);
+	}
+#endif // USE_SSE2
+}
+
+
+/*-----------------------------------------------------------------------------
+	Rotation keys
+-----------------------------------------------------------------------------*/
+
+void DecodeQuatFloat96NoWKeys(const byte* Data, int NumKeys, CQuat* Dst)
+{
+#if USE_SSE2
+	DecodeKeys4<12>(Data, NumKeys, Dst, [](const byte* Src, CQuat* Out)
+		{
+			__m128 X, Y, Z;
+			LoadVec3x4((const float*)Src, X, Y, Z);
+			StoreQuatNoW4(Out, X, Y, Z);
+		});
+#else
+	for (int k = 0; k < NumKeys; k++, Data += 12)
+	{
+		FQuatFloat96NoW q;
+		memcpy(&q, Data, 12);
+		FQuat q2 = q;
+		Dst[k] = CVT(q2);
+	}
+#endif // USE_SSE2
+}
+
+void DecodeQuatFixed48NoWKeys(const byte* Data, int NumKeys, int ComponentMask, CQuat* Dst)
+{
+	// Missing components are 32767, what corresponds to 0
+#if USE_SSE2
+	int k = 0;
+	for ( ; k < NumKeys; k += 4)
+	{
+		int V[3][4];
+		int Count = min(NumKeys - k, 4);
+		for (int i = 0; i < 4; i++)
+		{
+			if (i < Count)
+				Data = Read16BitComponents(Data, ComponentMask, 32767, V[0][i], V[1][i], V[2][i]);
+			else
+				V[0][i] = V[1][i] = V[2][i] = 32767;
+		}
+		const __m128i Offset = _mm_set1_epi32(32767);
+		const __m128 Scale = _mm_set1_ps(32767.0f);
+		__m128 X = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)V[0]), Offset)), Scale);
+		__m128 Y = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)V[1]), Offset)), Scale);
+		__m128 Z = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)V[2]), Offset)), Scale);
+		if (Count == 4)
+		{
+			StoreQuatNoW4(Dst + k, X, Y, Z);
+		}
+		else
+		{
+			CQuat Tmp[4];
+			StoreQuatNoW4(Tmp, X, Y, Z);
+			memcpy(Dst + k, Tmp, Count * sizeof(CQuat));
+		}
+	}
+#else
+	for (int k = 0; k < NumKeys; k++)
+	{
+		int X, Y, Z;
+		Data = Read16BitComponents(Data, ComponentMask, 32767, X, Y, Z);
+		FQuatFixed48NoW q;
+		q.X = X; q.Y = Y; q.Z = Z;
+		FQuat q2 = q;
+		Dst[k] = CVT(q2);
+	}
+#endif // USE_SSE2
+}
+
+void DecodeQuatFixed32NoWKeys(const byte* Data, int NumKeys, CQuat* Dst)
+{
+#if USE_SSE2
+	DecodeKeys4<4>(Data, NumKeys, Dst, [](const byte* Src, CQuat* Out)
+		{
+			__m128 X, Y, Z;
+			Unpack32NoW(Src, X, Y, Z);
+			const __m128 One = _mm_set1_ps(1.0f);
+			X = _mm_sub_ps(_mm_div_ps(X, _mm_set1_ps(1023.0f)), One);
+			Y = _mm_sub_ps(_mm_div_ps(Y, _mm_set1_ps(1023.0f)), One);
+			Z = _mm_sub_ps(_mm_div_ps(Z, _mm_set1_ps(511.0f)),  One);
+			StoreQuatNoW4(Out, X, Y, Z);
+		});
+#else
+	for (int k = 0; k < NumKeys; k++, Data += 4)
+	{
+		FQuatFixed32NoW q;
+		memcpy(&q, Data, 4);
+		FQuat q2 = q;
+		Dst[k] = CVT(q2);
+	}
+#endif // USE_SSE2
+}
+
+void DecodeQuatIntervalFixed32NoWKeys(const byte* Data, int NumKeys, const FVector& Mins, const FVector& Ranges, CQuat* Dst)
+{
+#if USE_SSE2
+	DecodeKeys4<4>(Data, NumKeys, Dst, [&Mins, &Ranges](const byte* Src, CQuat* Out)
+		{
+			__m128 X, Y, Z;
+			Unpack32NoW(Src, X, Y, Z);
+			const __m128 One = _mm_set1_ps(1.0f);
+			X = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_div_ps(X, _mm_set1_ps(1023.0f)), One), _mm_set1_ps(Ranges.X)), _mm_set1_ps(Mins.X));
+			Y = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_div_ps(Y, _mm_set1_ps(1023.0f)), One), _mm_set1_ps(Ranges.Y)), _mm_set1_ps(Mins.Y));
+			Z = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_div_ps(Z, _mm_set1_ps(511.0f)),  One), _mm_set1_ps(Ranges.Z)), _mm_set1_ps(Mins.Z));
+			StoreQuatNoW4(Out, X, Y, Z);
+		});
+#else
+	for (int k = 0; k < NumKeys; k++, Data += 4)
+	{
+		FQuatIntervalFixed32NoW q;
+		memcpy(&q, Data, 4);
+		FQuat q2 = q.ToQuat(Mins, Ranges);
+		Dst[k] = CVT(q2);
+	}
+#endif // USE_SSE2
+}
+
+void DecodeQuatFloat32NoWKeys(const byte* Data, int NumKeys, CQuat* Dst)
+{
+#if USE_SSE2
+	DecodeKeys4<4>(Data, NumKeys, Dst, [](const byte* Src, CQuat* Out)
+		{
+			// Each component is a float with 3-bit exponent and 7 (6 for Z) bits of mantissa, see FQuatFloat32NoW
+			__m128i v = _mm_loadu_si128((const __m128i*)Src);
+			const __m128i Bias = _mm_set1_epi32(123);
+			const __m128i Exp3 = _mm_set1_epi32(7);
+			__m128i x = _mm_srli_epi32(v, 21);
+			__m128i y = _mm_and_si128(_mm_srli_epi32(v, 10), _mm_set1_epi32(0x7FF));
+			__m128i z = _mm_and_si128(v, _mm_set1_epi32(0x3FF));
+			__m128i X = _mm_or_si128(
+				_mm_slli_epi32(_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(x, 7), Exp3), Bias), 23),
+				_mm_slli_epi32(_mm_or_si128(_mm_and_si128(x, _mm_set1_epi32(0x7F)), _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x400)), 5)), 16));
+			__m128i Y = _mm_or_si128(
+				_mm_slli_epi32(_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(y, 7), Exp3), Bias), 23),
+				_mm_slli_epi32(_mm_or_si128(_mm_and_si128(y, _mm_set1_epi32(0x7F)), _mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(0x400)), 5)), 16));
+			__m128i Z = _mm_or_si128(
+				_mm_slli_epi32(_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(z, 6), Exp3), Bias), 23),
+				_mm_slli_epi32(_mm_or_si128(_mm_and_si128(z, _mm_set1_epi32(0x3F)), _mm_slli_epi32(_mm_and_si128(z, _mm_set1_epi32(0x200)), 5)), 17));
+			StoreQuatNoW4(Out, _mm_castsi128_ps(X), _mm_castsi128_ps(Y), _mm_castsi128_ps(Z));
+		});
+#else
+	for (int k = 0; k < NumKeys; k++, Data += 4)
+	{
+		FQuatFloat32NoW q;
+		memcpy(&q, Data, 4);
+		FQuat q2 = q;
+		Dst[k] = CVT(q2);
+	}
+#endif // USE_SSE2
+}
@@ -710,6 +710,7 @@ public:
 	END_PROP_TABLE
 
 	void ConvertAnims();
+	void DecodeAnimTracks(const UAnimSequence* Seq, CAnimSequence* Dst);
 	virtual void Serialize(FArchive &Ar);
 
 	virtual void PostLoad()
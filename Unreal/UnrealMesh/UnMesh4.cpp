@@ -17,6 +17,8 @@
 #include "Mesh/StaticMesh.h"
 #include "TypeConvert.h"
 
+#include "Parallel.h"
+
 
 //#define DEBUG_SKELMESH		1
 //#define DEBUG_STATICMESH		1
@@ -40,6 +42,9 @@
 #endif
 
 
+#define CONVERT_VERTEX_BLOCK	16384		// number of vertices converted by a single ParallelFor item
+
+
 #if NUM_INFLUENCES_UE4 != NUM_INFLUENCES
 //!!#error NUM_INFLUENCES_UE4 and NUM_INFLUENCES are not matching!
 #endif
@@ -1850,13 +1855,12 @@ void USkeletalMesh4::ConvertMesh()
 	Mesh->RotOrigin.Set(0, 0, 0);
 	Mesh->MeshScale.Set(1, 1, 1);							// missing in UE4
 
-	// convert LODs
+	// convert LODs: create CSkelMeshLod objects first, then convert them in parallel
 	Mesh->Lods.Empty(LODModels.Num());
 	assert(LODModels.Num() == LODInfo.Num());
+	TArray<int> SrcLodIndices;
 	for (int lod = 0; lod < LODModels.Num(); lod++)
 	{
-		guard(ConvertLod);
-
 		const FStaticLODModel4 &SrcLod = LODModels[lod];
 		if (SrcLod.Indices.Indices16.Num() == 0 && SrcLod.Indices.Indices32.Num() == 0)
 		{
@@ -1872,6 +1876,17 @@ void USkeletalMesh4::ConvertMesh()
 		Lod->NumTexCoords = NumTexCoords;
 		Lod->HasNormals   = true;
 		Lod->HasTangents  = true;
+		SrcLodIndices.Add(lod);
+	}
+
+	ParallelFor(Mesh->Lods.Num(), [this, Mesh, &SrcLodIndices](int LodIndex)
+	{
+		int lod = SrcLodIndices[LodIndex];
+		guard(ConvertLod);
+
+		const FStaticLODModel4 &SrcLod = LODModels[lod];
+		CSkelMeshLod *Lod = &Mesh->Lods[LodIndex];
+		int NumTexCoords = Lod->NumTexCoords;
 
 		guard(ProcessVerts);
 
@@ -1893,21 +1908,26 @@ void USkeletalMesh4::ConvertMesh()
 		// allocate the vertices
 		Lod->AllocateVerts(VertexCount);
 
-		int chunkIndex = -1;
-		int lastChunkVertex = -1;
-		int chunkVertexIndex = 0;
-
-		const TArray<uint16>* BoneMap = NULL;
 		const FSkeletalMeshVertexBuffer4& VertBuffer = SrcLod.VertexBufferGPUSkin;
-		CSkelMeshVertex* D = Lod->Verts;
 
 		if (SrcLod.ColorVertexBuffer.Data.Num() == VertexCount)
 			Lod->AllocateVertexColorBuffer();
 		else if (SrcLod.ColorVertexBuffer.Data.Num())
 			appPrintf("LOD %d has invalid vertex color stream\n", lod);
 
-		for (int Vert = 0; Vert < VertexCount; Vert++, D++)
+		// Find the first vertex of each chunk or section, so vertices could be converted in parallel
+		struct ChunkRange
 		{
+			int FirstVertex;
+			int ChunkIndex;
+			const TArray<uint16>* BoneMap;
+		};
+		TArray<ChunkRange> Chunks;
+		int chunkIndex = -1;
+		int lastChunkVertex = -1;
+		for (int Vert = 0; Vert < VertexCount; Vert = lastChunkVertex)
+		{
+			const TArray<uint16>* BoneMap = NULL;
 			while (Vert >= lastChunkVertex) // this will fix any issues with empty chunks or sections
 			{
 				// proceed to next chunk or section
@@ -1925,15 +1945,23 @@ void USkeletalMesh4::ConvertMesh()
 					lastChunkVertex = S.BaseVertexIndex + S.NumVertices;
 					BoneMap = &S.BoneMap;
 				}
-				chunkVertexIndex = 0;
 			}
+			ChunkRange* R = new (Chunks) ChunkRange;
+			R->FirstVertex = Vert;
+			R->ChunkIndex  = chunkIndex;
+			R->BoneMap     = BoneMap;
+		}
+
+		auto ConvertVertex = [&](int Vert, const ChunkRange& Chunk)
+		{
+			CSkelMeshVertex* D = Lod->Verts + Vert;
 
 			// get vertex from GPU skin
 			const FSkelMeshVertexBase *V;				// has everything but UV[]
 
 			if (bUseVerticesFromSections)
 			{
-				const FSoftVertex4& V0 = SrcLod.Sections[chunkIndex].SoftVertices[chunkVertexIndex++];
+				const FSoftVertex4& V0 = SrcLod.Sections[Chunk.ChunkIndex].SoftVertices[Vert - Chunk.FirstVertex];
 				const FMeshUVFloat *SrcUV = V0.UV;
 				V = &V0;
 				// UV: simply copy float data
@@ -1983,12 +2011,36 @@ void USkeletalMesh4::ConvertMesh()
 				byte BoneWeight = V->Infs.BoneWeight[i];
 				if (BoneWeight == 0) continue;				// skip this influence (but do not stop the loop!)
 				PackedWeights |= BoneWeight << (i2 * 8);
-				D->Bone[i2]   = (*BoneMap)[BoneIndex];
+				D->Bone[i2]   = (*Chunk.BoneMap)[BoneIndex];
 				i2++;
 			}
 			D->PackedWeights = PackedWeights;
 			if (i2 < NUM_INFLUENCES_UE4) D->Bone[i2] = INDEX_NONE; // mark end of list
-		}
+		};
+
+		int NumBlocks = (VertexCount + CONVERT_VERTEX_BLOCK - 1) / CONVERT_VERTEX_BLOCK;
+		ParallelFor(NumBlocks, [&](int Block)
+		{
+			int FirstVert = Block * CONVERT_VERTEX_BLOCK;
+			int EndVert = min(FirstVert + CONVERT_VERTEX_BLOCK, VertexCount);
+			// find the chunk containing the first vertex of the block
+			int Low = 0, High = Chunks.Num() - 1;
+			while (Low < High)
+			{
+				int Mid = (Low + High + 1) / 2;
+				if (Chunks[Mid].FirstVertex <= FirstVert)
+					Low = Mid;
+				else
+					High = Mid - 1;
+			}
+			int ChunkIndex = Low;
+			for (int Vert = FirstVert; Vert < EndVert; Vert++)
+			{
+				while (ChunkIndex + 1 < Chunks.Num() && Vert >= Chunks[ChunkIndex + 1].FirstVertex)
+					ChunkIndex++;
+				ConvertVertex(Vert, Chunks[ChunkIndex]);
+			}
+		}, 1);
 
 		unguard;	// ProcessVerts
 
@@ -2020,7 +2072,7 @@ void USkeletalMesh4::ConvertMesh()
 		unguard;	// ProcessSections
 
 		unguardf("lod=%d", lod); // ConvertLod
-	}
+	}, 1);
 
 	// copy skeleton
 	guard(ProcessSkeleton);
@@ -2820,12 +2872,11 @@ void UStaticMesh4::ConvertMesh()
 	VectorSubtract(CVT(Bounds.Origin), CVT(Bounds.BoxExtent), CVT(Mesh->BoundingBox.Min));
 	VectorAdd     (CVT(Bounds.Origin), CVT(Bounds.BoxExtent), CVT(Mesh->BoundingBox.Max));
 
-	// convert lods
+	// convert lods: create CStaticMeshLod objects first, then convert them in parallel
 	Mesh->Lods.Empty(Lods.Num());
+	TArray<int> SrcLodIndices;
 	for (int lodIndex = 0; lodIndex < Lods.Num(); lodIndex++)
 	{
-		guard(ConvertLod);
-
 		const FStaticMeshLODModel4 &SrcLod = Lods[lodIndex];
 
 		int NumTexCoords = SrcLod.VertexBuffer.NumTexCoords;
@@ -2840,12 +2891,27 @@ void UStaticMesh4::ConvertMesh()
 
 		if (NumTexCoords > MAX_MESH_UV_SETS)
 			appError("StaticMesh has %d UV sets", NumTexCoords);
+		if (SrcLod.IndexBuffer.Indices16.Num() == 0 && SrcLod.IndexBuffer.Indices32.Num() == 0)
+			appError("This StaticMesh doesn't have an index buffer");
 
 		CStaticMeshLod *Lod = new (Mesh->Lods) CStaticMeshLod;
 
 		Lod->NumTexCoords = NumTexCoords;
 		Lod->HasNormals   = true;
 		Lod->HasTangents  = true;
+		SrcLodIndices.Add(lodIndex);
+	}
+
+	ParallelFor(Mesh->Lods.Num(), [this, Mesh, &SrcLodIndices](int LodIndex)
+	{
+		int lodIndex = SrcLodIndices[LodIndex];
+		guard(ConvertLod);
+
+		const FStaticMeshLODModel4 &SrcLod = Lods[lodIndex];
+		CStaticMeshLod *Lod = &Mesh->Lods[LodIndex];
+
+		int NumTexCoords = Lod->NumTexCoords;
+		int NumVerts     = SrcLod.PositionVertexBuffer.Verts.Num();
 
 		// sections
 		Lod->Sections.AddDefaulted(SrcLod.Sections.Num());
@@ -2864,33 +2930,37 @@ void UStaticMesh4::ConvertMesh()
 		if (SrcLod.ColorVertexBuffer.NumVertices)
 			Lod->AllocateVertexColorBuffer();
 
-		for (int i = 0; i < NumVerts; i++)
+		int NumBlocks = (NumVerts + CONVERT_VERTEX_BLOCK - 1) / CONVERT_VERTEX_BLOCK;
+		ParallelFor(NumBlocks, [&](int Block)
 		{
-			const FStaticMeshUVItem4 &SUV = SrcLod.VertexBuffer.UV[i];
-			CStaticMeshVertex &V = Lod->Verts[i];
-
-			V.Position = CVT(SrcLod.PositionVertexBuffer.Verts[i]);
-			UnpackNormals(SUV.Normal, V);
-			// copy UV
-			const FMeshUVFloat* fUV = &SUV.UV[0];
-			V.UV = *CVT(fUV);
-			for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+			int EndVert = min((Block + 1) * CONVERT_VERTEX_BLOCK, NumVerts);
+			for (int i = Block * CONVERT_VERTEX_BLOCK; i < EndVert; i++)
 			{
-				fUV++;
-				Lod->ExtraUV[TexCoordIndex-1][i] = *CVT(fUV);
-			}
-			if (Lod->VertexColors)
-			{
-				Lod->VertexColors[i] = SrcLod.ColorVertexBuffer.Data[i];
+				const FStaticMeshUVItem4 &SUV = SrcLod.VertexBuffer.UV[i];
+				CStaticMeshVertex &V = Lod->Verts[i];
+
+				V.Position = CVT(SrcLod.PositionVertexBuffer.Verts[i]);
+				UnpackNormals(SUV.Normal, V);
+				// copy UV
+				const FMeshUVFloat* fUV = &SUV.UV[0];
+				V.UV = *CVT(fUV);
+				for (int TexCoordIndex = 1; TexCoordIndex < NumTexCoords; TexCoordIndex++)
+				{
+					fUV++;
+					Lod->ExtraUV[TexCoordIndex-1][i] = *CVT(fUV);
+				}
+				if (Lod->VertexColors)
+				{
+					Lod->VertexColors[i] = SrcLod.ColorVertexBuffer.Data[i];
+				}
 			}
-		}
+		}, 1);
 
 		// indices
 		Lod->Indices.Initialize(&SrcLod.IndexBuffer.Indices16, &SrcLod.IndexBuffer.Indices32);
-		if (Lod->Indices.Num() == 0) appError("This StaticMesh doesn't have an index buffer");
 
 		unguardf("lod=%d", lodIndex);
-	}
+	}, 1);
 
 	Mesh->FinalizeMesh();
 
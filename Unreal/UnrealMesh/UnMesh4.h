@@ -182,6 +182,7 @@ public:
 	virtual void PostLoad();
 
 	void ConvertAnims(UAnimSequence4* Seq);
+	void DecodeAnimTracks(UAnimSequence4* Seq, CAnimSequence* Dst);
 };
 
 
@@ -405,6 +405,25 @@ struct FVectorHalf
 SIMPLE_TYPE(FVectorHalf, uint16);
 
 
+/*-----------------------------------------------------------------------------
+	Batch decoders of compressed animation keys (UnAnimKeys.cpp)
+	Decode NumKeys keys from little-endian data into Dst. Components which are
+	not set in ComponentMask aren't stored in data (per-track compression),
+	use 7 for keys with all components.
+-----------------------------------------------------------------------------*/
+
+void DecodeVectorFloat96Keys(const byte* Data, int NumKeys, int ComponentMask, CVec3* Dst);
+void DecodeVectorFixed48Keys(const byte* Data, int NumKeys, CVec3* Dst);
+void DecodeVectorFixed48PerTrackKeys(const byte* Data, int NumKeys, int ComponentMask, CVec3* Dst);
+void DecodeVectorIntervalFixed32Keys(const byte* Data, int NumKeys, const FVector& Mins, const FVector& Ranges, CVec3* Dst);
+
+void DecodeQuatFloat96NoWKeys(const byte* Data, int NumKeys, CQuat* Dst);
+void DecodeQuatFixed48NoWKeys(const byte* Data, int NumKeys, int ComponentMask, CQuat* Dst);
+void DecodeQuatFixed32NoWKeys(const byte* Data, int NumKeys, CQuat* Dst);
+void DecodeQuatIntervalFixed32NoWKeys(const byte* Data, int NumKeys, const FVector& Mins, const FVector& Ranges, CQuat* Dst);
+void DecodeQuatFloat32NoWKeys(const byte* Data, int NumKeys, CQuat* Dst);
+
+
 #if BATMAN
 
 // This is a variant of FQuatFixed48NoW developed for Batman: Arkham Asylum. It's destination
@@ -1,8 +1,16 @@
 #include <png.h>
+#include <zlib.h>
 
 #include "Core.h"
 #include "UnCore.h"
 
+#include "TexturePNG.h"
+#include "Parallel.h"
+#include "MathSSE2.h"
+
+#define PNG_DEFLATE_CHUNK_SIZE		(256*1024)	// size of image data block compressed by a single thread
+#define PNG_DEFLATE_DICT_SIZE		32768		// deflate window size
+
 struct PngReadCtx
 {
 	const byte* CompressedData;
@@ -10,15 +18,6 @@ struct PngReadCtx
 	int ReadOffset;
 };
 
-struct PngWriteCtx
-{
-	TArray<byte>& CompressedData;
-
-	PngWriteCtx(TArray<byte>& pDst)
-	: CompressedData(pDst)
-	{}
-};
-
 static void user_read_compressed(png_structp png_ptr, png_bytep data, png_size_t length)
 {
 	PngReadCtx* ctx = (PngReadCtx*)png_get_io_ptr(png_ptr);
@@ -30,17 +29,6 @@ static void user_read_compressed(png_structp png_ptr, png_bytep data, png_size_t
 	ctx->ReadOffset += length;
 }
 
-static void user_write_compressed(png_structp png_ptr, png_bytep data, png_size_t length)
-{
-	PngWriteCtx* ctx = (PngWriteCtx*) png_get_io_ptr(png_ptr);
-	int Offset = ctx->CompressedData.AddUninitialized(length);
-	memcpy(ctx->CompressedData.GetData() + Offset, data, length);
-}
-
-static void user_flush_data(png_structp png_ptr)
-{
-}
-
 static void user_error_fn(png_structp png_ptr, png_const_charp error_msg)
 {
 	appError("Error in PNG data: %s", error_msg);
@@ -189,75 +177,380 @@ bool UncompressPNG(const unsigned char* CompressedData, int CompressedSize, int
 	unguard;
 }
 
-void CompressPNG(const unsigned char* pic, int Width, int Height, TArray<byte>& CompressedData)
+/*-----------------------------------------------------------------------------
+	PNG writer
+
+	Image rows are filtered with per-row adaptive filter selection (the same
+	"minimum sum of absolute differences" heuristic libpng uses), then filtered
+	data is split into blocks which are compressed in parallel, similar to pigz.
+	Each block is compressed as a separate raw deflate stream, primed with the
+	last 32K of the previous block as a dictionary, and terminated with a sync
+	flush, so concatenated blocks form a single valid zlib stream.
+-----------------------------------------------------------------------------*/
+
+enum
 {
-	guard(CompressPNG);
+	PNG_ROW_FILTER_NONE,
+	PNG_ROW_FILTER_SUB,
+	PNG_ROW_FILTER_UP,
+	PNG_ROW_FILTER_AVG,
+	PNG_ROW_FILTER_PAETH,
+};
 
-	int PixelChannels = /*(RawFormat == ERGBFormat::Gray) ? 1 :*/ 3;
+static const struct
+{
+	int		ZlibLevel;
+	int		ZlibStrategy;
+	int		NumFilters;			// filters are tried in order of the enum above
+	byte	ZlibFlags;			// FLG byte of zlib header, contains FLEVEL
+} PngCompressionLevels[] =
+{
+	{ 1, Z_HUFFMAN_ONLY,     PNG_ROW_FILTER_PAETH + 1, 0x01 },	// PNG_COMPRESS_FAST
+	{ 1, Z_DEFAULT_STRATEGY, PNG_ROW_FILTER_PAETH + 1, 0x01 },	// PNG_COMPRESS_DEFAULT
+	{ 9, Z_DEFAULT_STRATEGY, PNG_ROW_FILTER_PAETH + 1, 0xDA },	// PNG_COMPRESS_BEST
+};
 
-	// Verify alpha channels of texture, see the possibility to drop one
-	const unsigned char* p = pic + 3;
-	for (int i = Width * Height; i > 0; i--, p += 4)
+static FORCEINLINE byte PaethPredictor(int a, int b, int c)
+{
+	int pa = abs(b - c);
+	int pb = abs(a - c);
+	int pc = abs(a + b - 2 * c);
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
+
+// Apply filter to the single image row. Prev is the previous unfiltered row (zeros for the first row).
+// Returns filter cost: sum of absolute values of filtered bytes, interpreted as signed.
+static unsigned FilterRow(int Filter, const byte* Row, const byte* Prev, byte* Dst, int RowBytes, int Bpp)
+{
+	int i = 0;
+	unsigned Cost = 0;
+
+	// The first pixel has no left neighbour
+	for ( ; i < Bpp; i++)
 	{
-		if (*p != 255)
+		byte v;
+		switch (Filter)
 		{
-			PixelChannels = 4;
+		case PNG_ROW_FILTER_UP:
+		case PNG_ROW_FILTER_PAETH:
+			v = Row[i] - Prev[i];
 			break;
+		case PNG_ROW_FILTER_AVG:
+			v = Row[i] - (Prev[i] >> 1);
+			break;
+		default:
+			v = Row[i];
 		}
+		Dst[i] = v;
+		Cost += abs((int8)v);
 	}
 
-	unsigned char* newPic = NULL;
-	if (PixelChannels == 3)
+#if USE_SSE2
+	const __m128i Zero = _mm_setzero_si128();
+	__m128i CostSum = Zero;
+	for ( ; i + 16 <= RowBytes; i += 16)
 	{
-		// Squeeze pixel information if newly allocated memory block
-		newPic = new unsigned char[Width * Height * 3];
-		const unsigned char* s = pic;
-		unsigned char* d = newPic;
-		for (int i = Width * Height; i > 0; i--)
+		__m128i x = _mm_loadu_si128((const __m128i*)(Row + i));
+		__m128i v;
+		switch (Filter)
 		{
-			*d++ = *s++;
-			*d++ = *s++;
-			*d++ = *s++;
-			s++;
+		case PNG_ROW_FILTER_SUB:
+			v = _mm_sub_epi8(x, _mm_loadu_si128((const __m128i*)(Row + i - Bpp)));
+			break;
+		case PNG_ROW_FILTER_UP:
+			v = _mm_sub_epi8(x, _mm_loadu_si128((const __m128i*)(Prev + i)));
+			break;
+		case PNG_ROW_FILTER_AVG:
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(Row + i - Bpp));
+				__m128i b = _mm_loadu_si128((const __m128i*)(Prev + i));
+				// _mm_avg_epu8 rounds up, PNG requires rounding down
+				__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+				v = _mm_sub_epi8(x, avg);
+			}
+			break;
+		case PNG_ROW_FILTER_PAETH:
+			{
+				__m128i a8 = _mm_loadu_si128((const __m128i*)(Row + i - Bpp));
+				__m128i b8 = _mm_loadu_si128((const __m128i*)(Prev + i));
+				__m128i c8 = _mm_loadu_si128((const __m128i*)(Prev + i - Bpp));
+				__m128i pred[2];
+				for (int half = 0; half < 2; half++)
+				{
+					__m128i a = half ? _mm_unpackhi_epi8(a8, Zero) : _mm_unpacklo_epi8(a8, Zero);
+					__m128i b = half ? _mm_unpackhi_epi8(b8, Zero) : _mm_unpacklo_epi8(b8, Zero);
+					__m128i c = half ? _mm_unpackhi_epi8(c8, Zero) : _mm_unpacklo_epi8(c8, Zero);
+					__m128i bc = _mm_sub_epi16(b, c);
+					__m128i ac = _mm_sub_epi16(a, c);
+					__m128i abc = _mm_add_epi16(bc, ac);
+					__m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(Zero, bc));
+					__m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(Zero, ac));
+					__m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(Zero, abc));
+					__m128i NotA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+					__m128i NotB = _mm_cmpgt_epi16(pb, pc);
+					__m128i bOrC = _mm_or_si128(_mm_and_si128(NotB, c), _mm_andnot_si128(NotB, b));
+					pred[half] = _mm_or_si128(_mm_and_si128(NotA, bOrC), _mm_andnot_si128(NotA, a));
+				}
+				v = _mm_sub_epi8(x, _mm_packus_epi16(pred[0], pred[1]));
+			}
+			break;
+		default:
+			v = x;
 		}
-		pic = newPic;
+		_mm_storeu_si128((__m128i*)(Dst + i), v);
+		// abs(int8(v)) == min(v, -v) when treated as unsigned bytes
+		CostSum = _mm_add_epi64(CostSum, _mm_sad_epu8(_mm_min_epu8(v, _mm_sub_epi8(Zero, v)), Zero));
 	}
+	Cost += _mm_cvtsi128_si32(CostSum) + _mm_cvtsi128_si32(_mm_srli_si128(CostSum, 8));
+#endif // USE_SSE2
 
-	PngWriteCtx ctx(CompressedData);
-	ctx.CompressedData.Empty(Width * Height * PixelChannels); // preallocate
+	for ( ; i < RowBytes; i++)
+	{
+		byte v;
+		switch (Filter)
+		{
+		case PNG_ROW_FILTER_SUB:
+			v = Row[i] - Row[i - Bpp];
+			break;
+		case PNG_ROW_FILTER_UP:
+			v = Row[i] - Prev[i];
+			break;
+		case PNG_ROW_FILTER_AVG:
+			v = Row[i] - ((Row[i - Bpp] + Prev[i]) >> 1);
+			break;
+		case PNG_ROW_FILTER_PAETH:
+			v = Row[i] - PaethPredictor(Row[i - Bpp], Prev[i], Prev[i - Bpp]);
+			break;
+		default:
+			v = Row[i];
+		}
+		Dst[i] = v;
+		Cost += abs((int8)v);
+	}
 
-	png_structp png_ptr	= png_create_write_struct(PNG_LIBPNG_VER_STRING, &ctx, user_error_fn, user_warning_fn);
-	assert(png_ptr);
+	return Cost;
+}
 
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	assert(info_ptr);
+// Copy RGB components of RGBA row
+static void SqueezeRGBRow(const byte* Src, byte* Dst, int Width)
+{
+	for (int i = 0; i < Width; i++, Src += 4, Dst += 3)
+	{
+		Dst[0] = Src[0];
+		Dst[1] = Src[1];
+		Dst[2] = Src[2];
+	}
+}
 
-	png_bytep* row_pointers = (png_bytep*) png_malloc( png_ptr, Height*sizeof(png_bytep) );
+// Filter a range of rows of RGBA image 'pic'. Each row in Dst is prefixed with filter type byte,
+// the first filtered row is placed at the start of Dst. When Bpp is 3, alpha channel is dropped.
+static void FilterRows(const byte* pic, byte* Dst, int FirstRow, int NumRows, int Width, int Bpp, int NumFilters, const byte* ZeroRow)
+{
+	int RowBytes = Width * Bpp;
+	byte* Scratch = (byte*)appMallocNoInit(RowBytes * 4);
+	byte* RowRGB = Scratch + RowBytes * 2;
+	byte* PrevRGB = Scratch + RowBytes * 3;
+	if (Bpp == 3 && FirstRow > 0)
+	{
+		SqueezeRGBRow(pic + (FirstRow - 1) * Width * 4, PrevRGB, Width);
+	}
 
-	const int RawBitDepth = 8;
-	png_set_compression_level(png_ptr, 1); // zlib compression level: 0 (uncompressed), 1 (fast) - 9 (slow)
-	png_set_IHDR(png_ptr, info_ptr, Width, Height, RawBitDepth, (PixelChannels == 4) ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-	png_set_write_fn(png_ptr, &ctx, user_write_compressed, user_flush_data);
+	for (int y = FirstRow; y < FirstRow + NumRows; y++)
+	{
+		const byte* Row;
+		const byte* Prev;
+		if (Bpp == 4)
+		{
+			Row = pic + y * RowBytes;
+			Prev = (y > 0) ? Row - RowBytes : ZeroRow;
+		}
+		else
+		{
+			if (y > FirstRow) Exchange(RowRGB, PrevRGB);
+			SqueezeRGBRow(pic + y * Width * 4, RowRGB, Width);
+			Row = RowRGB;
+			Prev = (y > 0) ? PrevRGB : ZeroRow;
+		}
+		byte* Out = Dst + (y - FirstRow) * (RowBytes + 1);
 
-	const int BytesPerPixel = (RawBitDepth * PixelChannels) / 8;
-	const int BytesPerRow = BytesPerPixel * Width;
+		byte* Best = Scratch;
+		byte* Candidate = Scratch + RowBytes;
+		int BestFilter = PNG_ROW_FILTER_NONE;
+		unsigned BestCost = FilterRow(PNG_ROW_FILTER_NONE, Row, Prev, Best, RowBytes, Bpp);
+		for (int Filter = PNG_ROW_FILTER_NONE + 1; Filter < NumFilters; Filter++)
+		{
+			unsigned Cost = FilterRow(Filter, Row, Prev, Candidate, RowBytes, Bpp);
+			if (Cost < BestCost)
+			{
+				BestCost = Cost;
+				BestFilter = Filter;
+				Exchange(Best, Candidate);
+			}
+		}
 
-	for (int i = 0; i < Height; i++)
+		Out[0] = BestFilter;
+		memcpy(Out + 1, Best, RowBytes);
+	}
+	appFree(Scratch);
+}
+
+struct CPngDeflateBlock
+{
+	byte*	Data;
+	int		Size;
+	uint32	Adler;
+};
+
+static void DeflateBlock(const byte* Data, int Offset, int Size, bool bLast, int Level, CPngDeflateBlock& Block)
+{
+	guard(DeflateBlock);
+
+	z_stream s;
+	memset(&s, 0, sizeof(s));
+	int r = deflateInit2(&s, PngCompressionLevels[Level].ZlibLevel, Z_DEFLATED, -MAX_WBITS, 8, PngCompressionLevels[Level].ZlibStrategy);
+	if (r != Z_OK) appError("deflateInit2 returned %d", r);
+
+	if (Offset > 0)
 	{
-		row_pointers[i]= (png_bytep)&pic[i * BytesPerRow];
+		// Continue compression with the data of previous block
+		int DictSize = min(Offset, PNG_DEFLATE_DICT_SIZE);
+		deflateSetDictionary(&s, Data + Offset - DictSize, DictSize);
 	}
-	png_set_rows(png_ptr, info_ptr, row_pointers);
 
-	int Transform = PNG_TRANSFORM_IDENTITY;
-	png_write_png(png_ptr, info_ptr, Transform, NULL);
+	// Reserve space for sync flush marker
+	int BufferSize = deflateBound(&s, Size) + 16;
+	Block.Data = (byte*)appMallocNoInit(BufferSize);
 
-	png_free(png_ptr, row_pointers);
-	png_destroy_write_struct(&png_ptr, &info_ptr);
+	s.next_in = const_cast<byte*>(Data + Offset);
+	s.avail_in = Size;
+	s.next_out = Block.Data;
+	s.avail_out = BufferSize;
+	r = deflate(&s, bLast ? Z_FINISH : Z_SYNC_FLUSH);
+	if (r != (bLast ? Z_STREAM_END : Z_OK) || s.avail_in != 0)
+		appError("deflate returned %d", r);
+
+	Block.Size = BufferSize - s.avail_out;
+	Block.Adler = adler32(1, Data + Offset, Size);
+	deflateEnd(&s);
+
+	unguard;
+}
+
+// Filter the image data required for compression of a single block and compress it. Only
+// the block itself and the preceding dictionary data are filtered, so memory usage doesn't
+// depend on the image size.
+static void FilterAndDeflateBlock(const byte* pic, int Width, int Height, int Bpp, int NumFilters, const byte* ZeroRow,
+	int Offset, int Size, bool bLast, int Level, CPngDeflateBlock& Block)
+{
+	int FilteredRowBytes = Width * Bpp + 1;
+	int FirstRow = max(Offset - PNG_DEFLATE_DICT_SIZE, 0) / FilteredRowBytes;
+	int LastRow = (Offset + Size - 1) / FilteredRowBytes;
+	assert(LastRow < Height);
+	int NumRows = LastRow - FirstRow + 1;
+
+	byte* Filtered = (byte*)appMallocNoInit(NumRows * FilteredRowBytes);
+	FilterRows(pic, Filtered, FirstRow, NumRows, Width, Bpp, NumFilters, ZeroRow);
+	DeflateBlock(Filtered, Offset - FirstRow * FilteredRowBytes, Size, bLast, Level, Block);
+	appFree(Filtered);
+}
 
-	if (newPic)
+static void PutBE32(byte* Dst, uint32 Value)
+{
+	Dst[0] = Value >> 24;
+	Dst[1] = (Value >> 16) & 0xFF;
+	Dst[2] = (Value >> 8) & 0xFF;
+	Dst[3] = Value & 0xFF;
+}
+
+// Appends PNG chunk to the output, chunk contents is a concatenation of 2 memory blocks
+static void WritePngChunk(TArray<byte>& Out, const char* Type, const void* Data1, int Size1, const void* Data2 = NULL, int Size2 = 0)
+{
+	int Offset = Out.AddUninitialized(Size1 + Size2 + 12);
+	byte* Dst = Out.GetData() + Offset;
+	PutBE32(Dst, Size1 + Size2);
+	memcpy(Dst + 4, Type, 4);
+	if (Size1) memcpy(Dst + 8, Data1, Size1);
+	if (Size2) memcpy(Dst + 8 + Size1, Data2, Size2);
+	PutBE32(Dst + 8 + Size1 + Size2, crc32(0, Dst + 4, Size1 + Size2 + 4));
+}
+
+void CompressPNG(const unsigned char* pic, int Width, int Height, TArray<byte>& CompressedData, int Level)
+{
+	guard(CompressPNG);
+
+	int PixelChannels = /*(RawFormat == ERGBFormat::Gray) ? 1 :*/ 3;
+
+	// Verify alpha channels of texture, see the possibility to drop one
+	const unsigned char* p = pic + 3;
+	for (int i = Width * Height; i > 0; i--, p += 4)
+	{
+		if (*p != 255)
+		{
+			PixelChannels = 4;
+			break;
+		}
+	}
+
+	const int RawBitDepth = 8;
+	const int BytesPerPixel = (RawBitDepth * PixelChannels) / 8;
+	const int BytesPerRow = BytesPerPixel * Width;
+
+	// Filter and compress image data. RGB image is squeezed from RGBA on the fly, and only
+	// data of blocks being compressed at the moment is filtered, so there's no full image copy.
+	int FilteredSize = (BytesPerRow + 1) * Height;
+	byte* ZeroRow = (byte*)appMalloc(BytesPerRow);		// "previous row" for the first one
+	int NumFilters = PngCompressionLevels[Level].NumFilters;
+	int NumBlocks = (FilteredSize + PNG_DEFLATE_CHUNK_SIZE - 1) / PNG_DEFLATE_CHUNK_SIZE;
+	TArray<CPngDeflateBlock> Blocks;
+	Blocks.AddZeroed(NumBlocks);
+	ParallelFor(NumBlocks, [&](int BlockIndex)
+		{
+			int Offset = BlockIndex * PNG_DEFLATE_CHUNK_SIZE;
+			int Size = min(PNG_DEFLATE_CHUNK_SIZE, FilteredSize - Offset);
+			FilterAndDeflateBlock(pic, Width, Height, BytesPerPixel, NumFilters, ZeroRow,
+				Offset, Size, BlockIndex == NumBlocks - 1, Level, Blocks[BlockIndex]);
+		}, 1);
+	appFree(ZeroRow);
+
+	// Build PNG file
+	CompressedData.Empty(Width * Height * PixelChannels / 2); // preallocate
+
+	static const byte Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	CompressedData.AddUninitialized(8);
+	memcpy(CompressedData.GetData(), Signature, 8);
+
+	byte Header[13];
+	PutBE32(Header, Width);
+	PutBE32(Header + 4, Height);
+	Header[8] = RawBitDepth;
+	Header[9] = (PixelChannels == 4) ? 6 : 2;		// color type: RGBA or RGB
+	Header[10] = 0;									// compression method
+	Header[11] = 0;									// filter method
+	Header[12] = 0;									// interlace method
+	WritePngChunk(CompressedData, "IHDR", Header, sizeof(Header));
+
+	// Each block is placed into a separate IDAT chunk, with zlib header in the first one,
+	// and checksum in the last one
+	static_assert(Z_DEFLATED == 8 && MAX_WBITS == 15, "Wrong zlib header");
+	byte ZlibHeader[2] = { 0x78, PngCompressionLevels[Level].ZlibFlags };
+	uint32 Adler = 1;
+	for (int BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++)
 	{
-		delete[] newPic;
+		const CPngDeflateBlock& Block = Blocks[BlockIndex];
+		int BlockOffset = BlockIndex * PNG_DEFLATE_CHUNK_SIZE;
+		Adler = adler32_combine(Adler, Block.Adler, min(PNG_DEFLATE_CHUNK_SIZE, FilteredSize - BlockOffset));
+		if (BlockIndex == 0)
+			WritePngChunk(CompressedData, "IDAT", ZlibHeader, 2, Block.Data, Block.Size);
+		else
+			WritePngChunk(CompressedData, "IDAT", Block.Data, Block.Size);
+		appFree(Block.Data);
 	}
+	byte AdlerBE[4];
+	PutBE32(AdlerBE, Adler);
+	WritePngChunk(CompressedData, "IDAT", AdlerBE, 4);
+	WritePngChunk(CompressedData, "IEND", NULL, 0);
 
 	unguard;
 }
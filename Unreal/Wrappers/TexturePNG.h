@@ -2,6 +2,15 @@
 #define __UNTEXTUREPNG_H__
 
 bool UncompressPNG(const unsigned char* CompressedData, int CompressedSize, int Width, int Height, unsigned char* pic, bool bgra);
-void CompressPNG(const unsigned char* pic, int Width, int Height, TArray<byte>& CompressedData);
+
+// PNG compression levels
+enum
+{
+	PNG_COMPRESS_FAST,
+	PNG_COMPRESS_DEFAULT,
+	PNG_COMPRESS_BEST,
+};
+
+void CompressPNG(const unsigned char* pic, int Width, int Height, TArray<byte>& CompressedData, int Level = PNG_COMPRESS_DEFAULT);
 
 #endif // __UNTEXTUREPNG_H__
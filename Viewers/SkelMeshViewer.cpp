@@ -942,7 +942,15 @@ void CSkelMeshViewer::FindUE4Animations()
 	for (int i = 0; i < PackageInfos.Num(); i++)
 	{
 		const CGameFileInfo* info = PackageInfos[i];
+		// Skip packages without animations
+		if (!info->NumAnimations) continue;
+
 		UnPackage* package = info->Package;
+		if (!package && info->IsPackageScanned)
+		{
+			// ScanContent doesn't keep packages loaded, load only packages which has animations
+			package = UnPackage::LoadPackage(info, /*silent=*/ true);
+		}
 		if (!package)
 		{
 			// Shouldn't happen, but happens (ScanPackage() should fill Package for all CGameFileInfo).
@@ -976,11 +984,8 @@ void CSkelMeshViewer::FindUE4Animations()
 
 		if (!found) continue; // this package doesn't use our Skeleton
 
-		// Now, if this package has animation sequence - enqueue it for loading
-		if (PackageInfos[i]->NumAnimations)
-		{
-			packagesToLoad.Add(package);
-		}
+		// This package has animation sequence - enqueue it for loading
+		packagesToLoad.Add(package);
 	}
 
 	// Sort packages by name for easier navigation after loading